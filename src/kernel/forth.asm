@@ -14,8 +14,8 @@
 ;   ESI = Instruction Pointer (IP) - points to next word address
 ;   EBP = Return Stack Pointer (RSP)
 ;   ESP = Data Stack Pointer (PSP)
-;   EAX = Working register / Top of Stack cache
-;   EBX = Working register
+;   EAX = Working register (holds the CFA on entry to a code field)
+;   EBX = Working register; Top of Stack cache in TOS_CACHE builds
 ;   ECX = Working register
 ;   EDX = Working register / I/O
 ;
@@ -27,12 +27,16 @@
 ;   0x00020000 - Return stack (grows down)
 ;   0x00028000 - System variables (STATE, HERE, LATEST, BASE, TIB, TOIN)
 ;   0x00028018 - Block/vocabulary variables (BLK, SCR, search order, etc.)
-;   0x00028060 - Block buffer headers (4 x 12 bytes)
 ;   0x00028100 - Terminal Input Buffer (256 bytes)
-;   0x00028200 - Block buffers (4 x 1024 bytes)
-;   0x00029200 - Guard byte + free space
+;   0x00028200 - Free
+;   0x00029C40 - ATA IDENTIFY buffer (512 bytes) + DMA PRD table
+;   0x0002A000 - Page directory (PAGING-ON only, 4KB)
+;   0x0002B000 - AP start trampoline (AP-TRAMPOLINE copies it here)
+;   0x0002FC00 - Dictionary snapshot header staging (1KB)
 ;   0x00030000 - Dictionary start
+;   0x00080000 - Dictionary hash index (buckets + node pool, 64KB)
 ;   0x000B8000 - VGA text buffer
+;   0x00300000 - Block buffer pool (LRU sentinel, hash, headers, buffers)
 ;
 ; ============================================================================
 
@@ -71,18 +75,39 @@ VAR_FORTH_LATEST    equ 0x28048     ; FORTH vocabulary's own LATEST pointer
 VAR_BLOCK_LOADING   equ 0x2804C     ; Flag: 1 = LOAD just set up a block (skip first exhaustion check)
 
 ; Block buffer management
-BLK_BUF_HEADERS     equ 0x28060     ; 4 headers x 12 bytes = 48 bytes
-                                    ; Each: [block#(4)] [flags(4)] [age(4)]
-                                    ; flags: bit 0=valid, bit 1=dirty
-BLK_BUF_CUR         equ 0x28090     ; Index of current buffer (for UPDATE)
-BLK_BUF_CLOCK        equ 0x28094    ; LRU age counter
+BLK_BUF_CUR         equ 0x28090     ; Header address of current buffer (for UPDATE)
 MEMDISK_BASE         equ 0x28098    ; Physical base of memdisk RAM image (0 = not memdisk)
 BLK_WRITE_VEC        equ 0x2809C    ; XT of active block writer ( buf-addr blk# -- ior )
 BLK_READ_VEC         equ 0x280A0    ; XT of active persistent reader ( buf-addr blk# -- ior )
-BLK_NUM_BUFFERS     equ 4
-BLK_HEADER_SIZE     equ 12
+; Buffer pool (0x300000 - 0x3FFFFF, above the PHYS-ALLOC heap).
+; Each header: [block#] [flags] [hash next] [LRU prev] [LRU next] [data]
+; [2 spare cells]; flags: bit 0=valid, bit 1=dirty, bit 2=read-ahead
+; marker, bit 3=pending. A header is on its hash chain iff block# != -1.
+BLK_LRU             equ 0x300000    ; LRU list sentinel (header-shaped)
+BLK_HASH            equ 0x301000    ; Hash chain heads, block# mod buckets
+BLK_HASH_BUCKETS    equ 1024
+BLK_POOL_HDRS       equ 0x302000    ; BLK_POOL_MAX headers
+BLK_POOL_DATA       equ 0x306000    ; BLK_POOL_MAX buffers - 0x387FFF
+BLK_POOL_MAX        equ 512
+BLK_POOL_MIN        equ 8
+BLK_POOL_DEFAULT    equ 256
+BLK_HEADER_SIZE     equ 32
+BLK_BUF_STRIDE      equ BLOCK_SIZE + 16 ; Gap holds the NUL guard for LOAD
+BLK_HDR_BLOCK       equ 0
+BLK_HDR_FLAGS       equ 4
+BLK_HDR_HNEXT       equ 8
+BLK_HDR_PREV        equ 12
+BLK_HDR_NEXT        equ 16
+BLK_HDR_DATA        equ 20
+; Write-back staging (past the last pool buffer)
+BLK_STAGE           equ 0x388000    ; BLK_RUN_MAX blocks, contiguous for run writers
+BLK_RUN_MAX         equ 32          ; Blocks per run writer call
+BLK_DIRTY_LIST      equ 0x390000    ; BLK_POOL_MAX cells: dirty headers, block order
 BLK_BUF_FLAG_VALID  equ 1
 BLK_BUF_FLAG_DIRTY  equ 2
+BLK_BUF_FLAG_AHEAD  equ 4           ; Last block of a read-ahead window
+BLK_BUF_FLAG_PENDING equ 8          ; Claimed by the transfer in progress
+BLK_RA_MAX          equ 8           ; Read-ahead blocks per transfer (cap)
 BLOCK_SIZE          equ 1024        ; 1KB per Forth block
 
 ; Kernel image size — single source of truth.
@@ -98,15 +123,35 @@ COMBINED_HEADER_SIZE equ (BOOT_SECTOR_SIZE + KERNEL_PADDED_SIZE)
 ; Block 0 starts at this LBA. Block N = BLOCKS_LBA_BASE + N*2.
 BLOCKS_LBA_BASE      equ COMBINED_HEADER_SIZE / BOOT_SECTOR_SIZE
 
-; Block buffer data: 4 x 1024 bytes
-BLK_BUF_DATA        equ 0x28200     ; 0x28200 - 0x291FF
-BLK_BUF_GUARD       equ 0x29200     ; NUL guard byte for LOAD termination
+; Dictionary snapshot (tools/make-snapshot.py). Appended to the combined
+; image after the 2MB blocks disk: header block, then the dictionary image
+; 0x30000-HERE in whole blocks. Taken from a kernel whose hash matches,
+; it replaces the text-blob evaluation at boot.
+SNAP_BLOCK          equ 2048        ; Header block (first block past blocks.img)
+SNAP_HDR_BUF        equ 0x2FC00     ; Header staging; replay text runs from here
+SNAP_MAGIC          equ 0x53464D42  ; 'BMFS'
+SNAP_VERSION        equ 1
+; Header offsets
+SNAP_OFF_HASH       equ 0x08        ; kernel_hash_ of the kernel it came from
+SNAP_OFF_HERE       equ 0x0C
+SNAP_OFF_LATEST     equ 0x10
+SNAP_OFF_BASE       equ 0x14
+SNAP_OFF_SDEPTH     equ 0x18
+SNAP_OFF_SORDER     equ 0x1C        ; 8 cells
+SNAP_OFF_CURRENT    equ 0x3C
+SNAP_OFF_FLATEST    equ 0x40
+SNAP_OFF_WRITE_VEC  equ 0x44
+SNAP_OFF_READ_VEC   equ 0x48
+SNAP_OFF_NBLOCKS    equ 0x4C        ; Dictionary image blocks after the header
+SNAP_OFF_REPLAY     equ 0x50        ; NUL-terminated Forth text run after restore
 
 ; Input buffer
 TIB_START           equ 0x28100     ; Terminal Input Buffer
 TIB_SIZE            equ 256
 
 ; ATA PIO port constants (primary IDE controller)
+ATA_TIMEOUT_US      equ 1000000     ; BSY / DRQ wait, timed on the TSC
+ATA_POLL_CAP        equ 10000000    ; Status polls for the same wait without a TSC
 ATA_DATA            equ 0x1F0
 ATA_ERROR           equ 0x1F1
 ATA_SECCOUNT        equ 0x1F2
@@ -116,6 +161,32 @@ ATA_LBA_HI          equ 0x1F5
 ATA_DRIVE           equ 0x1F6
 ATA_CMD_STATUS      equ 0x1F7
 ATA_CTRL            equ 0x3F6
+ATA_CMD_READ        equ 0x20        ; READ SECTORS (PIO, DRQ per sector)
+ATA_CMD_WRITE       equ 0x30        ; WRITE SECTORS (PIO)
+ATA_CMD_READ_MULTI  equ 0xC4        ; READ MULTIPLE (PIO, DRQ per ata_multi sectors)
+ATA_CMD_SET_MULTI   equ 0xC6        ; SET MULTIPLE MODE
+ATA_CMD_READ_DMA    equ 0xC8        ; READ DMA (bus-master IDE)
+ATA_CMD_FLUSH       equ 0xE7        ; FLUSH CACHE
+ATA_CMD_IDENTIFY    equ 0xEC
+; Bus-master IDE registers, primary channel (offsets from BAR4)
+ATA_BM_CMD          equ 0           ; bit 0 = start, bit 3 = device -> memory
+ATA_BM_STATUS       equ 2           ; bit 0 = active, 1 = error, 2 = interrupt
+ATA_BM_PRD          equ 4           ; Physical Region Descriptor table address
+ATA_IDENT_BUF       equ 0x29C40     ; 512 bytes: IDENTIFY data (probe only)
+ATA_PRD_TABLE       equ 0x29E40     ; 2 x (BLK_RA_MAX + 1) x 8-byte PRD entries
+
+; CMOVE / MOVE / FILL size thresholds (bytes)
+COPY_ERMS_MIN       equ 128         ; rep movsb/stosb from here on ERMSB CPUs
+COPY_SSE_MIN        equ 256         ; SSE2 copy loop from here otherwise
+
+; Optional paging (PAGING-ON): one directory of 4MB identity pages
+PAGE_DIR            equ 0x2A000     ; 1024 PDEs, 4KB aligned
+PDE_4M              equ 0x83        ; Present | RW | PS
+PDE_PAT             equ 0x1000      ; PAT index bit 2 in a 4MB PDE
+CR4_PSE             equ 0x10
+CR0_PG              equ 0x80000000
+IA32_PAT            equ 0x277
+PAT_WC              equ 0x01        ; PA4 = write-combining (default WB)
 
 ; VGA
 VGA_TEXT            equ 0xB8000
@@ -130,6 +201,11 @@ PIC2_CMD            equ 0xA0        ; Slave PIC command port
 PIC2_DATA           equ 0xA1        ; Slave PIC data port
 PIC_EOI             equ 0x20        ; End-of-interrupt command
 
+; TSC calibration (init_tsc): PIT channel 2 one-shot
+PIT_CAL_MS          equ 10
+PIT_CAL_COUNT       equ 11932       ; PIT_CAL_MS at 1193182 Hz
+BOOT_STAMPS         equ 3           ; boot_tsc slots (BOOT-US)
+
 ; IDT (Interrupt Descriptor Table)
 IDT_BASE            equ 0x29400     ; 256 entries x 8 bytes = 2048 bytes (0x29400-0x29BFF)
 IDT_ENTRIES         equ 256
@@ -138,6 +214,22 @@ IDT_ENTRY_SIZE      equ 8
 ; ISR hook table (16 cells for future Forth-level IRQ hooks)
 ISR_HOOK_TABLE      equ 0x29C00     ; 16 x 4 bytes = 64 bytes
 
+; MSI hook table (MSI-CONNECT in HARDWARE): vector MSI_VEC_BASE + n runs
+; slot n, then EOIs the local APIC
+MSI_HOOK_TABLE      equ 0x29F00     ; MSI_SLOTS x 4 bytes
+MSI_VEC_BASE        equ 0x40
+MSI_SLOTS           equ 8
+
+; COM1 console rings (isr_serial): free-running head/tail counters,
+; sizes are powers of two
+COM1_IRQ            equ 4
+SER_TX_RING         equ 0x2C000     ; SER_TX_SIZE bytes, EMIT -> THR
+SER_TX_SIZE         equ 4096
+SER_RX_RING         equ 0x2D000     ; SER_RX_SIZE bytes, RBR -> KEY
+SER_RX_SIZE         equ 1024
+ISR_FX_SAVE         equ 0x2D400     ; 512 bytes: FXSAVE area for isr_run_xt
+SER_FIFO            equ 16          ; 16550 transmit FIFO depth
+
 ; IRQ vector offsets (remapped)
 IRQ_BASE_MASTER     equ 0x20        ; IRQ 0-7 -> INT 0x20-0x27
 IRQ_BASE_SLAVE      equ 0x28        ; IRQ 8-15 -> INT 0x28-0x2F
@@ -147,27 +239,160 @@ IRQ_BASE_SLAVE      equ 0x28        ; IRQ 8-15 -> INT 0x28-0x2F
 ; Keyboard ring buffer
 KB_RING_SIZE        equ 16          ; 16-byte ring buffer
 
+; Dictionary hash index (find_ fast path, maintained by create_)
+; Bucket = hash(name, vocab LATEST cell); each node is
+; [next:4][header:4][vocab cell:4], newest definition first in its chain.
+DICT_HASH_BUCKETS   equ 0x80000     ; 1024 bucket heads x 4 bytes
+DICT_HASH_NBUCKETS  equ 1024        ; Power of 2 for masking
+DICT_HASH_NODES     equ 0x81000     ; Node pool (0x81000 - 0x8FEFF)
+DICT_HASH_NODE_SZ   equ 12
+DICT_HASH_MAX_NODES equ (0x8FF00 - DICT_HASH_NODES) / DICT_HASH_NODE_SZ
+DICT_HASH_VOCABS    equ 0x8FF00     ; Rebuild worklist: 64 vocab LATEST cells
+DICT_HASH_MAX_VOCABS equ 64
+
 ; Word flags
 F_IMMEDIATE         equ 0x80        ; Immediate word
 F_HIDDEN            equ 0x40        ; Hidden from FIND
 F_LENMASK           equ 0x3F        ; Length mask
 
-; ECHOPORT trace buffer
-TRACE_BUF_SIZE      equ 256         ; 256 entries (power of 2 for masking)
-TRACE_ENTRY_SZ      equ 12          ; 12 bytes per entry
-; Entry: [type:1][pad:1][port:2][value:4][caller:4]
+; ECHOPORT trace ring. trace_buf is the boot ring; TRACE-RING! moves it
+; (ECHOPORT puts a larger one in the physical pool).
+TRACE_BUF_SIZE      equ 256         ; Boot ring entries (power of 2 for masking)
+TRACE_ENTRY_SZ      equ 16          ; 16 bytes per entry
+TRACE_FILTERS       equ 8           ; Port ranges in trace_filt
+; Entry: [type:1][pad:1][port:2][value:4][caller:4][tsc:4]
 ; Types: 0=INB 1=OUTB 2=INW 3=OUTW 4=INL 5=OUTL
+;        6=INSB 7=OUTSB 8=INSW 9=OUTSW 10=INSD 11=OUTSD (value = count)
 ; caller = ESI (Forth IP) at time of I/O — points into calling word
+; tsc = low 32 bits of the TSC (0 without one)
+
+; Profiler. The IRQ0 sampler is in every build; -DPROFILE also makes NEXT
+; count every thread fetch per XT (prof_next).
+PROF_RING           equ 0x391000    ; Sample ring (past the block layer's lists)
+PROF_RING_SIZE      equ 1024        ; Samples (power of 2 for masking)
+PROF_ENTRY_SZ       equ 8           ; Entry: [ESI (Forth IP):4][EIP:4]
+PROF_COUNTS         equ 0x400000    ; -DPROFILE: one counter cell per XT address
+PROF_XT_LIMIT       equ 0x80000     ; XTs counted: below the dictionary hash index
+%ifdef PROFILE
+PROF_FLAG           equ -1
+%else
+PROF_FLAG           equ 0
+%endif
+
+; Net console (UDP mirror of print_char). Characters go straight into the
+; current TX slot behind the 42-byte header, so a frame is never copied.
+; The driver provides NET-TX-N buffers of NET_TX_STRIDE bytes at NET-TX-BUF
+; and picks the hand-off with NET-TX-KIND: the RTL8168 sets NET-TX-N
+; descriptors at NET-TX-DESC (16 bytes each, MMIO at NET-RTL-BASE); the
+; RTL8139 uses its four TSAD/TSD register pairs (I/O at NET-RTL-BASE).
+NET_HDR_SIZE        equ 42          ; Ethernet + IPv4 + UDP
+NET_TX_SLOTS        equ 4           ; Most descriptors net_flush rotates over
+NET_TX_STRIDE       equ 0x600       ; Bytes per TX buffer slot
+NET_CON_LIMIT       equ 1472        ; Payload cap (1514-byte frame)
+NET_CON_TICKS       equ 2           ; Age (PIT ticks) that forces a flush
+NET_DESC_OWN        equ 0x80000000
+NET_DESC_EOR        equ 0x40000000
+NET_DESC_FS_LS      equ 0x30000000
+NET_KIND_8168       equ 0           ; Descriptor ring in memory
+NET_KIND_8139       equ 1           ; TSAD n / TSD n registers, 4 slots in order
+RTL8139_TSD0        equ 0x10
+RTL8139_TSAD0       equ 0x20
+RTL8139_TSD_OWN     equ 0x2000      ; Set by the chip once the buffer is read
+
+; Peephole superinstructions (peep_fuse_)
+PEEP_DEPTH          equ 4           ; Compiled items remembered for fusing
+PEEP_RULE_SIZE      equ 20          ; first, second, third, fused, operand
 
 ; ============================================================================
 ; Threaded Code Interpreter Macros
 ; ============================================================================
 
+; Top-of-stack cache (build with -DTOS_CACHE)
+; EBX holds the top data stack item across NEXT; the rest of the stack is
+; in memory at ESP. Primitives written for the cache use DEFTOS and leave
+; through TNEXT. Every other DEFCODE word SPILLs EBX on entry and NEXT
+; FILLs it on exit, so plain memory-stack code keeps working unchanged.
+; An empty stack still has a (junk) TOS, so a spilled empty stack has one
+; cell below its top: depth arithmetic subtracts TOS_SLOT (stack_s0_).
+; Anything that jumps through a code field from spilled code must FILL
+; first (INTERPRET, USING); asm re-entry points must SPILL (exec_xt_resume).
+%ifdef TOS_CACHE
+TOS_SLOT            equ 4
+TOS_FLAG            equ -1
+%else
+TOS_SLOT            equ 0
+TOS_FLAG            equ 0
+%endif
+
+; Cooperative tasks: task control block (TASKS vocabulary allocates them)
+TCB_NEXT            equ 0x00        ; Next TCB in the round-robin ring
+TCB_SP              equ 0x04        ; Saved ESP (pushad frame, EFLAGS, return)
+TCB_STATE           equ 0x08        ; TASK_READY / TASK_SLEEP / TASK_STOP
+TCB_WAKE            equ 0x0C        ; TICK-COUNT a sleeper becomes ready at
+TCB_S0              equ 0x10        ; Data stack top
+TCB_R0              equ 0x14        ; Return stack top
+TCB_IP0             equ 0x18        ; Start thread: [xt][TASK-DONE]
+TCB_SIZE            equ 0x20
+TASK_READY          equ 0
+TASK_SLEEP          equ 1
+TASK_STOP           equ 2
+TASK_FRAME          equ 32 + 4 + 4 + TOS_SLOT   ; pushad, EFLAGS, return, FILL cell
+
+; SMP: one block per CPU in cpu_table (CPU 0 = the BSP). APs start in a
+; real-mode trampoline copied to AP_BOOT (SIPI vector AP_BOOT >> 12).
+AP_BOOT             equ 0x2B000     ; 4KB aligned, below 1MB
+CPU_MAX             equ 8
+PCPU_NUM            equ 0x00        ; CPU number (index in cpu_table)
+PCPU_APIC           equ 0x04        ; Local APIC ID
+PCPU_STATE          equ 0x08        ; CPU_ABSENT / CPU_IDLE / CPU_RUN
+PCPU_S0             equ 0x0C        ; Data stack top
+PCPU_R0             equ 0x10        ; Return stack top
+PCPU_XT             equ 0x14        ; Next xt for an idle AP, 0 = none
+PCPU_IP0            equ 0x18        ; Start thread: [xt][CPU-PARK]
+PCPU_USER           equ 0x20        ; 8 cells of per-CPU variables
+PCPU_SIZE           equ 0x40
+CPU_ABSENT          equ 0
+CPU_IDLE            equ 1
+CPU_RUN             equ 2
+LAPIC_ID            equ 0x20        ; Local APIC ID register (ID in bits 24-31)
+LAPIC_EOI           equ 0xB0        ; Local APIC end-of-interrupt register
+
 ; NEXT - Fetch next word and execute
 ; This is the heart of the Forth engine
 %macro NEXT 0
+%ifdef TOS_CACHE
+    pop ebx                 ; FILL: reload cached TOS
+%endif
+%ifdef PROFILE
+    jmp prof_next           ; Counting NEXT (one copy, keeps the kernel small)
+%else
     lodsd                   ; Load [ESI] into EAX, increment ESI
     jmp [eax]               ; Jump to code field
+%endif
+%endmacro
+
+; TNEXT - NEXT for code that already has TOS in EBX (same as NEXT
+; unless TOS_CACHE)
+%macro TNEXT 0
+%ifdef PROFILE
+    jmp prof_next
+%else
+    lodsd
+    jmp [eax]
+%endif
+%endmacro
+
+; SPILL / FILL - Move the cached TOS to / from the memory stack
+%macro SPILL 0
+%ifdef TOS_CACHE
+    push ebx
+%endif
+%endmacro
+
+%macro FILL 0
+%ifdef TOS_CACHE
+    pop ebx
+%endif
 %endmacro
 
 ; PUSHRSP - Push to return stack
@@ -182,28 +407,14 @@ TRACE_ENTRY_SZ      equ 12          ; 12 bytes per entry
     add ebp, 4
 %endmacro
 
-; TRACE_PORT - Log a port I/O operation to trace ring buffer
-; %1 = type byte (0-5), expects port in DX, value in EAX, caller in ESI
+; TRACE_PORT - Log a port I/O operation to the trace ring (trace_log_)
+; %1 = type byte (0-11), expects port in DX, value in EAX, caller in ESI
+; Preserves all registers.
 %macro TRACE_PORT 1
     cmp byte [trace_enabled], 0
     je %%skip
-    push edi
-    push ebx
-    mov edi, [trace_head]
-    mov ebx, edi
-    and ebx, (TRACE_BUF_SIZE - 1)
-    imul ebx, TRACE_ENTRY_SZ
-    add ebx, trace_buf
-    mov byte [ebx], %1             ; type
-    mov byte [ebx+1], 0            ; pad
-    mov [ebx+2], dx                ; port
-    mov [ebx+4], eax               ; value
-    mov [ebx+8], esi               ; caller (Forth IP)
-    inc edi
-    mov [trace_head], edi
-    inc dword [trace_count]
-    pop ebx
-    pop edi
+    push %1
+    call trace_log_
 %%skip:
 %endmacro
 
@@ -234,8 +445,6 @@ kernel_start:
     mov dword [VAR_BLK], 0
     mov dword [VAR_SCR], 0
     mov dword [VAR_BLOCK_LOADING], 0
-    mov dword [BLK_BUF_CUR], 0
-    mov dword [BLK_BUF_CLOCK], 0
     ; MEMDISK_BASE is set by bootloader if memdisk detected; default 0
     ; (bootloader writes it before PM switch, kernel just reads it)
     ; Block write vector: default = ATA PIO writer. On memdisk boot there
@@ -255,17 +464,17 @@ kernel_start:
     je .read_vec_done
     mov dword [BLK_READ_VEC], BLKREADNONE
 .read_vec_done:
-    ; Clear all 4 buffer headers (block#=-1, flags=0, age=0)
-    mov edi, BLK_BUF_HEADERS
-    mov ecx, BLK_NUM_BUFFERS
-.init_buf_headers:
-    mov dword [edi], 0xFFFFFFFF     ; block# = -1 (invalid)
-    mov dword [edi + 4], 0          ; flags = 0
-    mov dword [edi + 8], 0          ; age = 0
-    add edi, BLK_HEADER_SIZE
-    loop .init_buf_headers
-    ; NUL guard byte after block buffers (for LOAD termination)
-    mov byte [BLK_BUF_GUARD], 0
+    ; Empty buffer pool at the default size
+    mov ecx, BLK_POOL_DEFAULT
+    call blk_pool_init_
+
+%ifdef PROFILE
+    ; Per-XT counters start at zero (RAM above 4MB is not cleared for us)
+    mov edi, PROF_COUNTS
+    mov ecx, PROF_XT_LIMIT / 4
+    xor eax, eax
+    rep stosd
+%endif
 
     ; Initialize vocabulary / search order
     mov dword [VAR_FORTH_LATEST], name_BLOCKS_LBA_BASE_CONST ; FORTH vocab starts same as LATEST
@@ -273,6 +482,16 @@ kernel_start:
     mov dword [VAR_SEARCH_ORDER], VAR_FORTH_LATEST  ; Addr of FORTH's LATEST cell
     mov dword [VAR_CURRENT], VAR_FORTH_LATEST       ; New defs go into FORTH
 
+    ; Index the kernel's FORTH chain for find_
+    call dict_hash_rebuild
+
+    ; SSE2 for the framebuffer fills and copies, if the CPU has it
+    call init_sse
+    call init_erms
+    call init_tsc                   ; PIT channel 2, interrupts still off
+    xor eax, eax
+    call boot_stamp_                ; BOOT-US origin
+
     ; Initialize interrupt infrastructure (BEFORE sti)
     call init_pic                   ; Remap PIC, mask all IRQs
     call init_idt                   ; Build IDT, load IDTR
@@ -336,14 +555,32 @@ kernel_start:
     dec ecx
     jnz .drain_serial
 .no_serial_drain:
+    call serial_irq_init_           ; COM1 on IRQ4 from here on
 
     ; Print welcome message
     mov esi, msg_welcome
     call print_string
 
+    mov eax, 1
+    call boot_stamp_                ; Dictionary build starts
+
+    ; A snapshot taken from this exact kernel replaces the text blob;
+    ; only its replay text (load-time hardware probes) is evaluated
+    call snap_restore_
+    jc .text_boot
+    mov dword [snap_booted], -1
+    mov eax, SNAP_HDR_BUF + SNAP_OFF_REPLAY
+    cmp byte [eax], 0
+    je .no_embedded
+    jmp .eval_source
+
+.text_boot:
     ; Check for embedded vocabularies to evaluate at boot
     cmp dword [embed_size], 0
     je .no_embedded
+    mov eax, embed_data
+
+.eval_source:
 
     ; Push return frame on Forth return stack (LIFO order matching block_exhausted pop)
     ; block_exhausted pops: TIB, TOIN, BLK, ESI
@@ -356,16 +593,16 @@ kernel_start:
     sub ebp, 4
     mov dword [ebp], TIB_START      ; TIB: restore to serial input buffer
 
-    ; Redirect interpreter to embedded source
-    mov dword [VAR_TIB], embed_data
+    ; Redirect interpreter to embedded source (EAX)
+    mov dword [VAR_TIB], eax
     mov dword [VAR_TOIN], 0
     mov dword [VAR_BLK], 1          ; Nonzero: prevents interactive read_line
     mov dword [VAR_BLOCK_LOADING], 1 ; Skip first exhaustion check
 
 .no_embedded:
-    ; Enter main interpreter loop
+    ; Enter main interpreter loop (empty stack: EBX is the junk TOS)
     mov esi, cold_start
-    NEXT
+    TNEXT
 
 ; ============================================================================
 ; Dictionary Header Macro
@@ -409,9 +646,28 @@ name_%2:
 %2:
     dd code_%2              ; Code field points to native code
 code_%2:
+    SPILL                   ; TOS_CACHE: body sees the whole stack in memory
     ; Native code follows
 %endmacro
 
+%macro DEFTOS 3
+    ; DEFCODE for primitives written against the TOS cache: no SPILL,
+    ; EBX is TOS on entry and exit, leave with TNEXT. Only used inside
+    ; %ifdef TOS_CACHE, next to the plain DEFCODE version.
+    align 4
+name_%2:
+    dd link
+    %define link name_%2
+    db %3 + %%end_name - %%start_name
+%%start_name:
+    db %1
+%%end_name:
+    align 4
+%2:
+    dd code_%2
+code_%2:
+%endmacro
+
 %macro DEFVAR 3
     ; %1 = name string, %2 = label, %3 = address of variable
     ; Variable storage is at the EQU address, initialized by kernel_start
@@ -427,8 +683,14 @@ name_%2:
 %2:
     dd code_%2
 code_%2:
+%ifdef TOS_CACHE
+    push ebx
+    mov ebx, %3
+    TNEXT
+%else
     push %3
     NEXT
+%endif
 %endmacro
 
 %macro DEFCONST 3
@@ -445,8 +707,14 @@ name_%2:
 %2:
     dd code_%2
 code_%2:
+%ifdef TOS_CACHE
+    push ebx
+    mov ebx, %3
+    TNEXT
+%else
     push %3
     NEXT
+%endif
 %endmacro
 
 ; ============================================================================
@@ -459,13 +727,27 @@ DOCOL:
     PUSHRSP esi             ; Save return address
     add eax, 4              ; Skip code field
     mov esi, eax            ; Set IP to parameter field
-    NEXT
+    TNEXT                   ; No stack effect: TOS stays cached
+
+%ifdef PROFILE
+; prof_next - Counting NEXT: bump PROF_COUNTS[xt], then dispatch
+; Every NEXT/TNEXT jumps here in a PROFILE build. EXECUTE and native code
+; dispatch directly, so only thread fetches are counted.
+prof_next:
+    lodsd
+    cmp eax, PROF_XT_LIMIT
+    jae .dispatch
+    inc dword [PROF_COUNTS + eax]
+.dispatch:
+    jmp [eax]
+%endif
 
 ; ============================================================================
 ; Dictionary - Initialize link
 ; ============================================================================
 
-    link dd 0               ; Start of linked list
+dict_origin:
+    link dd 0               ; Start of linked list (chain sentinel)
 
 ; ============================================================================
 ; Primitive Words
@@ -473,6 +755,89 @@ DOCOL:
 
 ; --- Stack Manipulation ---
 
+%ifdef TOS_CACHE
+DEFTOS "DROP", DROP, 0
+    pop ebx
+    TNEXT
+
+DEFTOS "DUP", DUP, 0
+    push ebx
+    TNEXT
+
+DEFTOS "SWAP", SWAP, 0
+    mov eax, [esp]
+    mov [esp], ebx
+    mov ebx, eax
+    TNEXT
+
+DEFTOS "OVER", OVER, 0
+    push ebx
+    mov ebx, [esp + 4]
+    TNEXT
+
+DEFTOS "ROT", ROT, 0
+    mov eax, [esp + 4]      ; ( a b c -- b c a )  EAX = a
+    mov ecx, [esp]          ; ECX = b
+    mov [esp + 4], ecx
+    mov [esp], ebx
+    mov ebx, eax
+    TNEXT
+
+DEFTOS "-ROT", NROT, 0
+    mov eax, [esp + 4]      ; ( a b c -- c a b )  EAX = a
+    mov ecx, [esp]          ; ECX = b
+    mov [esp + 4], ebx
+    mov [esp], eax
+    mov ebx, ecx
+    TNEXT
+
+DEFTOS "2DROP", TWODROP, 0
+    add esp, 4
+    pop ebx
+    TNEXT
+
+DEFTOS "2DUP", TWODUP, 0
+    mov eax, [esp]
+    push ebx
+    push eax
+    TNEXT
+
+DEFCODE "2SWAP", TWOSWAP, 0
+    pop eax                 ; ( a b c d -- c d a b )
+    pop ebx
+    pop ecx
+    pop edx
+    push ebx
+    push eax
+    push edx
+    push ecx
+    NEXT
+
+DEFCODE "2OVER", TWOOVER, 0
+    mov eax, [esp + 12]         ; ( a b c d -- a b c d a b )
+    mov ebx, [esp + 8]
+    push ebx
+    push eax
+    NEXT
+
+DEFTOS "?DUP", QDUP, 0
+    test ebx, ebx
+    jz .skip
+    push ebx
+.skip:
+    TNEXT
+
+DEFTOS "NIP", NIP, 0
+    add esp, 4
+    TNEXT
+
+DEFTOS "TUCK", TUCK, 0
+    pop eax                 ; ( a b -- b a b )
+    push ebx
+    push eax
+    TNEXT
+
+%else
 DEFCODE "DROP", DROP, 0
     pop eax                 ; Discard TOS
     NEXT
@@ -564,6 +929,8 @@ DEFCODE "TUCK", TUCK, 0
     push eax
     NEXT
 
+%endif
+
 DEFCODE "PICK", PICK, 0
     pop eax                 ; n
     mov eax, [esp + eax*4]
@@ -572,6 +939,27 @@ DEFCODE "PICK", PICK, 0
 
 ; --- Return Stack ---
 
+%ifdef TOS_CACHE
+DEFTOS ">R", TOR, 0
+    PUSHRSP ebx
+    pop ebx
+    TNEXT
+
+DEFTOS "R>", FROMR, 0
+    push ebx
+    POPRSP ebx
+    TNEXT
+
+DEFTOS "R@", RFETCH, 0
+    push ebx
+    mov ebx, [ebp]
+    TNEXT
+
+DEFTOS "RDROP", RDROP, 0
+    add ebp, 4
+    TNEXT
+
+%else
 DEFCODE ">R", TOR, 0
     pop eax
     PUSHRSP eax
@@ -591,8 +979,23 @@ DEFCODE "RDROP", RDROP, 0
     add ebp, 4
     NEXT
 
+%endif
+
 ; --- Arithmetic ---
 
+%ifdef TOS_CACHE
+DEFTOS "+", ADD, 0
+    pop eax
+    add ebx, eax
+    TNEXT
+
+DEFTOS "-", SUB, 0
+    pop eax
+    sub eax, ebx
+    mov ebx, eax
+    TNEXT
+
+%else
 DEFCODE "+", ADD, 0
     pop eax
     add [esp], eax
@@ -603,6 +1006,8 @@ DEFCODE "-", SUB, 0
     sub [esp], eax
     NEXT
 
+%endif
+
 DEFCODE "*", MUL, 0
     pop eax
     pop ebx
@@ -723,6 +1128,36 @@ DEFCODE "/MOD", DIVMOD, 0
     push 0x7FFFFFFF
     NEXT
 
+%ifdef TOS_CACHE
+DEFTOS "1+", INCR, 0
+    inc ebx
+    TNEXT
+
+DEFTOS "1-", DECR, 0
+    dec ebx
+    TNEXT
+
+DEFTOS "2+", INCR2, 0
+    add ebx, 2
+    TNEXT
+
+DEFTOS "2-", DECR2, 0
+    sub ebx, 2
+    TNEXT
+
+DEFTOS "4+", INCR4, 0
+    add ebx, 4
+    TNEXT
+
+DEFTOS "4-", DECR4, 0
+    sub ebx, 4
+    TNEXT
+
+DEFTOS "NEGATE", NEGATE, 0
+    neg ebx
+    TNEXT
+
+%else
 DEFCODE "1+", INCR, 0
     inc dword [esp]
     NEXT
@@ -751,6 +1186,8 @@ DEFCODE "NEGATE", NEGATE, 0
     neg dword [esp]
     NEXT
 
+%endif
+
 DEFCODE "ABS", FABS, 0
     mov eax, [esp]
     test eax, eax
@@ -784,6 +1221,57 @@ DEFCODE "MAX", MAX, 0
 
 ; --- Comparison ---
 
+%ifdef TOS_CACHE
+; ( a b -- flag ) with b cached: flag = a <cc> b
+%macro TOS_CMP 1
+    pop eax
+    cmp eax, ebx
+    set%1 bl
+    movzx ebx, bl
+    neg ebx                 ; 0 -> 0, 1 -> -1 (true)
+    TNEXT
+%endmacro
+
+; ( n -- flag ): flag = n <cc> 0
+%macro TOS_ZCMP 1
+    test ebx, ebx
+    set%1 bl
+    movzx ebx, bl
+    neg ebx
+    TNEXT
+%endmacro
+
+DEFTOS "=", EQU, 0
+    TOS_CMP e
+
+DEFTOS "<>", NEQU, 0
+    TOS_CMP ne
+
+DEFTOS "<", LT, 0
+    TOS_CMP l
+
+DEFTOS ">", GT, 0
+    TOS_CMP g
+
+DEFTOS "<=", LE, 0
+    TOS_CMP le
+
+DEFTOS ">=", GE, 0
+    TOS_CMP ge
+
+DEFTOS "0=", ZEQU, 0
+    TOS_ZCMP z
+
+DEFTOS "0<", ZLT, 0
+    TOS_ZCMP s
+
+DEFTOS "0>", ZGT, 0
+    TOS_ZCMP g
+
+DEFTOS "0<>", ZNEQU, 0
+    TOS_ZCMP nz
+
+%else
 DEFCODE "=", EQU, 0
     pop eax
     pop ebx
@@ -880,8 +1368,43 @@ DEFCODE "0<>", ZNEQU, 0
     push eax
     NEXT
 
+%endif
+
 ; --- Logic ---
 
+%ifdef TOS_CACHE
+DEFTOS "AND", AND, 0
+    pop eax
+    and ebx, eax
+    TNEXT
+
+DEFTOS "OR", OR, 0
+    pop eax
+    or ebx, eax
+    TNEXT
+
+DEFTOS "XOR", XOR, 0
+    pop eax
+    xor ebx, eax
+    TNEXT
+
+DEFTOS "INVERT", INVERT, 0
+    not ebx
+    TNEXT
+
+DEFTOS "LSHIFT", LSHIFT, 0
+    mov ecx, ebx
+    pop ebx
+    shl ebx, cl
+    TNEXT
+
+DEFTOS "RSHIFT", RSHIFT, 0
+    mov ecx, ebx
+    pop ebx
+    shr ebx, cl
+    TNEXT
+
+%else
 DEFCODE "AND", AND, 0
     pop eax
     and [esp], eax
@@ -911,8 +1434,54 @@ DEFCODE "RSHIFT", RSHIFT, 0
     shr dword [esp], cl
     NEXT
 
+%endif
+
 ; --- Memory Access (The Dangerous Stuff!) ---
 
+%ifdef TOS_CACHE
+DEFTOS "@", FETCH, 0
+    mov ebx, [ebx]
+    TNEXT
+
+DEFTOS "!", STORE, 0
+    pop eax                 ; Value (EBX = address)
+    mov [ebx], eax
+    pop ebx
+    TNEXT
+
+DEFTOS "+!", ADDSTORE, 0
+    pop eax
+    add [ebx], eax
+    pop ebx
+    TNEXT
+
+DEFTOS "-!", SUBSTORE, 0
+    pop eax
+    sub [ebx], eax
+    pop ebx
+    TNEXT
+
+DEFTOS "C@", CFETCH, 0
+    movzx ebx, byte [ebx]
+    TNEXT
+
+DEFTOS "C!", CSTORE, 0
+    pop eax
+    mov [ebx], al
+    pop ebx
+    TNEXT
+
+DEFTOS "W@", WFETCH, 0      ; Word (16-bit) fetch
+    movzx ebx, word [ebx]
+    TNEXT
+
+DEFTOS "W!", WSTORE, 0      ; Word (16-bit) store
+    pop eax
+    mov [ebx], ax
+    pop ebx
+    TNEXT
+
+%else
 DEFCODE "@", FETCH, 0
     pop eax
     mov eax, [eax]
@@ -961,13 +1530,17 @@ DEFCODE "W!", WSTORE, 0     ; Word (16-bit) store
     mov [ebx], ax
     NEXT
 
-; Block memory operations
+%endif
+
+; Block memory operations. copy_fwd, copy_back and fill_bytes pick a
+; path by size: rep movsb/stosb on ERMSB CPUs, SSE2 64-byte runs (copies
+; only), else dwords between a byte head and tail.
 DEFCODE "CMOVE", CMOVE, 0   ; ( src dst count -- )
     PUSHRSP esi             ; Save Forth IP
     pop ecx                 ; Count
     pop edi                 ; Destination
     pop esi                 ; Source
-    rep movsb
+    call copy_fwd
     POPRSP esi              ; Restore Forth IP
     NEXT
 
@@ -976,69 +1549,536 @@ DEFCODE "CMOVE>", CMOVEUP, 0  ; Move from high addresses down
     pop ecx
     pop edi
     pop esi
-    add esi, ecx
-    dec esi
-    add edi, ecx
-    dec edi
-    std
-    rep movsb
-    cld
+    call copy_back
     POPRSP esi              ; Restore Forth IP
     NEXT
 
 DEFCODE "FILL", FILL, 0     ; ( addr count byte -- )
     pop eax                 ; Byte
     pop ecx                 ; Count
-    pop edi                 ; Address (EDI doesn't affect Forth IP, but save for consistency)
-    rep stosb
+    pop edi                 ; Address
+    call fill_bytes
     NEXT
 
-; --- Direct I/O Port Access (Ring 0 only!) ---
-
-DEFCODE "INB", INB, 0       ; ( port -- byte )
-    pop edx
-    xor eax, eax
-    in al, dx
-    TRACE_PORT 0                ; type=INB, port=DX, val=EAX
-    push eax
+; CELL-FILL - ( addr count cell -- ) Store cell into count cells
+DEFCODE "CELL-FILL", CELL_FILL, 0
+    pop eax
+    pop ecx
+    pop edi
+    call fill_cells
     NEXT
 
-DEFCODE "INW", INW, 0       ; ( port -- word )
-    pop edx
-    xor eax, eax
-    in ax, dx
-    TRACE_PORT 2                ; type=INW
-    push eax
+DEFCODE "ERMS?", ERMSQ, 0   ; ( -- flag ) True if rep movsb/stosb are fast strings
+    push dword [erms_ok]
     NEXT
 
-DEFCODE "INL", INL, 0       ; ( port -- dword )
-    pop edx
-    in eax, dx
-    TRACE_PORT 4                ; type=INL
-    push eax
+; --- Framebuffer primitives (32-bit pixels, pitch in bytes) ---
+; Fills use SSE2 non-temporal stores (fill_cells_nt) when init_sse
+; enabled them; ordinary FILL and CELL-FILL keep the cache.
+
+DEFCODE "SSE2?", SSE2Q, 0   ; ( -- flag ) True if SSE2 stores are in use
+    push dword [sse2_ok]
     NEXT
 
-DEFCODE "OUTB", OUTB, 0     ; ( byte port -- )
-    pop edx
+DEFCODE "LFB-FILL", LFB_FILL, 0 ; ( addr cells color -- )
     pop eax
-    TRACE_PORT 1                ; type=OUTB, before write
-    out dx, al
+    pop ecx
+    pop edi
+    call fill_cells_nt
     NEXT
 
-DEFCODE "OUTW", OUTW, 0     ; ( word port -- )
-    pop edx
-    pop eax
-    TRACE_PORT 3                ; type=OUTW
-    out dx, ax
+DEFCODE "LFB-RECT", LFB_RECT, 0 ; ( addr pitch w h color -- )
+    PUSHRSP esi
+    pop eax                 ; Color
+    pop edx                 ; Rows
+    pop esi                 ; Cells per row
+    pop ebx                 ; Pitch
+    pop edi                 ; Top-left
+    test edx, edx
+    jz .lr_done
+.lr_row:
+    push edi
+    mov ecx, esi
+    call fill_cells_nt
+    pop edi
+    add edi, ebx
+    dec edx
+    jnz .lr_row
+.lr_done:
+    POPRSP esi
     NEXT
 
-DEFCODE "OUTL", OUTL, 0     ; ( dword port -- )
-    pop edx
-    pop eax
+; Copy h rows of w cells. When dst is above src the rows go bottom-up,
+; so a vertical scroll may overlap itself.
+DEFCODE "LFB-BLIT", LFB_BLIT, 0 ; ( src spitch dst dpitch w h -- )
+    PUSHRSP esi
+    pop edx                 ; Rows
+    pop eax                 ; Cells per row
+    pop ebx                 ; Destination pitch
+    pop edi                 ; Destination
+    mov esi, [esp + 4]      ; Source; source pitch stays at [esp]
+    test edx, edx
+    jz .lb_done
+    cmp edi, esi
+    jbe .lb_row
+    lea ecx, [edx - 1]
+    imul ecx, [esp]
+    add esi, ecx
+    lea ecx, [edx - 1]
+    imul ecx, ebx
+    add edi, ecx
+    neg ebx
+    neg dword [esp]
+.lb_row:
+    push esi
+    push edi
+    mov ecx, eax
+    rep movsd
+    pop edi
+    pop esi
+    add edi, ebx
+    add esi, [esp]
+    dec edx
+    jnz .lb_row
+.lb_done:
+    add esp, 8
+    POPRSP esi
+    NEXT
+
+; Draw an 8-pixel-wide glyph: one byte per row, MSB leftmost.
+; bg = -1 leaves background pixels untouched.
+DEFCODE "LFB-GLYPH", LFB_GLYPH, 0 ; ( bits dst pitch h fg bg -- )
+    PUSHRSP esi
+    mov esi, [esp + 20]     ; Glyph rows
+    mov edi, [esp + 16]     ; Top-left pixel
+    mov ecx, [esp + 8]      ; Rows
+    jecxz .lg_done
+.lg_row:
+    movzx edx, byte [esi]
+    inc esi
+    shl edx, 24             ; Leftmost pixel in bit 31
+    xor ebx, ebx
+.lg_px:
+    mov eax, [esp + 4]      ; fg
+    test edx, edx
+    js .lg_put
+    mov eax, [esp]          ; bg
+    cmp eax, -1
+    je .lg_skip
+.lg_put:
+    mov [edi + ebx*4], eax
+.lg_skip:
+    shl edx, 1
+    inc ebx
+    cmp ebx, 8
+    jb .lg_px
+    add edi, [esp + 12]
+    dec ecx
+    jnz .lg_row
+.lg_done:
+    add esp, 24
+    POPRSP esi
+    NEXT
+
+; fill_cells - Store EAX into ECX cells at EDI (EDI advanced, ECX = 0)
+fill_cells:
+    cld
+    rep stosd
+    ret
+
+; fill_cells_nt - fill_cells for the framebuffer: 16+ cells at a
+; 4-aligned address go out as 64-byte runs of movntdq once EDI is
+; 16-aligned, bypassing the cache. XMM0 clobbered.
+fill_cells_nt:
+    cld
+    cmp ecx, 16
+    jb .fc_tail
+    cmp dword [sse2_ok], 0
+    je .fc_tail
+    test edi, 3
+    jnz .fc_tail
+.fc_align:
+    test edi, 15
+    jz .fc_wide
+    stosd
+    dec ecx
+    jmp .fc_align
+.fc_wide:
+    push edx
+    mov edx, ecx
+    shr edx, 4
+    jz .fc_narrow
+    movd xmm0, eax
+    pshufd xmm0, xmm0, 0
+.fc_run:
+    movntdq [edi], xmm0
+    movntdq [edi + 16], xmm0
+    movntdq [edi + 32], xmm0
+    movntdq [edi + 48], xmm0
+    add edi, 64
+    dec edx
+    jnz .fc_run
+    sfence
+    and ecx, 15
+.fc_narrow:
+    pop edx
+.fc_tail:
+    rep stosd
+    ret
+
+; fill_bytes - Store AL into ECX bytes at EDI (EDI advanced). From 16
+; bytes on, a byte head aligns EDI and fill_cells stores the middle;
+; ERMSB CPUs take rep stosb for COPY_ERMS_MIN and up. EAX, ECX clobbered.
+fill_bytes:
+    cld
+    cmp ecx, 16
+    jb .fb_bytes
+    movzx eax, al
+    imul eax, eax, 0x01010101
+    cmp ecx, COPY_ERMS_MIN
+    jb .fb_head
+    cmp dword [erms_ok], 0
+    jne .fb_bytes
+.fb_head:
+    test edi, 3
+    jz .fb_cells
+    stosb
+    dec ecx
+    jmp .fb_head
+.fb_cells:
+    push edx
+    mov edx, ecx
+    shr ecx, 2
+    call fill_cells
+    mov ecx, edx
+    and ecx, 3
+    pop edx
+.fb_bytes:
+    rep stosb
+    ret
+
+; copy_fwd - Copy ECX bytes from ESI to EDI, lowest first (ESI, EDI
+; advanced). A destination inside the source stays bytewise, keeping
+; CMOVE's byte-at-a-time result. Otherwise: rep movsb on ERMSB CPUs,
+; movdqu/movdqa 64-byte runs (SSE2) from COPY_SSE_MIN, else rep movsd
+; between byte head and tail. EAX, ECX clobbered; XMM0-3 too.
+copy_fwd:
+    cld
+    mov eax, edi
+    sub eax, esi
+    cmp eax, ecx
+    jb .cf_bytes                ; Overlapping forward
+    cmp ecx, 16
+    jb .cf_bytes
+    cmp ecx, COPY_ERMS_MIN
+    jb .cf_head
+    cmp dword [erms_ok], 0
+    jne .cf_bytes
+    cmp ecx, COPY_SSE_MIN
+    jb .cf_head
+    cmp dword [sse2_ok], 0
+    je .cf_head
+.cf_align:
+    test edi, 15
+    jz .cf_wide
+    movsb
+    dec ecx
+    jmp .cf_align
+.cf_wide:
+    mov eax, ecx
+    shr eax, 6
+.cf_run:
+    movdqu xmm0, [esi]
+    movdqu xmm1, [esi + 16]
+    movdqu xmm2, [esi + 32]
+    movdqu xmm3, [esi + 48]
+    movdqa [edi], xmm0
+    movdqa [edi + 16], xmm1
+    movdqa [edi + 32], xmm2
+    movdqa [edi + 48], xmm3
+    add esi, 64
+    add edi, 64
+    dec eax
+    jnz .cf_run
+    and ecx, 63
+.cf_head:
+    test edi, 3
+    jz .cf_dwords
+    movsb
+    dec ecx
+    jmp .cf_head
+.cf_dwords:
+    mov eax, ecx
+    shr ecx, 2
+    rep movsd
+    mov ecx, eax
+    and ecx, 3
+.cf_bytes:
+    rep movsb
+    ret
+
+; copy_back - Copy ECX bytes from ESI to EDI, highest first. From 16
+; bytes on the top (count mod 4) bytes go first, then rep movsd. A
+; destination just below the source stays bytewise (CMOVE>'s result).
+; EAX, ECX clobbered; DF is clear again on return.
+copy_back:
+    jecxz .cb_done
+    mov eax, esi
+    sub eax, edi
+    lea esi, [esi + ecx - 1]
+    lea edi, [edi + ecx - 1]
+    std
+    cmp eax, ecx
+    jb .cb_bytes                ; Overlapping, destination lower
+    cmp ecx, 16
+    jb .cb_bytes
+    mov eax, ecx
+    and ecx, 3
+    rep movsb
+    mov ecx, eax
+    shr ecx, 2
+    sub esi, 3
+    sub edi, 3
+    rep movsd
+    jmp .cb_end
+.cb_bytes:
+    rep movsb
+.cb_end:
+    cld
+.cb_done:
+    ret
+
+; --- Optional paging ---
+; Off by default: flat segments already reach every byte below 4GB.
+; PAGING-ON builds the identity map so ranges can get their own memory
+; type; LFB-WC makes framebuffer stores write-combining bursts.
+
+DEFCODE "PAGING-ON", PAGING_ON, 0  ; ( -- flag ) 0 if the CPU lacks PSE
+    call init_paging
+    push dword [paging_on]
+    NEXT
+
+DEFVAR "PAGING", PAGING, paging_on
+
+; TLB-SHOOTDOWN - ( -- addr ) xt LFB-WC runs after its own flush so the
+; other CPUs flush too (SMP installs one); 0 = BSP only
+DEFVAR "TLB-SHOOTDOWN", TLB_SHOOTDOWN, tlb_shootdown
+
+; LFB-WC refuses a range that does not start and end on 4MB boundaries:
+; a PDE covers 4MB, and write-combining its other half could reach
+; another device's registers.
+DEFCODE "LFB-WC", LFB_WC, 0 ; ( addr size -- flag ) Write-combine the whole 4MB pages of a range
+    pop ecx
+    pop eax
+    xor edx, edx
+    cmp dword [pat_ok], 0
+    je .wc_done
+    cmp dword [paging_on], 0
+    je .wc_done
+    test ecx, ecx
+    jz .wc_done
+    mov edx, eax
+    or edx, ecx
+    test edx, 0x3FFFFF
+    mov edx, 0
+    jnz .wc_done                ; Not whole 4MB pages
+    dec ecx
+    add ecx, eax
+    jnc .wc_range
+    or ecx, -1                  ; Clamp at 4GB
+.wc_range:
+    shr eax, 22
+    shr ecx, 22
+.wc_pde:
+    or dword [PAGE_DIR + eax * 4], PDE_PAT
+    inc eax
+    cmp eax, ecx
+    jbe .wc_pde
+    call tlb_flush_
+    mov eax, [tlb_shootdown]
+    test eax, eax
+    jz .wc_ok
+    call execute_xt             ; preserves ESI
+.wc_ok:
+    mov edx, -1
+.wc_done:
+    push edx
+    NEXT
+
+DEFCODE "TLB-FLUSH", TLB_FLUSH, 0 ; ( -- ) Write back caches, flush this CPU's TLB
+    call tlb_flush_
+    NEXT
+
+; --- Direct I/O Port Access (Ring 0 only!) ---
+
+%ifdef TOS_CACHE
+DEFTOS "INB", INB, 0        ; ( port -- byte )
+    mov edx, ebx
+    xor eax, eax
+    in al, dx
+    TRACE_PORT 0                ; type=INB, port=DX, val=EAX
+    mov ebx, eax
+    TNEXT
+
+DEFTOS "INW", INW, 0        ; ( port -- word )
+    mov edx, ebx
+    xor eax, eax
+    in ax, dx
+    TRACE_PORT 2                ; type=INW
+    mov ebx, eax
+    TNEXT
+
+DEFTOS "INL", INL, 0        ; ( port -- dword )
+    mov edx, ebx
+    in eax, dx
+    TRACE_PORT 4                ; type=INL
+    mov ebx, eax
+    TNEXT
+
+DEFTOS "OUTB", OUTB, 0      ; ( byte port -- )
+    mov edx, ebx
+    pop eax
+    TRACE_PORT 1                ; type=OUTB, before write
+    out dx, al
+    pop ebx
+    TNEXT
+
+DEFTOS "OUTW", OUTW, 0      ; ( word port -- )
+    mov edx, ebx
+    pop eax
+    TRACE_PORT 3                ; type=OUTW
+    out dx, ax
+    pop ebx
+    TNEXT
+
+DEFTOS "OUTL", OUTL, 0      ; ( dword port -- )
+    mov edx, ebx
+    pop eax
+    TRACE_PORT 5                ; type=OUTL
+    out dx, eax
+    pop ebx
+    TNEXT
+
+%else
+DEFCODE "INB", INB, 0       ; ( port -- byte )
+    pop edx
+    xor eax, eax
+    in al, dx
+    TRACE_PORT 0                ; type=INB, port=DX, val=EAX
+    push eax
+    NEXT
+
+DEFCODE "INW", INW, 0       ; ( port -- word )
+    pop edx
+    xor eax, eax
+    in ax, dx
+    TRACE_PORT 2                ; type=INW
+    push eax
+    NEXT
+
+DEFCODE "INL", INL, 0       ; ( port -- dword )
+    pop edx
+    in eax, dx
+    TRACE_PORT 4                ; type=INL
+    push eax
+    NEXT
+
+DEFCODE "OUTB", OUTB, 0     ; ( byte port -- )
+    pop edx
+    pop eax
+    TRACE_PORT 1                ; type=OUTB, before write
+    out dx, al
+    NEXT
+
+DEFCODE "OUTW", OUTW, 0     ; ( word port -- )
+    pop edx
+    pop eax
+    TRACE_PORT 3                ; type=OUTW
+    out dx, ax
+    NEXT
+
+DEFCODE "OUTL", OUTL, 0     ; ( dword port -- )
+    pop edx
+    pop eax
     TRACE_PORT 5                ; type=OUTL
     out dx, eax
     NEXT
 
+%endif
+
+; --- String port I/O ---
+; ( port addr count -- ) count is in bytes, words or dwords. One rep
+; ins / rep outs per transfer; ECHOPORT gets one record with the count.
+
+DEFCODE "INSB", INSB, 0
+    pop ecx
+    pop edi
+    pop edx
+    mov eax, ecx
+    TRACE_PORT 6
+    cld
+    rep insb
+    NEXT
+
+DEFCODE "INSW", INSW, 0
+    pop ecx
+    pop edi
+    pop edx
+    mov eax, ecx
+    TRACE_PORT 8
+    cld
+    rep insw
+    NEXT
+
+DEFCODE "INSD", INSD, 0
+    pop ecx
+    pop edi
+    pop edx
+    mov eax, ecx
+    TRACE_PORT 10
+    cld
+    rep insd
+    NEXT
+
+DEFCODE "OUTSB", OUTSB, 0
+    pop ecx
+    pop edi
+    pop edx
+    mov eax, ecx
+    TRACE_PORT 7
+    push esi
+    mov esi, edi
+    cld
+    rep outsb
+    pop esi
+    NEXT
+
+DEFCODE "OUTSW", OUTSW, 0
+    pop ecx
+    pop edi
+    pop edx
+    mov eax, ecx
+    TRACE_PORT 9
+    push esi
+    mov esi, edi
+    cld
+    rep outsw
+    pop esi
+    NEXT
+
+DEFCODE "OUTSD", OUTSD, 0
+    pop ecx
+    pop edi
+    pop edx
+    mov eax, ecx
+    TRACE_PORT 11
+    push esi
+    mov esi, edi
+    cld
+    rep outsd
+    pop esi
+    NEXT
+
 ; --- I/O ---
 
 DEFCODE "KEY", KEY, 0       ; ( -- char )
@@ -1112,7 +2152,8 @@ DEFCODE ".S", DOTS, 0       ; Show stack (non-destructive, bottom to top)
     mov esi, msg_stack
     call print_string
 
-    mov ecx, DATA_STACK_TOP
+    call stack_s0_
+    lea ecx, [eax - TOS_SLOT]   ; ESP of this stack, empty and spilled
     sub ecx, esp
     shr ecx, 2              ; Number of items
 
@@ -1121,11 +2162,11 @@ DEFCODE ".S", DOTS, 0       ; Show stack (non-destructive, bottom to top)
     jle .depth_ok
     mov ecx, 64
 .depth_ok:
-    ; Also guard against negative depth (ESP above DATA_STACK_TOP)
+    ; Also guard against negative depth (ESP above the empty stack)
     test ecx, ecx
     jle .done
 
-    ; Print bottom-to-top: start at deepest item (near DATA_STACK_TOP)
+    ; Print bottom-to-top: start at deepest item (near the stack top)
     ; and walk down toward ESP. Deepest item is at ESP + (depth-1)*4.
     mov edi, ecx
     shl edi, 2              ; edi = depth * 4
@@ -1158,9 +2199,40 @@ DEFCONST "VERSION", VERSION, 1
 DEFCONST "CELL", CELL, 4
 DEFCONST "TRUE", TRUE, -1
 DEFCONST "FALSE", FALSE, 0
+DEFCONST "TOS-CACHED", TOS_CACHED, TOS_FLAG  ; -1 if built with TOS_CACHE
+DEFCONST "PROFILING", PROFILING, PROF_FLAG   ; -1 if built with PROFILE
 
 ; --- Control Flow ---
 
+%ifdef TOS_CACHE
+DEFTOS "EXIT", EXIT, 0
+    POPRSP esi
+    TNEXT
+
+DEFTOS "BRANCH", BRANCH, 0
+    add esi, [esi]
+    TNEXT
+
+DEFTOS "0BRANCH", ZBRANCH, 0
+    mov eax, ebx
+    pop ebx
+    test eax, eax
+    jz code_BRANCH
+    add esi, 4              ; Skip offset
+    TNEXT
+
+DEFTOS "EXECUTE", EXECUTE, 0
+    mov eax, ebx
+    pop ebx
+    jmp [eax]
+
+DEFTOS "LIT", LIT, 0
+    push ebx
+    lodsd
+    mov ebx, eax
+    TNEXT
+
+%else
 DEFCODE "EXIT", EXIT, 0
     POPRSP esi
     NEXT
@@ -1185,6 +2257,8 @@ DEFCODE "LIT", LIT, 0
     push eax
     NEXT
 
+%endif
+
 ; --- Dictionary ---
 
 DEFCODE "'", TICK, 0        ; ( "name" -- xt )
@@ -1233,6 +2307,30 @@ DEFCODE "FIND", FIND, 0     ; ( c-addr -- c-addr 0 | xt 1 | xt -1 )
     push eax
     NEXT
 
+; REHASH - ( -- ) Rebuild the dictionary hash index from the vocab chains.
+; Needed after anything rewrites the dictionary wholesale (LOOKINGGLASS).
+DEFCODE "REHASH", REHASH, 0
+    call dict_hash_rebuild
+    NEXT
+
+; HASH-NODES - ( -- addr ) Number of headers in the hash index
+DEFVAR "HASH-NODES", HASH_NODES, dict_hash_count
+
+; HNODE-BASE / HNODE-SZ - ( -- n ) Node pool and node size of the hash
+; index; node n is [next][header][vocab cell] at HNODE-BASE + n*HNODE-SZ
+DEFCONST "HNODE-BASE", HNODE_BASE, DICT_HASH_NODES
+DEFCONST "HNODE-SZ", HNODE_SZ, DICT_HASH_NODE_SZ
+
+; KERNEL-HASH - ( -- u ) Hash of kernel code + text blob; a dictionary
+; snapshot only boots on the kernel whose hash it records
+DEFCODE "KERNEL-HASH", KERNEL_HASH, 0
+    call kernel_hash_
+    push eax
+    NEXT
+
+; SNAPSHOT-BOOT - ( -- addr ) -1 if this boot restored a snapshot, else 0
+DEFVAR "SNAPSHOT-BOOT", SNAPSHOT_BOOT, snap_booted
+
 ; --- Interpreter ---
 
 ; INTERPRET - Process one token from the input stream
@@ -1256,6 +2354,13 @@ DEFCODE "INTERPRET", INTERPRET, 0
 
 .interactive:
 
+    ; The first prompt ends the boot (BOOT-US 2)
+    cmp dword [boot_tsc + 16], 0
+    jne .booted
+    mov eax, 2
+    call boot_stamp_
+.booted:
+
     ; Interactive mode: print prompt and read a line
     mov al, 'o'
     call print_char
@@ -1279,6 +2384,10 @@ DEFCODE "INTERPRET", INTERPRET, 0
     mov [save_here], eax
     mov eax, [VAR_LATEST]
     mov [save_latest], eax
+    mov eax, [VAR_CURRENT]
+    mov [save_current], eax
+    mov eax, [eax]
+    mov [save_current_head], eax
 
     ; Read a line of input
     call read_line
@@ -1313,15 +2422,20 @@ DEFCODE "INTERPRET", INTERPRET, 0
 
     ; Compiling: check if word is IMMEDIATE
     test cl, F_IMMEDIATE
-    jnz .execute_word         ; Immediate words execute even during compilation
+    jnz .execute_immediate    ; Immediate words execute even during compilation
 
     ; Compile the word's XT into the definition
     mov eax, ebx
-    call comma_
+    call peep_compile_
     NEXT                      ; Return to cold_start loop for next token
 
+.execute_immediate:
+    ; IF, THEN, BEGIN... may mark or patch HERE: no fusing across them
+    mov dword [peep_n], 0
+
 .execute_word:
     mov eax, ebx
+    FILL                      ; Enter the word with TOS cached
     jmp [eax]                 ; Execute the word (it will end with NEXT)
 
 .try_number:
@@ -1336,11 +2450,7 @@ DEFCODE "INTERPRET", INTERPRET, 0
     jz .push_number
 
     ; Compiling: compile LIT + number
-    push eax
-    mov eax, LIT
-    call comma_
-    pop eax
-    call comma_
+    call peep_literal_
     NEXT
 
 .push_number:
@@ -1385,6 +2495,12 @@ DEFCODE "INTERPRET", INTERPRET, 0
     mov [VAR_HERE], eax
     mov eax, [save_latest]
     mov [VAR_LATEST], eax
+    ; Roll the compilation vocabulary's chain head back too, so it never
+    ; points into the discarded region (find_ purges the hash index lazily)
+    mov eax, [save_current]
+    mov [VAR_CURRENT], eax
+    mov ecx, [save_current_head]
+    mov [eax], ecx
     mov dword [VAR_TOIN], 0
     mov dword [VAR_BLK], 0      ; Also reset BLK on break
     mov dword [VAR_BLOCK_LOADING], 0
@@ -1655,6 +2771,18 @@ DEFCODE "DO", DO, F_IMMEDIATE
     push dword [VAR_HERE]
     NEXT
 
+%ifdef TOS_CACHE
+; Runtime (DO) - moves loop parameters to return stack
+DEFTOS "(DO)", DODO, 0
+    pop eax                    ; limit (EBX = index)
+    sub ebp, 4
+    mov [ebp], eax             ; limit
+    sub ebp, 4
+    mov [ebp], ebx             ; index
+    pop ebx
+    TNEXT
+
+%else
 ; Runtime (DO) - moves loop parameters to return stack
 DEFCODE "(DO)", DODO, 0
     pop eax                    ; index
@@ -1666,6 +2794,8 @@ DEFCODE "(DO)", DODO, 0
     mov [ebp], eax             ; index
     NEXT
 
+%endif
+
 ; LOOP - Counted loop end
 DEFCODE "LOOP", LOOP, F_IMMEDIATE
     ; Compile (LOOP)
@@ -1682,6 +2812,23 @@ DEFCODE "LOOP", LOOP, F_IMMEDIATE
     add dword [VAR_HERE], 4
     NEXT
 
+%ifdef TOS_CACHE
+; Runtime (LOOP)
+DEFTOS "(LOOP)", DOLOOP, 0
+    mov eax, [ebp]             ; index
+    inc eax
+    mov [ebp], eax
+    cmp eax, [ebp + 4]         ; limit
+    jge .done
+    lodsd                      ; Branch back
+    add esi, eax
+    TNEXT
+.done:
+    add ebp, 8
+    lodsd                      ; Skip offset
+    TNEXT
+
+%else
 ; Runtime (LOOP)
 DEFCODE "(LOOP)", DOLOOP, 0
     ; Increment index
@@ -1702,6 +2849,8 @@ DEFCODE "(LOOP)", DOLOOP, 0
     lodsd                      ; Skip offset
     NEXT
 
+%endif
+
 ; +LOOP - Increment loop by arbitrary amount
 DEFCODE "+LOOP", PLOOP, F_IMMEDIATE
     ; Compile (+LOOP)
@@ -1718,6 +2867,32 @@ DEFCODE "+LOOP", PLOOP, F_IMMEDIATE
     add dword [VAR_HERE], 4
     NEXT
 
+%ifdef TOS_CACHE
+; Runtime (+LOOP)
+DEFTOS "(+LOOP)", DOPLOOP, 0
+    mov ecx, ebx               ; increment
+    pop ebx
+    mov eax, [ebp]             ; index
+    add eax, ecx               ; new index
+    mov [ebp], eax
+    test ecx, ecx
+    js .negative
+    cmp eax, [ebp + 4]
+    jge .done
+    jmp .continue
+.negative:
+    cmp eax, [ebp + 4]
+    jl .done
+.continue:
+    lodsd
+    add esi, eax
+    TNEXT
+.done:
+    add ebp, 8
+    lodsd
+    TNEXT
+
+%else
 ; Runtime (+LOOP)
 DEFCODE "(+LOOP)", DOPLOOP, 0
     pop ecx                    ; increment
@@ -1745,6 +2920,33 @@ DEFCODE "(+LOOP)", DOPLOOP, 0
     lodsd
     NEXT
 
+%endif
+
+%ifdef TOS_CACHE
+; I - Get loop index
+DEFTOS "I", I, 0
+    push ebx
+    mov ebx, [ebp]
+    TNEXT
+
+; J - Get outer loop index
+DEFTOS "J", J, 0
+    push ebx
+    mov ebx, [ebp + 8]
+    TNEXT
+
+; LEAVE - Exit loop immediately
+DEFTOS "LEAVE", LEAVE, 0
+    mov eax, [ebp + 4]         ; limit
+    mov [ebp], eax             ; index = limit
+    TNEXT
+
+; UNLOOP - Remove loop parameters from return stack
+DEFTOS "UNLOOP", UNLOOP, 0
+    add ebp, 8
+    TNEXT
+
+%else
 ; I - Get loop index
 DEFCODE "I", I, 0
     mov eax, [ebp]
@@ -1769,6 +2971,69 @@ DEFCODE "UNLOOP", UNLOOP, 0
     add ebp, 8
     NEXT
 
+%endif
+
+; ============================================================================
+; Superinstructions
+; ============================================================================
+; Fused forms of common primitive sequences. Never written by hand: the
+; compiler's peephole pass (peep_fuse_) rewrites the originals into these,
+; and DECOMP prints them back as the original words. Plain DEFCODE bodies
+; serve both builds (SPILL/FILL bracket under TOS_CACHE).
+
+; (LIT+) - LIT n +                 ( x -- x+n )
+DEFCODE "(LIT+)", LITPLUS, 0
+    lodsd
+    add [esp], eax
+    NEXT
+
+; (UNDER+) - SWAP LIT n + SWAP     ( x y -- x+n y )
+DEFCODE "(UNDER+)", UNDERPLUS, 0
+    lodsd
+    add [esp + 4], eax
+    NEXT
+
+; (2DUP!) - 2DUP !                 ( x addr -- x addr )
+DEFCODE "(2DUP!)", TWODUPSTORE, 0
+    mov eax, [esp]
+    mov ecx, [esp + 4]
+    mov [eax], ecx
+    NEXT
+
+; (2DUP!UNDER+) - 2DUP ! SWAP LIT n + SWAP   ( x addr -- x+n addr )
+; The VGA-CLEAR / VGA-HLINE inner loop in one dispatch.
+DEFCODE "(2DUP!UNDER+)", TWODUPSTOREUNDER, 0
+    mov eax, [esp]
+    mov ecx, [esp + 4]
+    mov [eax], ecx
+    lodsd
+    add [esp + 4], eax
+    NEXT
+
+; (@+) - @ +                       ( n addr -- n+[addr] )
+DEFCODE "(@+)", FETCHPLUS, 0
+    pop eax
+    mov eax, [eax]
+    add [esp], eax
+    NEXT
+
+; (DUP0=) - DUP 0=                 ( x -- x flag )
+DEFCODE "(DUP0=)", DUPZEQU, 0
+    mov eax, [esp]
+    cmp eax, 1                 ; CF set only for x = 0
+    sbb eax, eax
+    push eax
+    NEXT
+
+; (OVER+) - OVER +                 ( a b -- a a+b )
+DEFCODE "(OVER+)", OVERPLUS, 0
+    mov eax, [esp + 4]
+    add [esp], eax
+    NEXT
+
+; PEEPHOLE - ( -- addr ) Nonzero: fuse sequences while compiling
+DEFVAR "PEEPHOLE", PEEPHOLE, peep_enabled
+
 ; ============================================================================
 ; Defining Words
 ; ============================================================================
@@ -1797,6 +3062,20 @@ DEFCODE "CONSTANT", CONSTANT, 0
     add dword [VAR_HERE], 4
     NEXT
 
+%ifdef TOS_CACHE
+; Runtime for CONSTANT
+DEFTOS "DOCON", DOCON, 0
+    push ebx                   ; EAX = XT, value at [XT + 4]
+    mov ebx, [eax + 4]
+    TNEXT
+
+; DOCREATE - Runtime for CREATE'd words (variables, etc.)
+DEFTOS "DOCREATE", DOCREATE, 0
+    push ebx
+    lea ebx, [eax + 4]
+    TNEXT
+
+%else
 ; Runtime for CONSTANT
 DEFCODE "DOCON", DOCON, 0
     ; EAX still holds the XT (code field address) from NEXT/INTERPRET.
@@ -1811,6 +3090,8 @@ DEFCODE "DOCREATE", DOCREATE, 0
     push eax
     NEXT
 
+%endif
+
 ; HIDDEN - Toggle hidden flag on a word
 DEFCODE "HIDDEN", HIDDEN, 0
     pop eax                    ; xt of word
@@ -2092,9 +3373,10 @@ DEFCODE ">BODY", TOBODY, 0
     push eax
     NEXT
 
-; DEPTH - ( -- n ) Stack depth
+; DEPTH - ( -- n ) Stack depth, on whichever task or CPU stack is running
 DEFCODE "DEPTH", DEPTH, 0
-    mov eax, DATA_STACK_TOP
+    call stack_s0_
+    sub eax, TOS_SLOT
     sub eax, esp
     shr eax, 2                 ; Divide by 4 (cell size)
     push eax
@@ -2380,13 +3662,21 @@ DEFCODE "ALIGN", FALIGN, 0
     mov [VAR_HERE], eax
     NEXT
 
-; MOVE - ( src dst u -- ) Copy u bytes
+; MOVE - ( src dst u -- ) Copy u bytes; overlapping ranges are safe
 DEFCODE "MOVE", MOVE, 0
     PUSHRSP esi                ; Save Forth IP
     pop ecx                    ; count
     pop edi                    ; dst
     pop esi                    ; src
-    rep movsb
+    mov eax, edi
+    sub eax, esi
+    cmp eax, ecx
+    jae .mv_fwd                ; dst below src or past its end
+    call copy_back
+    jmp .mv_done
+.mv_fwd:
+    call copy_fwd
+.mv_done:
     POPRSP esi                 ; Restore Forth IP
     NEXT
 
@@ -2394,16 +3684,16 @@ DEFCODE "MOVE", MOVE, 0
 DEFCODE "ERASE", ERASE, 0
     pop ecx                    ; count
     pop edi                    ; addr
-    xor al, al
-    rep stosb
+    xor eax, eax
+    call fill_bytes
     NEXT
 
 ; BLANK - ( addr u -- ) Fill with spaces
 DEFCODE "BLANK", BLANK, 0
     pop ecx
     pop edi
-    mov al, ' '
-    rep stosb
+    mov eax, ' '
+    call fill_bytes
     NEXT
 
 ; ============================================================================
@@ -2439,10 +3729,12 @@ DEFCODE ".R", DOTR, 0
 ; --- Special ---
 
 DEFCODE "BYE", BYE, 0
+    call serial_drain_              ; Let queued console output out
     ; Halt the system
     cli
+.halt:
     hlt
-    jmp code_BYE
+    jmp .halt
 
 ; ============================================================================
 ; Block Storage Words
@@ -2455,53 +3747,19 @@ DEFVAR "BLK", BLK, VAR_BLK
 DEFVAR "SCR", SCR, VAR_SCR
 
 ; BLOCK - ( n -- addr ) Get buffer address for block n, reading from disk if needed
+; On a read error the buffer address is returned anyway (may hold garbage)
 DEFCODE "BLOCK", BLOCK, 0
     pop eax                     ; block#
-    call blk_find_buffer        ; EDI=buffer addr, EBX=header addr, CF=needs load
-    jnc .cached
-
-    ; Need to load block data into buffer
-    push edi                    ; Save buffer addr
-    push ebx                    ; Save header addr
-    mov eax, [ebx]              ; block#
-
-    ; Check if we booted from memdisk (RAM-backed image)
-    cmp dword [MEMDISK_BASE], 0
-    jne .ram_path
-
-    ; --- ATA PIO path (QEMU / real disk) ---
-    shl eax, 1                  ; LBA = block# * 2
-    add eax, BLOCKS_LBA_BASE   ; + base offset in combined image
-    mov ebx, eax                ; EBX = LBA for ata_read_sector
-    ; Read first sector
-    call ata_read_sector
-    jc .read_error
-    ; Read second sector (EDI already advanced by rep insw)
-    inc ebx
-    call ata_read_sector
-    jc .read_error
-    jmp .load_done
-
-    ; --- RAM path (memdisk PXE boot) ---
-.ram_path:
-    call ram_read_block
-
-.load_done:
-    pop ebx                     ; Restore header addr
-    ; Mark valid
-    or dword [ebx + 4], BLK_BUF_FLAG_VALID
-    pop edi                     ; Restore buffer addr (original start)
-    push edi                    ; Push result
-    NEXT
-
-.read_error:
-    pop ebx
-    pop edi
-    ; Return buffer addr anyway (may contain garbage)
+    call blk_get_               ; EDI=buffer addr (read + read-ahead if needed)
     push edi
     NEXT
 
-.cached:
+; BLOCK-VIEW - ( n -- addr ) BLOCK for a reader that never stores into
+; the block. On memdisk boot an uncached block comes straight from the
+; RAM image (see blk_view_); UPDATE does not apply to it.
+DEFCODE "BLOCK-VIEW", BLOCK_VIEW, 0
+    pop eax
+    call blk_view_
     push edi
     NEXT
 
@@ -2510,18 +3768,37 @@ DEFCODE "BUFFER", BUFFER, 0
     pop eax                     ; block#
     call blk_find_buffer        ; EDI=buffer addr, EBX=header addr
     ; Mark valid without reading (caller will write the data)
-    or dword [ebx + 4], BLK_BUF_FLAG_VALID
+    or dword [ebx + BLK_HDR_FLAGS], BLK_BUF_FLAG_VALID
     push edi
     NEXT
 
 ; UPDATE - ( -- ) Mark current buffer as dirty (modified)
+; With WRITE-BEHIND set, the first UPDATE after a write-back also starts
+; the countdown to the next background flush. A block in the BLK-WATCH
+; range bumps its generation.
 DEFCODE "UPDATE", UPDATE, 0
-    mov eax, [BLK_BUF_CUR]     ; Current buffer index
-    imul eax, BLK_HEADER_SIZE
-    or dword [BLK_BUF_HEADERS + eax + 4], BLK_BUF_FLAG_DIRTY
+    mov eax, [BLK_BUF_CUR]     ; Current buffer header
+    or dword [eax + BLK_HDR_FLAGS], BLK_BUF_FLAG_DIRTY
+    mov ecx, [eax + BLK_HDR_BLOCK]
+    sub ecx, [blk_watch]
+    cmp ecx, [blk_watch + 4]
+    jae .unwatched              ; Below first or past the range
+    inc dword [blk_watch + 8]
+.unwatched:
+    mov eax, [blk_wb_ticks]
+    test eax, eax
+    jz .done
+    cmp dword [blk_wb_due], 0
+    jne .done                   ; Already armed
+    add eax, [isr_tick_count]
+    jnz .arm
+    inc eax                     ; 0 means "not armed"
+.arm:
+    mov [blk_wb_due], eax
+.done:
     NEXT
 
-; SAVE-BUFFERS - ( -- ) Write all dirty buffers to disk
+; SAVE-BUFFERS - ( -- ) Write all dirty buffers to disk, in block order
 DEFCODE "SAVE-BUFFERS", SAVEBUFFERS, 0
     PUSHRSP esi                 ; Defensive save (blk_flush_one preserves ESI)
 %ifdef DEBUG_FLUSH
@@ -2534,17 +3811,7 @@ DEFCODE "SAVE-BUFFERS", SAVEBUFFERS, 0
     call serial_putchar
     pop eax
 %endif
-    mov ebx, BLK_BUF_HEADERS
-    mov ecx, BLK_NUM_BUFFERS
-.flush_loop:
-    push ecx
-    push ebx
-    call blk_flush_one
-    pop ebx
-    pop ecx
-    add ebx, BLK_HEADER_SIZE
-    dec ecx
-    jnz .flush_loop
+    call blk_flush_all_
 %ifdef DEBUG_FLUSH
     push eax
     mov al, ']'
@@ -2560,15 +3827,8 @@ DEFCODE "SAVE-BUFFERS", SAVEBUFFERS, 0
 
 ; EMPTY-BUFFERS - ( -- ) Discard all buffers (clear headers, no write)
 DEFCODE "EMPTY-BUFFERS", EMPTYBUFFERS, 0
-    mov edi, BLK_BUF_HEADERS
-    mov ecx, BLK_NUM_BUFFERS
-.clear_loop:
-    mov dword [edi], 0xFFFFFFFF     ; block# = invalid
-    mov dword [edi + 4], 0          ; flags = 0
-    mov dword [edi + 8], 0          ; age = 0
-    add edi, BLK_HEADER_SIZE
-    dec ecx
-    jnz .clear_loop
+    mov ecx, [blk_nbufs]
+    call blk_pool_init_
     NEXT
 
 ; FLUSH - ( -- ) Save all dirty buffers then discard them
@@ -2577,6 +3837,61 @@ DEFWORD "FLUSH", FLUSH, 0
     dd EMPTYBUFFERS
     dd EXIT
 
+; READ-AHEAD - ( -- addr ) Blocks read past a BLOCK/LOAD miss (0 = off).
+; Capped at 8 and at #BUFFERS - 2 so the requested and source buffers stay.
+DEFVAR "READ-AHEAD", READ_AHEAD, blk_read_ahead
+
+; MEMDISK-MAP - ( -- addr ) Nonzero (default): on memdisk boot LIST and
+; BLOCK-VIEW return uncached blocks straight from the RAM image, no copy
+; and no buffer taken. 0 = copy into the pool like a disk read.
+DEFVAR "MEMDISK-MAP", MEMDISK_MAP, blk_map_on
+
+; BLK-POOL-DATA / BLK-POOL-END - ( -- addr ) Bounds of the buffer data
+DEFCONST "BLK-POOL-DATA", BLK_POOL_DATA_CONST, BLK_POOL_DATA
+DEFCONST "BLK-POOL-END", BLK_POOL_END_CONST, BLK_STAGE
+
+; #BUFFERS - ( -- n ) Number of block buffers in the pool
+DEFCODE "#BUFFERS", NBUFFERS, 0
+    push dword [blk_nbufs]
+    NEXT
+
+; BLK-BUFFERS - ( n -- ) Resize the buffer pool to n buffers (8-512).
+; Dirty buffers are written back first; every buffer comes back empty.
+DEFWORD "BLK-BUFFERS", BLK_BUFFERS, 0
+    dd SAVEBUFFERS
+    dd BLK_POOL_INIT
+    dd EXIT
+
+; (BLK-POOL-INIT) - ( n -- ) Rebuild the pool with n empty buffers
+DEFCODE "(BLK-POOL-INIT)", BLK_POOL_INIT, 0
+    pop ecx
+    call blk_pool_init_
+    NEXT
+
+; WRITE-BEHIND - ( -- addr ) 0 = write-through (default): evicting a dirty
+; buffer writes that buffer back first. n = write-behind: eviction prefers
+; clean buffers, and dirty ones are written back about n timer ticks after
+; an UPDATE, from the input idle loop or the next buffer miss.
+DEFVAR "WRITE-BEHIND", WRITE_BEHIND, blk_wb_ticks
+
+; BLK-WATCH - ( -- addr ) [first][count][gen]: UPDATE of a block in
+; first..first+count-1 increments gen (the catalog resolver's index)
+DEFVAR "BLK-WATCH", BLK_WATCH, blk_watch
+
+; BLK-BARRIER - ( -- ior ) Write every dirty buffer back now and wait for
+; the writer; ior = number of blocks that failed (0 = all durable). Words
+; that promise durability (SET-SAVE, the editor's save) end with it,
+; whatever WRITE-BEHIND is set to.
+DEFCODE "BLK-BARRIER", BLK_BARRIER, 0
+    mov dword [blk_flush_errs], 0
+    call blk_flush_all_         ; preserves ESI
+    push dword [blk_flush_errs]
+    NEXT
+
+; ATA-DMA - ( -- addr ) Bus-master IDE base used for block reads, found
+; on the first disk read; 0 = PIO (READ MULTIPLE). Store 0 to force PIO.
+DEFVAR "ATA-DMA", ATA_DMA, ata_dma_base
+
 ; ============================================================================
 ; Block Write Vector — pluggable writer backend
 ; ============================================================================
@@ -2590,18 +3905,16 @@ DEFWORD "FLUSH", FLUSH, 0
 ; Boot default: (BLK-WRITE-ATA). Memdisk boot: (BLK-WRITE-NONE).
 
 ; (BLK-WRITE-ATA) - ( buf-addr blk# -- ior ) Default ATA PIO block writer.
-; LBA = blk# * 2 + BLOCKS_LBA_BASE, two 512-byte sectors per block.
+; LBA = blk# * 2 + BLOCKS_LBA_BASE, both sectors in a single command.
 DEFCODE "(BLK-WRITE-ATA)", BLKWRITEATA, 0
-    PUSHRSP esi                 ; ata_write_sector uses ESI as data source
+    PUSHRSP esi                 ; ata_write_sectors uses ESI as data source
     pop eax                     ; blk#
     pop esi                     ; buf-addr (source for rep outsw)
     shl eax, 1                  ; LBA = blk# * 2
     add eax, BLOCKS_LBA_BASE
     mov ebx, eax
-    call ata_write_sector       ; clobbers EAX/ECX/EDX, advances ESI by 512
-    jc .fail
-    inc ebx                     ; second sector (EBX preserved across call)
-    call ata_write_sector
+    mov ecx, 2                  ; One WRITE SECTORS + one cache flush per block
+    call ata_write_sectors      ; clobbers EAX/ECX/EDX, advances ESI
     jc .fail
     POPRSP esi
     push dword 0                ; ior = 0: success
@@ -2631,6 +3944,38 @@ DEFCODE "BLK-WRITER@", BLKWRITERFETCH, 0
     push dword [BLK_WRITE_VEC]
     NEXT
 
+; BLK-RUN-WRITER! - ( xt -- ) Install a run writer for the active block
+; writer. Run contract: ( buf-addr blk# n -- ior ), n consecutive blocks
+; from one contiguous buffer. Used only while BLK_WRITE_VEC is still the
+; writer it was installed with; 0 = none (every block goes singly).
+DEFCODE "BLK-RUN-WRITER!", BLKRUNWRITERSTORE, 0
+    pop eax
+    mov [blk_run_writer], eax
+    mov eax, [BLK_WRITE_VEC]
+    mov [blk_run_writer_for], eax
+    NEXT
+
+; (BLK-WRITE-RUN-ATA) - ( buf-addr blk# n -- ior ) ATA run writer: n
+; blocks (n <= BLK_RUN_MAX) in one WRITE SECTORS + one cache flush.
+DEFCODE "(BLK-WRITE-RUN-ATA)", BLKWRITERUNATA, 0
+    PUSHRSP esi                 ; ata_write_sectors uses ESI as data source
+    pop ecx                     ; n
+    pop eax                     ; blk#
+    pop esi                     ; buf-addr
+    shl eax, 1                  ; LBA = blk# * 2
+    add eax, BLOCKS_LBA_BASE
+    mov ebx, eax
+    shl ecx, 1                  ; 2 sectors per block
+    call ata_write_sectors      ; clobbers EAX/ECX/EDX, advances ESI
+    jc .fail
+    POPRSP esi
+    push dword 0
+    NEXT
+.fail:
+    POPRSP esi
+    push dword 1
+    NEXT
+
 ; ============================================================================
 ; Block Read Vector — pluggable persistent-read backend (M4c)
 ; ============================================================================
@@ -2719,24 +4064,9 @@ DEFCODE "LIST", LIST, 0
     pop eax
     mov [VAR_SCR], eax          ; Remember for SCR
 
-    ; Get block buffer (reads from disk if needed)
-    call blk_find_buffer
-    jnc .have_data
-    ; Need to read
-    push edi
-    push ebx
-    mov eax, [ebx]
-    shl eax, 1
-    add eax, BLOCKS_LBA_BASE   ; + base offset in combined image
-    mov ebx, eax
-    call ata_read_sector
-    inc ebx
-    call ata_read_sector
-    pop ebx
-    or dword [ebx + 4], BLK_BUF_FLAG_VALID
-    pop edi
+    ; Get block buffer (reads from disk if needed; maps memdisk)
+    call blk_view_
 
-.have_data:
     PUSHRSP esi                 ; Save Forth IP
     mov esi, edi                ; ESI = buffer data for printing
 
@@ -2791,40 +4121,11 @@ DEFCODE "LIST", LIST, 0
 DEFCODE "LOAD", LOAD, 0
     pop eax                     ; block#
 
-    ; Get block buffer
-    call blk_find_buffer
-    jnc .have_data
-    ; Need to read block data into buffer
-    push eax
-    push edi
-    push ebx
-    mov eax, [ebx]              ; block# from header
-
-    cmp dword [MEMDISK_BASE], 0
-    jne .load_ram
-
-    ; ATA PIO path
-    shl eax, 1
-    add eax, BLOCKS_LBA_BASE
-    mov ebx, eax
-    call ata_read_sector
-    inc ebx
-    call ata_read_sector
-    jmp .load_read_done
-
-.load_ram:
-    call ram_read_block
-
-.load_read_done:
-    pop ebx
-    or dword [ebx + 4], BLK_BUF_FLAG_VALID
-    pop edi
-    pop eax
+    ; Get block buffer (sequential loads find the next blocks read ahead)
+    call blk_get_               ; EAX preserved
 
-.have_data:
     ; Normalize block content: place NUL at end for word_ termination
-    ; (The NUL guard at BLK_BUF_GUARD handles this for the last buffer,
-    ;  but we also need it within the 1024-byte region)
+    ; (It lands in the gap before the next pool buffer, BLK_BUF_STRIDE)
     push eax
     mov byte [edi + BLOCK_SIZE], 0  ; NUL terminator after block data
 
@@ -2857,32 +4158,8 @@ DEFCODE "-->", CHAIN, F_IMMEDIATE
     mov [VAR_BLK], eax
 
     ; Get next block buffer
-    call blk_find_buffer
-    jnc .have_next
-    push edi
-    push ebx
-    mov eax, [ebx]
+    call blk_get_
 
-    cmp dword [MEMDISK_BASE], 0
-    jne .chain_ram
-
-    shl eax, 1
-    add eax, BLOCKS_LBA_BASE
-    mov ebx, eax
-    call ata_read_sector
-    inc ebx
-    call ata_read_sector
-    jmp .chain_read_done
-
-.chain_ram:
-    call ram_read_block
-
-.chain_read_done:
-    pop ebx
-    or dword [ebx + 4], BLK_BUF_FLAG_VALID
-    pop edi
-
-.have_next:
     mov byte [edi + BLOCK_SIZE], 0
     mov [VAR_TIB], edi
     mov dword [VAR_TOIN], 0
@@ -2909,7 +4186,7 @@ DEFWORD "THRU", THRU, 0
 DOVOC:
     lea eax, [eax + 4]         ; Address of vocab's LATEST cell (param field IS the cell)
     mov [VAR_SEARCH_ORDER], eax ; Replace top of search order
-    NEXT
+    TNEXT
 
 ; VOCABULARY - ( "name" -- ) Create a new vocabulary
 ; Creates a word with DOVOC runtime. Parameter field = address of a new LATEST cell.
@@ -3054,6 +4331,7 @@ DEFCODE "USING", USING, 0
 .full:
     ; Now execute the vocabulary word (replaces top of search order)
     pop eax                     ; XT of vocabulary word
+    FILL
     jmp [eax]                   ; Execute it (DOVOC sets ORDER[0], then NEXT)
 
 .not_found:
@@ -3072,6 +4350,130 @@ DEFCODE "USING", USING, 0
 ; TICK-COUNT - ( -- addr ) Address of ISR tick counter variable
 DEFVAR "TICK-COUNT", TICK_COUNT, isr_tick_count
 
+; ----------------------------------------------------------------------------
+; TSC timing. init_tsc measures the TSC against PIT channel 2 at boot;
+; TSC-KHZ stays 0 without a TSC, and the words below then return 0.
+; TSC@ is the low cell of the counter: intervals up to 2^32 cycles.
+; ----------------------------------------------------------------------------
+
+; TSC-KHZ - ( -- addr ) TSC cycles per millisecond
+DEFVAR "TSC-KHZ", TSC_KHZ, tsc_khz
+
+; TSC@ - ( -- u ) Low cell of the time-stamp counter
+DEFCODE "TSC@", TSC_FETCH, 0
+    xor eax, eax
+    cmp dword [tsc_khz], 0
+    je .none
+    rdtsc
+.none:
+    push eax
+    NEXT
+
+; TSC-HZ - ( -- u ) TSC cycles per second (unsigned, saturates)
+DEFCODE "TSC-HZ", TSC_HZ, 0
+    mov eax, [tsc_khz]
+    mov ecx, 1000
+    mul ecx
+    test edx, edx
+    jz .fits
+    mov eax, -1
+.fits:
+    push eax
+    NEXT
+
+; CYCLES>US - ( cycles -- us )
+DEFCODE "CYCLES>US", CYCLES_TO_US, 0
+    pop eax
+    mov ecx, [tsc_khz]
+    test ecx, ecx
+    jz .none
+    mov edx, 1000
+    mul edx                     ; EDX:EAX = cycles * 1000
+    cmp edx, ecx
+    jae .none                   ; Quotient would not fit
+    div ecx
+    push eax
+    NEXT
+.none:
+    push dword 0
+    NEXT
+
+; US>CYCLES - ( us -- cycles ) Saturates at 2^32-1
+DEFCODE "US>CYCLES", US_TO_CYCLES, 0
+    pop eax
+    call tsc_cycles_
+    push eax
+    NEXT
+
+; TSC-WAIT - ( us -- ) Spin until us microseconds of TSC time pass
+DEFCODE "TSC-WAIT", TSC_WAIT, 0
+    pop eax
+    cmp dword [tsc_khz], 0
+    je .done
+    call tsc_cycles_
+    mov ebx, eax                ; Cycles to wait
+    rdtsc
+    mov ecx, eax
+    mov edi, edx                ; EDI:ECX = start
+.spin:
+    pause
+    rdtsc
+    sub eax, ecx
+    sbb edx, edi
+    jnz .done                   ; 2^32 cycles or more
+    cmp eax, ebx
+    jb .spin
+.done:
+    NEXT
+
+; BOOT-US - ( n -- us ) Microseconds from kernel entry (after
+; init_tsc) to boot stamp n: 1 = embedded source or snapshot starts,
+; 2 = first prompt. 0 without a TSC or before the stamp was taken.
+DEFCODE "BOOT-US", BOOT_US, 0
+    pop eax
+    mov ecx, [tsc_khz]
+    test ecx, ecx
+    jz .none
+    cmp eax, BOOT_STAMPS
+    jae .none
+    lea edi, [boot_tsc + eax*8]
+    mov eax, [edi]
+    mov edx, [edi + 4]
+    mov ebx, eax
+    or ebx, edx
+    jz .none                    ; Not stamped yet
+    sub eax, [boot_tsc]
+    sbb edx, [boot_tsc + 4]     ; EDX:EAX = cycles since entry
+    mov ebx, edx
+    mov edi, 1000
+    mul edi
+    imul ebx, edi
+    add edx, ebx                ; EDX:EAX = cycles * 1000
+    cmp edx, ecx
+    jae .none                   ; Quotient would not fit
+    div ecx
+    push eax
+    NEXT
+.none:
+    push dword 0
+    NEXT
+
+; PROF-SAMPLING - ( -- addr ) Nonzero: each timer tick records the
+; interrupted ESI (Forth IP) and EIP in the sample ring
+DEFVAR "PROF-SAMPLING", PROF_SAMPLING, prof_sampling
+
+; PROF-HEAD - ( -- addr ) Samples taken; ring index = count AND (size-1)
+DEFVAR "PROF-HEAD", PROF_HEAD, prof_head
+
+DEFCONST "PROF-RING", PROF_RING_W, PROF_RING
+DEFCONST "PROF-RING-SIZE", PROF_RING_SIZE_W, PROF_RING_SIZE
+DEFCONST "PROF-ENTRY-SZ", PROF_ENTRY_SZ_W, PROF_ENTRY_SZ
+
+; PROF-COUNTS - ( -- addr ) -DPROFILE counters: the cell at addr+xt
+; counts thread fetches of xt (xt < PROF-XT-LIMIT)
+DEFCONST "PROF-COUNTS", PROF_COUNTS_W, PROF_COUNTS
+DEFCONST "PROF-XT-LIMIT", PROF_XT_LIMIT_W, PROF_XT_LIMIT
+
 ; IDT-BASE - ( -- addr ) Base address of the IDT
 DEFCONST "IDT-BASE", IDT_BASE_CONST, IDT_BASE
 
@@ -3108,15 +4510,252 @@ DEFCODE "IRQ-UNMASK", IRQ_UNMASK, 0
     out dx, al
     NEXT
 
-; KB-RING-BUF - ( -- addr ) Address of keyboard scancode ring buffer
-DEFCONST "KB-RING-BUF", KB_RING_BUF_CONST, kb_ring_buf
+; INT-SAVE - ( -- flags ) Disable interrupts, return the previous EFLAGS
+; Brackets code that must not race an IRQ hook (e.g. NIC remote DMA).
+DEFCODE "INT-SAVE", INT_SAVE, 0
+    pushfd
+    cli
+    NEXT
 
-; KB-RING-TAIL - ( -- addr ) Address of ring buffer tail (read position)
+; INT-RESTORE - ( flags -- ) Re-enable interrupts if INT-SAVE found them on
+DEFCODE "INT-RESTORE", INT_RESTORE, 0
+    pop eax
+    test eax, 0x200             ; EFLAGS.IF
+    jz .off
+    sti
+.off:
+    NEXT
+
+; IDLE - ( -- ) Sleep until the next interrupt (timer tick at the latest).
+; With tasks running, another ready task gets the CPU instead.
+DEFCODE "IDLE", IDLE, 0
+    sti
+    call task_idle
+    NEXT
+
+; --- Cooperative tasks ---
+; Off until the first TASK-RUN links MAIN-TASK (the interpreter) into a
+; ring with the new task. Switches happen only in PAUSE, IDLE, KEY and
+; TASK-DONE, never in an ISR.
+
+; PAUSE - ( -- ) Run the other ready tasks, round-robin
+DEFCODE "PAUSE", PAUSE, 0
+    call cpu_index
+    test eax, eax
+    jnz .pause_ap
+    cmp dword [task_cur], 0
+    je .pause_done
+    call task_switch
+    jmp .pause_done
+.pause_ap:
+    pause                       ; Tasks are the BSP's; an AP just spins
+.pause_done:
+    NEXT
+
+; TASK-RUN - ( xt tcb -- ) Start xt in tcb from empty stacks and link tcb
+; into the ring (a zero TCB_NEXT means unlinked). Not for the running task.
+DEFCODE "TASK-RUN", TASK_RUN, 0
+    pop edx
+    pop eax
+    pushfd
+    cli
+    cmp dword [task_cur], 0
+    jne .tr_multi
+    mov dword [main_task + TCB_NEXT], main_task
+    mov dword [task_cur], main_task
+.tr_multi:
+    mov [edx + TCB_IP0], eax
+    mov dword [edx + TCB_IP0 + 4], TASK_DONE
+    mov ecx, [edx + TCB_S0]
+    sub ecx, TASK_FRAME
+    mov [edx + TCB_SP], ecx
+    lea eax, [edx + TCB_IP0]
+    mov [ecx + 4], eax              ; ESI: start thread
+    mov eax, [edx + TCB_R0]
+    mov [ecx + 8], eax              ; EBP: empty return stack
+    mov dword [ecx + 32], 0x202     ; EFLAGS: IF
+    mov dword [ecx + 36], task_entry
+    mov dword [edx + TCB_STATE], TASK_READY
+    cmp dword [edx + TCB_NEXT], 0
+    jne .tr_linked
+    mov eax, [task_cur]
+    mov ecx, [eax + TCB_NEXT]
+    mov [edx + TCB_NEXT], ecx
+    mov [eax + TCB_NEXT], edx
+.tr_linked:
+    popfd
+    NEXT
+
+; TASK-DONE - ( -- ) End of a task's start thread: stop it for good
+DEFCODE "TASK-DONE", TASK_DONE, 0
+    mov eax, [task_cur]
+    cmp eax, main_task
+    je .td_main
+    mov dword [eax + TCB_STATE], TASK_STOP
+    call task_switch
+    jmp code_TASK_DONE
+.td_main:
+    NEXT
+
+; TASK - ( -- addr ) Current TCB, 0 while tasks are off
+DEFVAR "TASK", TASK_VAR, task_cur
+
+; MAIN-TASK - ( -- tcb ) The interpreter's TCB
+DEFCONST "MAIN-TASK", MAIN_TASK_CONST, main_task
+
+; TASK-SWITCHES - ( -- addr ) Context switches so far
+DEFVAR "TASK-SWITCHES", TASK_SWITCHES, task_switches
+
+; --- Atomics ---
+; Locked read-modify-write for cells shared with the APs (and with IRQ
+; hooks). Plain @ and ! stay atomic for aligned cells.
+
+; XADD - ( n addr -- old ) Add n to the cell; returns its old contents
+DEFCODE "XADD", XADD, 0
+    pop edx
+    pop eax
+    lock xadd [edx], eax
+    push eax
+    NEXT
+
+; CAS - ( old new addr -- flag ) Store new if the cell still holds old
+DEFCODE "CAS", CAS, 0
+    pop edx
+    pop ecx
+    pop eax
+    lock cmpxchg [edx], ecx
+    sete al
+    movzx eax, al
+    neg eax
+    push eax
+    NEXT
+
+; XCHG - ( x addr -- old ) Swap x into the cell
+DEFCODE "XCHG", XCHG, 0
+    pop edx
+    pop eax
+    xchg [edx], eax             ; Implicitly locked
+    push eax
+    NEXT
+
+; SPIN-LOCK - ( addr -- ) Take a lock cell (0 = free); spins on reads
+DEFCODE "SPIN-LOCK", SPIN_LOCK, 0
+    pop edx
+.sl_try:
+    mov eax, 1
+    xchg [edx], eax
+    test eax, eax
+    jz .sl_done
+.sl_wait:
+    pause
+    cmp dword [edx], 0
+    jne .sl_wait
+    jmp .sl_try
+.sl_done:
+    NEXT
+
+; SPIN-UNLOCK - ( addr -- )
+DEFCODE "SPIN-UNLOCK", SPIN_UNLOCK, 0
+    pop edx
+    mov dword [edx], 0
+    NEXT
+
+; --- Application processors ---
+; Only the BSP interprets: the system variables at 0x28000 (STATE, HERE,
+; BASE, TIB...) are its own. Code run on an AP keeps to its own stacks,
+; its CPU block and memory it shares through the atomics above.
+
+; CPU - ( -- addr ) The running CPU's block in CPU-TABLE
+DEFCODE "CPU", CPU, 0
+    call cpu_index
+    imul eax, eax, PCPU_SIZE
+    add eax, cpu_table
+    push eax
+    NEXT
+
+; CPU# - ( -- n ) The running CPU's number, 0 = BSP
+DEFCODE "CPU#", CPU_NUM, 0
+    call cpu_index
+    push eax
+    NEXT
+
+; CPU-TABLE - ( -- addr ) CPU_MAX blocks of PCPU_SIZE bytes
+DEFCONST "CPU-TABLE", CPU_TABLE_CONST, cpu_table
+
+; #CPUS - ( -- addr ) CPUs that have started, the BSP included
+DEFVAR "#CPUS", NCPUS, cpu_count
+
+; LAPIC - ( -- addr ) Local APIC base (SMP sets it from the MADT)
+DEFVAR "LAPIC", LAPIC_VAR, lapic_base
+
+; AP-TRAMPOLINE - ( -- vector ) Install the AP start code at AP_BOOT;
+; returns the STARTUP IPI vector
+DEFCODE "AP-TRAMPOLINE", AP_TRAMPOLINE, 0
+    push esi
+    mov esi, ap_trampoline
+    mov edi, AP_BOOT
+    mov ecx, ap_trampoline_end - ap_trampoline
+    cld
+    rep movsb
+    pop esi
+    push dword AP_BOOT >> 12
+    NEXT
+
+; CPU-PARK - ( -- ) End of an AP's thread: wait for the next xt
+DEFCODE "CPU-PARK", CPU_PARK, 0
+    call cpu_index
+    test eax, eax
+    jz .cp_bsp
+    imul edi, eax, PCPU_SIZE
+    add edi, cpu_table
+    jmp ap_park
+.cp_bsp:
+    NEXT
+
+; KB-RING-BUF - ( -- addr ) Address of keyboard scancode ring buffer
+DEFCONST "KB-RING-BUF", KB_RING_BUF_CONST, kb_ring_buf
+
+; KB-RING-TAIL - ( -- addr ) Address of ring buffer tail (read position)
 DEFVAR "KB-RING-TAIL", KB_RING_TAIL, kb_ring_tail
 
 ; KB-RING-COUNT - ( -- addr ) Address of ring buffer count
 DEFVAR "KB-RING-COUNT", KB_RING_COUNT, kb_ring_count
 
+; SERIAL-IRQ - ( -- addr ) -1 while COM1 console I/O runs on IRQ4 rings
+DEFVAR "SERIAL-IRQ", SERIAL_IRQ, ser_irq_on
+
+; SERIAL-LOST - ( -- addr ) Received bytes dropped on a full SER_RX_RING
+DEFVAR "SERIAL-LOST", SERIAL_LOST, ser_rx_lost
+
+; SERIAL-IRQ-ON - ( -- ) Interrupt-driven COM1 console (the boot default)
+DEFCODE "SERIAL-IRQ-ON", SERIAL_IRQ_ON, 0
+    call serial_irq_init_
+    NEXT
+
+; SERIAL-IRQ-OFF - ( -- ) Drain the transmit ring, back to polled COM1
+; (for code that programs the UART itself)
+DEFCODE "SERIAL-IRQ-OFF", SERIAL_IRQ_OFF, 0
+    call serial_drain_
+    cmp byte [serial_present], 0
+    je .done
+    cli
+    mov dword [ser_irq_on], 0
+    mov byte [ser_tx_armed], 0
+    mov dx, COM1_PORT + 1
+    xor al, al
+    out dx, al                  ; IER: nothing
+    in al, PIC1_DATA
+    or al, 1 << COM1_IRQ
+    out PIC1_DATA, al
+    sti
+.done:
+    NEXT
+
+; SERIAL-DRAIN - ( -- ) Wait until all queued console output has left COM1
+DEFCODE "SERIAL-DRAIN", SERIAL_DRAIN, 0
+    call serial_drain_
+    NEXT
+
 ; MOUSE-PKT-BUF - ( -- addr ) Address of 3-byte mouse packet buffer
 DEFCONST "MOUSE-PKT-BUF", MOUSE_PKT_BUF_CONST, mouse_pkt_buf
 
@@ -3182,12 +4821,27 @@ DEFVAR "NET-HDR", NET_HDR_VAR, net_frame_hdr
 ; NET-RTL-BASE - ( -- addr ) Kernel copy of RTL-BASE for net_flush
 DEFVAR "NET-RTL-BASE", NET_RTL_BASE_VAR, net_rtl_base
 
-; NET-TX-DESC - ( -- addr ) Kernel copy of TX descriptor address
+; NET-TX-DESC - ( -- addr ) Kernel copy of TX descriptor ring address
 DEFVAR "NET-TX-DESC", NET_TX_DESC_VAR, net_tx_desc
 
-; NET-TX-BUF - ( -- addr ) Kernel copy of TX buffer address
+; NET-TX-BUF - ( -- addr ) Kernel copy of TX buffer address (slot 0)
 DEFVAR "NET-TX-BUF", NET_TX_BUF_VAR, net_tx_buf
 
+; NET-TX-N - ( -- addr ) Descriptors in the TX ring, 1-4 (default 1)
+DEFVAR "NET-TX-N", NET_TX_N_VAR, net_tx_n
+
+; NET-TX-KIND - ( -- addr ) How net_flush hands a slot to the NIC:
+; 0 = RTL8168 descriptors (default), 1 = RTL8139 registers (always 4 slots)
+DEFVAR "NET-TX-KIND", NET_TX_KIND_VAR, net_tx_kind
+
+; NET-TX-SLOT - ( -- addr ) Slot being filled; the driver zeroes it when
+; it resets the chip's TX ring
+DEFVAR "NET-TX-SLOT", NET_TX_SLOT_VAR, net_tx_slot
+
+; NET-CON-MAX - ( -- addr ) Payload bytes that force a flush (default 256,
+; capped at 1472)
+DEFVAR "NET-CON-MAX", NET_CON_MAX_VAR, net_con_max
+
 ; ECHOPORT kernel trace variables
 DEFCODE "TRACE-ENABLED", TRACE_ENABLED_W, 0  ; ( -- addr )
     push trace_enabled
@@ -3201,16 +4855,69 @@ DEFCODE "TRACE-COUNT", TRACE_COUNT_W, 0     ; ( -- addr )
     push trace_count
     NEXT
 
-DEFCODE "TRACE-BUF", TRACE_BUF_W, 0         ; ( -- addr )
-    push trace_buf
+DEFCODE "TRACE-BUF", TRACE_BUF_W, 0         ; ( -- addr ) current ring
+    push dword [trace_base]
     NEXT
 
 DEFCODE "TRACE-ENTRY-SZ", TRACE_ENTRY_SZ_W, 0  ; ( -- n )
     push TRACE_ENTRY_SZ
     NEXT
 
-DEFCODE "TRACE-BUF-SIZE", TRACE_BUF_SIZE_W, 0  ; ( -- n )
-    push TRACE_BUF_SIZE
+DEFCODE "TRACE-BUF-SIZE", TRACE_BUF_SIZE_W, 0  ; ( -- n ) entries in ring
+    mov eax, [trace_mask]
+    inc eax
+    push eax
+    NEXT
+
+; TRACE-TAIL - ( -- addr ) Oldest entry still in the ring (entries up to
+; TRACE-HEAD are unread); a consumer advances it
+DEFCODE "TRACE-TAIL", TRACE_TAIL_W, 0
+    push trace_tail
+    NEXT
+
+; TRACE-LOST - ( -- addr ) Entries overwritten because the ring was full
+; and no TRACE-DRAIN xt was set
+DEFCODE "TRACE-LOST", TRACE_LOST_W, 0
+    push trace_lost
+    NEXT
+
+; TRACE-DRAIN - ( -- addr ) xt ( -- ) run from the key-wait idle loop
+; while entries are pending, and when the ring fills outside interrupt
+; context, with tracing off. It should handle a bounded chunk, advance
+; TRACE-TAIL past it and be stack-neutral. 0 = wrap.
+DEFCODE "TRACE-DRAIN", TRACE_DRAIN_W, 0
+    push trace_drain
+    NEXT
+
+; TRACE-FILTERS - ( -- addr ) TRACE_FILTERS port ranges, [lo:2][hi:2]
+; each, inclusive. Only the first TRACE-#FILT are checked.
+DEFCODE "TRACE-FILTERS", TRACE_FILTERS_W, 0
+    push trace_filt
+    NEXT
+
+; TRACE-#FILT - ( -- addr ) Ranges in use; 0 = trace every port
+DEFCODE "TRACE-#FILT", TRACE_NFILT_W, 0
+    push trace_nfilt
+    NEXT
+
+; TRACE-RING! - ( addr n -- ) Trace into n entries at addr (n a power of
+; two) and empty the ring. 0 0 goes back to the boot ring.
+DEFCODE "TRACE-RING!", TRACE_RING_STORE, 0
+    pop ecx
+    pop eax
+    test eax, eax
+    jnz .tr_set
+    mov eax, trace_buf
+    mov ecx, TRACE_BUF_SIZE
+.tr_set:
+    pushfd                      ; Keep the caller's IF (INT-SAVE, hooks)
+    cli
+    mov [trace_base], eax
+    dec ecx
+    mov [trace_mask], ecx
+    mov eax, [trace_head]
+    mov [trace_tail], eax
+    popfd
     NEXT
 
 ; ============================================================================
@@ -3235,6 +4942,7 @@ DEFCONST "ADDR-COLD-START", ADDR_COLD_START, cold_start
 DEFCONST "ADDR-EMBED-SIZE", ADDR_EMBED_SIZE, embed_size
 DEFCONST "ADDR-TIB", ADDR_TIB, VAR_TIB
 DEFCONST "ADDR-TOIN", ADDR_TOIN, VAR_TOIN
+DEFCONST "ADDR-FORTH-LATEST", ADDR_FORTH_LATEST, VAR_FORTH_LATEST
 DEFCONST "ADDR-STRING-BUF", ADDR_STRING_BUF, string_buffer
 DEFCONST "BLOCKS-LBA-BASE", BLOCKS_LBA_BASE_CONST, BLOCKS_LBA_BASE
 
@@ -3451,6 +5159,468 @@ print_hex_word:
     ret
 
 
+; ----------------------------------------------------------------------------
+; has_cpuid - ZF clear if EFLAGS.ID toggles (CPUID present). EAX, ECX
+; clobbered.
+; ----------------------------------------------------------------------------
+has_cpuid:
+    pushfd
+    pop eax
+    mov ecx, eax
+    xor eax, 0x200000
+    push eax
+    popfd
+    pushfd
+    pop eax
+    push ecx
+    popfd
+    xor eax, ecx
+    test eax, 0x200000
+    ret
+
+; ----------------------------------------------------------------------------
+; init_tsc - Count TSC cycles over a 10ms PIT channel 2 one-shot (mode 0:
+; OUT2, port 0x61 bit 5, rises at terminal count) and set tsc_khz. No
+; TSC, or no OUT2 edge within the poll cap, leaves tsc_khz at 0. Runs
+; with interrupts off.
+; ----------------------------------------------------------------------------
+init_tsc:
+    pushad
+    call has_cpuid
+    jz .done
+    mov eax, 1
+    cpuid
+    test edx, 1 << 4            ; TSC
+    jz .done
+    in al, 0x61
+    and al, 0xFC                ; Speaker off
+    or al, 0x01                 ; Channel 2 gate on
+    out 0x61, al
+    mov al, 0xB0                ; Channel 2, lo/hi byte, mode 0
+    out 0x43, al
+    mov al, PIT_CAL_COUNT & 0xFF
+    out 0x42, al
+    mov al, PIT_CAL_COUNT >> 8
+    out 0x42, al
+    rdtsc
+    mov esi, eax
+    mov edi, edx
+    mov ecx, 1000000            ; Poll cap
+.poll:
+    in al, 0x61
+    test al, 0x20
+    jnz .expired
+    dec ecx
+    jnz .poll
+    jmp .done
+.expired:
+    rdtsc
+    sub eax, esi
+    sbb edx, edi
+    jnz .done                   ; Implausible
+    xor edx, edx
+    mov ecx, PIT_CAL_MS
+    div ecx
+    mov [tsc_khz], eax
+.done:
+    popad
+    ret
+
+; ----------------------------------------------------------------------------
+; tsc_cycles_ - EAX microseconds to TSC cycles, saturating at 2^32-1
+; (0 without a calibrated TSC). Clobbers EDX.
+; ----------------------------------------------------------------------------
+tsc_cycles_:
+    push ecx
+    mul dword [tsc_khz]         ; EDX:EAX = us * kHz
+    mov ecx, 1000
+    cmp edx, ecx
+    jae .clamp
+    div ecx
+    pop ecx
+    ret
+.clamp:
+    mov eax, -1
+    pop ecx
+    ret
+
+; ----------------------------------------------------------------------------
+; tsc_deadline_ - Arm tsc_deadline EAX microseconds from now
+; tsc_past_ - CF set once the TSC has passed tsc_deadline
+; Both need tsc_khz != 0. tsc_deadline_ clobbers EAX, EDX; tsc_past_
+; preserves all registers.
+; ----------------------------------------------------------------------------
+tsc_deadline_:
+    push ecx
+    call tsc_cycles_
+    mov ecx, eax
+    rdtsc
+    add eax, ecx
+    adc edx, 0
+    mov [tsc_deadline], eax
+    mov [tsc_deadline + 4], edx
+    pop ecx
+    ret
+
+tsc_past_:
+    push eax
+    push edx
+    rdtsc
+    sub eax, [tsc_deadline]
+    sbb edx, [tsc_deadline + 4]
+    cmc                         ; CF = no borrow = now >= deadline
+    pop edx
+    pop eax
+    ret
+
+; ----------------------------------------------------------------------------
+; boot_stamp_ - Record the 64-bit TSC in boot_tsc slot EAX (BOOT-US).
+; Does nothing without a calibrated TSC. Clobbers EAX.
+; ----------------------------------------------------------------------------
+boot_stamp_:
+    cmp dword [tsc_khz], 0
+    je .done
+    push edx
+    push eax
+    rdtsc
+    xchg eax, [esp]             ; EAX = slot, [ESP] = TSC low
+    lea eax, [boot_tsc + eax*8]
+    pop dword [eax]
+    mov [eax + 4], edx
+    pop edx
+.done:
+    ret
+
+; ----------------------------------------------------------------------------
+; init_erms - Set erms_ok when CPUID leaf 7 reports ERMSB (fast rep
+; movsb / stosb at any alignment)
+; ----------------------------------------------------------------------------
+init_erms:
+    pushad
+    call has_cpuid
+    jz .er_done
+    xor eax, eax
+    cpuid
+    cmp eax, 7
+    jb .er_done
+    mov eax, 7
+    xor ecx, ecx
+    cpuid
+    test ebx, 1 << 9            ; ERMSB
+    jz .er_done
+    mov dword [erms_ok], -1
+.er_done:
+    popad
+    ret
+
+; ----------------------------------------------------------------------------
+; init_sse - Turn on SSE (CR0.EM off, CR0.MP on, CR4.OSFXSR/OSXMMEXCPT)
+; when CPUID reports SSE2 and FXSR; sets sse2_ok. Only copy_fwd (CMOVE,
+; MOVE) and fill_cells_nt (LFB-FILL, LFB-RECT) use the XMM registers.
+; Tasks switch only between words; isr_run_xt saves XMM state around IRQ
+; and MSI hooks, which may MOVE.
+; ----------------------------------------------------------------------------
+init_sse:
+    pushad
+    call has_cpuid
+    jz .sse_done
+    mov eax, 1
+    cpuid
+    test edx, 1 << 26           ; SSE2
+    jz .sse_done
+    test edx, 1 << 24           ; FXSR
+    jz .sse_done
+    clts
+    mov eax, cr0
+    and eax, ~0x4               ; EM = 0
+    or eax, 0x2                 ; MP = 1
+    mov cr0, eax
+    mov eax, cr4
+    or eax, 0x600               ; OSFXSR | OSXMMEXCPT
+    mov cr4, eax
+    mov dword [sse2_ok], -1
+.sse_done:
+    popad
+    ret
+
+; ----------------------------------------------------------------------------
+; init_paging - Identity-map all 4GB with 4MB pages at PAGE_DIR and turn on
+; CR4.PSE + CR0.PG; sets paging_on. Addresses do not change, so nothing
+; else notices. With PAT, entry 4 (PDE_PAT alone) becomes write-combining
+; for LFB-WC and pat_ok is set. No-op without CPUID PSE or when already on.
+; ----------------------------------------------------------------------------
+init_paging:
+    pushad
+    cmp dword [paging_on], 0
+    jne .pg_done
+    call has_cpuid
+    jz .pg_done
+    mov eax, 1
+    cpuid
+    test edx, 1 << 3            ; PSE
+    jz .pg_done
+    mov ebx, edx
+    cld
+    mov edi, PAGE_DIR
+    mov eax, PDE_4M
+    mov ecx, 1024
+.pg_fill:
+    stosd
+    add eax, 0x400000
+    loop .pg_fill
+    test ebx, 1 << 16           ; PAT
+    jz .pg_nopat
+    mov dword [pat_ok], -1
+.pg_nopat:
+    pushfd
+    cli
+    call paging_cpu
+    popfd
+    mov dword [paging_on], -1
+.pg_done:
+    popad
+    ret
+
+; paging_cpu - The per-CPU half of init_paging (APs run it too): PAT entry
+; 4 when pat_ok, then CR3, CR4.PSE and CR0.PG. EAX, ECX, EDX clobbered.
+paging_cpu:
+    cmp dword [pat_ok], 0
+    je .pc_nopat
+    mov ecx, IA32_PAT
+    rdmsr
+    and edx, 0xFFFFFF00
+    or edx, PAT_WC
+    wrmsr
+.pc_nopat:
+    mov eax, PAGE_DIR
+    mov cr3, eax
+    mov eax, cr4
+    or eax, CR4_PSE
+    mov cr4, eax
+    mov eax, cr0
+    or eax, CR0_PG
+    mov cr0, eax
+    ret
+
+; ----------------------------------------------------------------------------
+; tlb_flush_ - After a memory type change: write back and invalidate the
+; caches, then reload CR3 to drop this CPU's TLB. No-op with paging off.
+; Clobbers: EAX
+; ----------------------------------------------------------------------------
+tlb_flush_:
+    cmp dword [paging_on], 0
+    je .tf_done
+    wbinvd
+    mov eax, cr3
+    mov cr3, eax
+.tf_done:
+    ret
+
+; ----------------------------------------------------------------------------
+; task_switch - Save the running task (EFLAGS, registers, return address on
+; its own data stack) and resume the next ready task in the ring; sleepers
+; whose wake tick has passed become ready. Halts for an interrupt when no
+; task is ready, unless the caller has interrupts off (INT-SAVE): then no
+; tick can wake anyone and it returns at once. Returns when this task is
+; picked again. Needs task_cur.
+; ----------------------------------------------------------------------------
+task_switch:
+    pushfd
+    pushad
+    mov edx, [task_cur]
+    mov [edx + TCB_SP], esp
+    mov eax, edx
+.ts_next:
+    mov eax, [eax + TCB_NEXT]
+    mov ecx, [eax + TCB_STATE]
+    cmp ecx, TASK_READY
+    je .ts_run
+    cmp ecx, TASK_SLEEP
+    jne .ts_skip
+    mov ecx, [isr_tick_count]
+    sub ecx, [eax + TCB_WAKE]
+    js .ts_skip
+    mov dword [eax + TCB_STATE], TASK_READY
+    jmp .ts_run
+.ts_skip:
+    cmp eax, edx
+    jne .ts_next
+    test dword [esp + 32], 0x200 ; Caller's IF, saved by pushfd
+    jz .ts_same                 ; Critical section: never turn IF on
+    sti                         ; Nobody ready: wait for a tick or an IRQ
+    hlt
+    jmp .ts_next
+.ts_run:
+    cmp eax, edx
+    je .ts_same
+    inc dword [task_switches]
+    mov [task_cur], eax
+    mov esp, [eax + TCB_SP]
+.ts_same:
+    popad
+    popfd
+    ret
+
+; task_entry - First return of a new task's frame: start its thread
+task_entry:
+    NEXT
+
+; ----------------------------------------------------------------------------
+; task_idle - Give the CPU to another ready task; halt until an interrupt
+; if there is none (or tasks are off) and interrupts are on.
+; ----------------------------------------------------------------------------
+task_idle:
+    push eax
+    call cpu_index
+    test eax, eax
+    pop eax
+    jnz .ti_ap
+    cmp dword [task_cur], 0
+    je .ti_halt
+    push eax
+    mov eax, [task_switches]
+    call task_switch
+    cmp eax, [task_switches]
+    pop eax
+    jne .ti_done
+.ti_halt:
+    push eax
+    pushfd
+    pop eax
+    test eax, 0x200
+    pop eax
+    jz .ti_done                 ; IF off: hlt would never wake
+    hlt
+.ti_done:
+    ret
+.ti_ap:
+    pause                       ; APs take no interrupts: spin instead
+    ret
+
+; ----------------------------------------------------------------------------
+; cpu_index - EAX = number of the running CPU (0 = BSP). Reads the local
+; APIC ID only once an AP has started, so single-CPU use costs nothing.
+; ----------------------------------------------------------------------------
+cpu_index:
+    xor eax, eax
+    cmp dword [cpu_count], 1
+    jbe .ci_done
+    mov eax, [lapic_base]
+    mov eax, [eax + LAPIC_ID]
+    shr eax, 24
+    movzx eax, byte [cpu_by_apic + eax]
+.ci_done:
+    ret
+
+; ----------------------------------------------------------------------------
+; stack_s0_ - EAX = top of the data stack in use: the current task's TCB_S0
+; on the BSP, else this CPU's PCPU_S0 (MAIN-TASK's TCB_S0 is 0, it runs on
+; the boot stack in CPU 0's block). Clobbers: EAX
+; ----------------------------------------------------------------------------
+stack_s0_:
+    call cpu_index
+    test eax, eax
+    jnz .cpu
+    mov eax, [task_cur]
+    test eax, eax
+    jz .cpu
+    mov eax, [eax + TCB_S0]
+    test eax, eax
+    jnz .done
+.cpu:
+    imul eax, eax, PCPU_SIZE
+    mov eax, [cpu_table + eax + PCPU_S0]
+.done:
+    ret
+
+; ----------------------------------------------------------------------------
+; ap_trampoline - Copied to AP_BOOT by AP-TRAMPOLINE; a STARTUP IPI starts
+; an AP here in real mode with CS = AP_BOOT >> 4. Loads a flat GDT with
+; the boot sector's selectors and jumps to ap_entry in protected mode.
+; ----------------------------------------------------------------------------
+[BITS 16]
+ap_trampoline:
+    cli
+    cld
+    mov ax, cs
+    mov ds, ax
+    lgdt [apt_gdtr - ap_trampoline]
+    mov eax, cr0
+    or al, 1
+    mov cr0, eax
+    jmp dword 0x08:ap_entry
+apt_gdt:
+    dq 0
+    dq 0x00CF9A000000FFFF       ; 0x08: code, ring 0, 4GB
+    dq 0x00CF92000000FFFF       ; 0x10: data, ring 0, 4GB
+apt_gdtr:
+    dw 3 * 8 - 1
+    dd AP_BOOT + apt_gdt - ap_trampoline
+ap_trampoline_end:
+[BITS 32]
+
+; ----------------------------------------------------------------------------
+; ap_entry - An AP in protected mode: take the next CPU number, load its
+; stacks from cpu_table (SMP fills them first), share the IDT, SSE and
+; paging setup, then park until SMP hands it an xt. No interrupts.
+; ----------------------------------------------------------------------------
+ap_entry:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+    lidt [idt_descriptor]
+    ; Take the next CPU number only if it has a block and stacks, so a
+    ; parked AP never counts in #CPUS; another AP may race us to it
+.ap_claim:
+    mov eax, [cpu_count]
+    cmp eax, CPU_MAX
+    jae .ap_dead
+    imul edi, eax, PCPU_SIZE
+    add edi, cpu_table
+    cmp dword [edi + PCPU_S0], 0
+    je .ap_dead                 ; No stacks: nothing to run on
+    lea ecx, [eax + 1]
+    lock cmpxchg [cpu_count], ecx
+    jne .ap_claim
+    mov esp, [edi + PCPU_S0]
+    mov [edi + PCPU_NUM], eax
+    mov ecx, [lapic_base]
+    mov ecx, [ecx + LAPIC_ID]
+    shr ecx, 24
+    mov [edi + PCPU_APIC], ecx
+    mov [cpu_by_apic + ecx], al
+    call init_sse
+    cmp dword [paging_on], 0
+    je ap_park
+    call paging_cpu
+    jmp ap_park
+.ap_dead:
+    cli
+    hlt
+    jmp .ap_dead
+
+; ap_park - EDI = this AP's block. Wait for an xt in PCPU_XT, then run it
+; from empty stacks as the thread [xt][CPU-PARK].
+ap_park:
+    mov dword [edi + PCPU_STATE], CPU_IDLE
+.ap_wait:
+    pause
+    mov eax, [edi + PCPU_XT]
+    test eax, eax
+    jz .ap_wait
+    mov dword [edi + PCPU_XT], 0
+    mov [edi + PCPU_IP0], eax
+    mov dword [edi + PCPU_IP0 + 4], CPU_PARK
+    mov esp, [edi + PCPU_S0]
+    sub esp, TOS_SLOT
+    mov ebp, [edi + PCPU_R0]
+    lea esi, [edi + PCPU_IP0]
+    mov dword [edi + PCPU_STATE], CPU_RUN
+    NEXT
+
 ; ----------------------------------------------------------------------------
 ; init_pic - Remap PIC and mask all IRQs
 ; IRQ 0-7 -> INT 0x20-0x27, IRQ 8-15 -> INT 0x28-0x2F
@@ -3493,7 +5663,10 @@ init_pic:
 ; ----------------------------------------------------------------------------
 ; init_idt - Build 256-entry IDT at IDT_BASE, load IDTR
 ; Default: all entries point to isr_default (just iret)
-; Specific: IRQ0 (timer), IRQ1 (keyboard), IRQ12 (mouse)
+; Specific: IRQ0 (timer), IRQ1 (keyboard), IRQ4 (COM1), IRQ12 (mouse); the
+; other device
+; IRQs get isr_hook_N stubs that dispatch through ISR_HOOK_TABLE, and
+; vectors MSI_VEC_BASE.. get isr_msi_N stubs (MSI_HOOK_TABLE)
 ; ----------------------------------------------------------------------------
 init_idt:
     push eax
@@ -3533,6 +5706,13 @@ init_idt:
     shr eax, 16
     mov word [edi+6], ax
 
+    ; IRQ4 (INT 0x24) - COM1
+    mov eax, isr_serial
+    mov edi, IDT_BASE + (IRQ_BASE_MASTER + COM1_IRQ) * IDT_ENTRY_SIZE
+    mov word [edi], ax
+    shr eax, 16
+    mov word [edi+6], ax
+
     ; IRQ12 (INT 0x2C) - Mouse
     mov eax, isr_mouse
     mov edi, IDT_BASE + (IRQ_BASE_SLAVE + 4) * IDT_ENTRY_SIZE
@@ -3540,6 +5720,34 @@ init_idt:
     shr eax, 16
     mov word [edi+6], ax
 
+    ; Remaining device IRQs - dispatch through ISR_HOOK_TABLE
+    ; (IRQ n -> INT 0x20+n on both PICs)
+    xor ecx, ecx
+.hook_stubs:
+    mov eax, [isr_hook_stubs + ecx*4]
+    test eax, eax
+    jz .hook_next               ; Kernel-owned IRQ
+    lea edi, [IDT_BASE + (IRQ_BASE_MASTER * IDT_ENTRY_SIZE) + ecx*IDT_ENTRY_SIZE]
+    mov word [edi], ax
+    shr eax, 16
+    mov word [edi+6], ax
+.hook_next:
+    inc ecx
+    cmp ecx, 16
+    jb .hook_stubs
+
+    ; Message-signalled interrupts - dispatch through MSI_HOOK_TABLE
+    xor ecx, ecx
+.msi_stubs:
+    mov eax, [isr_msi_stubs + ecx*4]
+    lea edi, [IDT_BASE + (MSI_VEC_BASE * IDT_ENTRY_SIZE) + ecx*IDT_ENTRY_SIZE]
+    mov word [edi], ax
+    shr eax, 16
+    mov word [edi+6], ax
+    inc ecx
+    cmp ecx, MSI_SLOTS
+    jb .msi_stubs
+
     ; Load IDTR
     lidt [idt_descriptor]
 
@@ -3563,6 +5771,9 @@ init_idt:
     add edi, 4
     dec ecx
     jnz .clear_hooks
+    mov edi, MSI_HOOK_TABLE
+    mov ecx, MSI_SLOTS
+    rep stosd
 
     pop edi
     pop edx
@@ -3584,18 +5795,148 @@ isr_default:
 
 ; ----------------------------------------------------------------------------
 ; ISR: Timer (IRQ0 / INT 0x20)
-; Increments tick counter, sends EOI to master PIC
+; Increments tick counter, takes a profiler sample when PROF-SAMPLING is
+; set, sends EOI to master PIC
 ; ----------------------------------------------------------------------------
 isr_timer:
     pushad
     inc dword [isr_tick_count]
+    cmp dword [prof_sampling], 0
+    je .no_sample
+    mov edi, [prof_head]
+    and edi, PROF_RING_SIZE - 1
+    mov eax, [esp + 4]          ; Interrupted ESI (pushad frame)
+    mov [PROF_RING + edi*8], eax
+    mov eax, [esp + 32]         ; Interrupted EIP (interrupt frame)
+    mov [PROF_RING + edi*8 + 4], eax
+    inc dword [prof_head]
+.no_sample:
+    ; Net console: send a partial frame once it is NET_CON_TICKS old.
+    ; net_flushing is also set while print_char appends, so a flush
+    ; never runs underneath it.
+    cmp byte [net_console_enabled], 0
+    je .no_net_age
+    cmp byte [net_flushing], 0
+    jne .no_net_age
+    cmp dword [net_buf_pos], 0
+    je .no_net_age
+    mov eax, [isr_tick_count]
+    sub eax, [net_first_tick]
+    cmp eax, NET_CON_TICKS
+    jb .no_net_age
+    call net_flush
+.no_net_age:
     mov al, PIC_EOI
     out PIC1_CMD, al            ; EOI to master PIC
     popad
     iret
 
 ; ----------------------------------------------------------------------------
-; ISR: Keyboard (IRQ1 / INT 0x21)
+; ISR: Hooked device IRQs (IRQ-CONNECT in HARDWARE)
+; Runs the XT in ISR_HOOK_TABLE[irq] through execute_xt on the interrupted
+; data and return stacks, then sends EOI (slave first for IRQ 8-15). The
+; hook must be stack-neutral and must quiet its device before returning,
+; since PCI interrupts are level-triggered. Interrupts stay off throughout.
+; ----------------------------------------------------------------------------
+%macro ISR_HOOK_STUB 1
+isr_hook_%1:
+    pushad
+    mov ebx, %1
+    jmp isr_hook_common
+%endmacro
+
+ISR_HOOK_STUB 3
+ISR_HOOK_STUB 5
+ISR_HOOK_STUB 6
+ISR_HOOK_STUB 7
+ISR_HOOK_STUB 8
+ISR_HOOK_STUB 9
+ISR_HOOK_STUB 10
+ISR_HOOK_STUB 11
+ISR_HOOK_STUB 13
+ISR_HOOK_STUB 14
+ISR_HOOK_STUB 15
+
+isr_hook_common:
+    mov eax, [ISR_HOOK_TABLE + ebx*4]
+    test eax, eax
+    jz .eoi
+    call isr_run_xt
+.eoi:
+    mov al, PIC_EOI
+    cmp ebx, 8
+    jb .master
+    out PIC2_CMD, al            ; EOI to slave PIC
+.master:
+    out PIC1_CMD, al            ; EOI to master PIC
+    popad
+    iret
+
+; isr_run_xt - Run hook XT in EAX with EBX (IRQ# or MSI slot#) kept
+; across it. Hooks may MOVE (RTL-RX-FILL does), and copy_fwd runs on
+; XMM0-3, so the interrupted code's SSE state is parked at ISR_FX_SAVE
+; for the call. Hook ISRs keep IF clear and so never nest.
+isr_run_xt:
+    cmp dword [sse2_ok], 0
+    je .run
+    fxsave [ISR_FX_SAVE]
+.run:
+    push ebx                    ; Forth code owns EBX
+    call execute_xt
+    pop ebx
+    cmp dword [sse2_ok], 0
+    je .done
+    fxrstor [ISR_FX_SAVE]
+.done:
+    ret
+
+; IDT stub per IRQ; 0 = handled by a dedicated kernel ISR (or cascade)
+align 4
+isr_hook_stubs:
+    dd 0, 0, 0, isr_hook_3, 0, isr_hook_5, isr_hook_6, isr_hook_7
+    dd isr_hook_8, isr_hook_9, isr_hook_10, isr_hook_11
+    dd 0, isr_hook_13, isr_hook_14, isr_hook_15
+
+; ----------------------------------------------------------------------------
+; ISR: Message-signalled interrupts (MSI-CONNECT in HARDWARE)
+; Like isr_hook_common, with the slot number on the stack for the XT; an
+; empty slot just EOIs. MSIs are edge-triggered and bypass the 8259s, so
+; the EOI goes to the local APIC.
+; ----------------------------------------------------------------------------
+%macro ISR_MSI_STUB 1
+isr_msi_%1:
+    pushad
+    mov ebx, %1
+    jmp isr_msi_common
+%endmacro
+
+ISR_MSI_STUB 0
+ISR_MSI_STUB 1
+ISR_MSI_STUB 2
+ISR_MSI_STUB 3
+ISR_MSI_STUB 4
+ISR_MSI_STUB 5
+ISR_MSI_STUB 6
+ISR_MSI_STUB 7
+
+isr_msi_common:
+    mov eax, [MSI_HOOK_TABLE + ebx*4]
+    test eax, eax
+    jz .eoi
+    call isr_run_xt
+.eoi:
+    mov eax, [lapic_base]
+    mov dword [eax + LAPIC_EOI], 0
+    popad
+    iret
+
+align 4
+isr_msi_stubs:
+    dd isr_msi_0, isr_msi_1, isr_msi_2, isr_msi_3
+    dd isr_msi_4, isr_msi_5, isr_msi_6, isr_msi_7
+
+; ----------------------------------------------------------------------------
+; ISR: Keyboard (IRQ1 / INT 0x21)
 ; Reads scancode from port 0x60 into 16-byte ring buffer
 ; ----------------------------------------------------------------------------
 isr_keyboard:
@@ -3682,12 +6023,179 @@ isr_mouse:
     popad
     iret
 
+; ----------------------------------------------------------------------------
+; ISR: COM1 (IRQ4 / INT 0x24)
+; Serves the UART until IIR reads "none pending": THR empty refills the
+; transmit FIFO from SER_TX_RING, received data (or FIFO timeout) moves
+; into SER_RX_RING, line / modem status is read to clear it. Then EOI.
+; ----------------------------------------------------------------------------
+isr_serial:
+    pushad
+.next:
+    mov dx, COM1_PORT + 2
+    in al, dx                   ; IIR
+    test al, 1
+    jnz .eoi                    ; Nothing (more) pending
+    and al, 0x0E
+    cmp al, 0x02
+    jne .not_thre
+    call ser_tx_fill_
+    jmp .next
+.not_thre:
+    cmp al, 0x06
+    jne .not_lsr
+    mov dx, COM1_PORT + 5
+    in al, dx                   ; Line status error: reading clears it
+    jmp .next
+.not_lsr:
+    test al, 0x04               ; 0x04 data ready, 0x0C timeout
+    jz .msr
+    call ser_rx_drain_
+    jmp .next
+.msr:
+    mov dx, COM1_PORT + 6
+    in al, dx                   ; Modem status change
+    jmp .next
+.eoi:
+    mov al, PIC_EOI
+    out PIC1_CMD, al            ; EOI to master PIC
+    popad
+    iret
+
+; ----------------------------------------------------------------------------
+; ser_tx_fill_ - Move up to SER_FIFO bytes from SER_TX_RING into the THR
+; Call with interrupts off and the THR empty. Once the ring is empty the
+; THR-empty interrupt is switched off again (ser_tx_armed).
+; Clobbers: EAX, ECX, EDX
+; ----------------------------------------------------------------------------
+ser_tx_fill_:
+    mov ecx, SER_FIFO
+    mov dx, COM1_PORT
+.next:
+    mov eax, [ser_tx_tail]
+    cmp eax, [ser_tx_head]
+    je .empty
+    and eax, SER_TX_SIZE - 1
+    mov al, [SER_TX_RING + eax]
+    out dx, al
+    inc dword [ser_tx_tail]
+    dec ecx
+    jnz .next
+    ret
+.empty:
+    cmp byte [ser_tx_armed], 0
+    je .done
+    mov byte [ser_tx_armed], 0
+    mov dx, COM1_PORT + 1
+    mov al, 0x01                ; IER: received data only
+    out dx, al
+.done:
+    ret
+
+; ----------------------------------------------------------------------------
+; ser_tx_poll_ - Wait for the THR to empty, then refill it (interrupts off)
+; Clobbers: EAX, ECX, EDX
+; ----------------------------------------------------------------------------
+ser_tx_poll_:
+    mov dx, COM1_PORT + 5
+.wait:
+    in al, dx
+    test al, 0x20               ; Transmit buffer empty?
+    jz .wait
+    jmp ser_tx_fill_
+
+; ----------------------------------------------------------------------------
+; ser_rx_drain_ - Move every received byte into SER_RX_RING (interrupts off)
+; A full ring drops the byte and counts it in ser_rx_lost (SERIAL-LOST).
+; Clobbers: EAX, ECX, EDX
+; ----------------------------------------------------------------------------
+ser_rx_drain_:
+    mov dx, COM1_PORT + 5
+    in al, dx
+    test al, 1                  ; Data ready?
+    jz .done
+    mov dx, COM1_PORT
+    in al, dx
+    mov ecx, [ser_rx_head]
+    mov edx, ecx
+    sub edx, [ser_rx_tail]
+    cmp edx, SER_RX_SIZE
+    jb .store
+    inc dword [ser_rx_lost]
+    jmp ser_rx_drain_
+.store:
+    and ecx, SER_RX_SIZE - 1
+    mov [SER_RX_RING + ecx], al
+    inc dword [ser_rx_head]
+    jmp ser_rx_drain_
+.done:
+    ret
+
+; ----------------------------------------------------------------------------
+; serial_irq_init_ - Switch COM1 to interrupt-driven rings (SERIAL-IRQ-ON)
+; Enables the received-data interrupt and unmasks IRQ4; the THR-empty
+; interrupt is only on while SER_TX_RING holds bytes. Clobbers: EAX, EDX
+; ----------------------------------------------------------------------------
+serial_irq_init_:
+    cmp byte [serial_present], 0
+    je .done
+    cmp dword [ser_irq_on], 0
+    jne .done
+    pushfd
+    cli
+    mov byte [ser_tx_armed], 0
+    mov dx, COM1_PORT + 1
+    mov al, 0x01                ; IER: received data
+    out dx, al
+    in al, PIC1_DATA
+    and al, ~(1 << COM1_IRQ)
+    out PIC1_DATA, al
+    mov dword [ser_irq_on], -1
+    popfd
+.done:
+    ret
+
+; ----------------------------------------------------------------------------
+; serial_drain_ - Send everything in SER_TX_RING and wait until the UART
+; has shifted out its last bit. Safe in either mode; preserves registers.
+; ----------------------------------------------------------------------------
+serial_drain_:
+    cmp byte [serial_present], 0
+    je .skip
+    pushfd
+    cli
+    push eax
+    push ecx
+    push edx
+.more:
+    mov eax, [ser_tx_tail]
+    cmp eax, [ser_tx_head]
+    je .idle
+    call ser_tx_poll_
+    jmp .more
+.idle:
+    mov dx, COM1_PORT + 5
+.wait:
+    in al, dx
+    test al, 0x40               ; FIFO and shift register empty?
+    jz .wait
+    pop edx
+    pop ecx
+    pop eax
+    popfd
+.skip:
+    ret
+
 ; ----------------------------------------------------------------------------
 ; serial_putchar - Write character in AL to serial port
+; Polls the THR until isr_serial owns COM1, then queues into SER_TX_RING.
+; Preserves all registers.
 ; ----------------------------------------------------------------------------
 serial_putchar:
     cmp byte [serial_present], 0
     je .skip                ; No COM1 — don't touch serial ports
+    cmp dword [ser_irq_on], 0
+    jne serial_queue_
     push edx
     push eax
     mov dx, COM1_PORT + 5
@@ -3702,15 +6210,75 @@ serial_putchar:
 .skip:
     ret
 
+; ----------------------------------------------------------------------------
+; serial_queue_ - Append AL to SER_TX_RING (interrupt-driven path)
+; Only the first byte of a burst touches the UART: it loads the FIFO if
+; the THR is empty and arms the THR-empty interrupt, which sends the rest.
+; A full ring falls back to polling one FIFO's worth out by hand.
+; Preserves all registers.
+; ----------------------------------------------------------------------------
+serial_queue_:
+    pushfd
+    cli
+    push eax
+    push ecx
+    push edx
+    mov ecx, [ser_tx_head]
+    sub ecx, [ser_tx_tail]
+    cmp ecx, SER_TX_SIZE
+    jb .room
+    call ser_tx_poll_           ; Ring full: make room by polling
+    mov eax, [esp + 8]          ; Character again
+.room:
+    mov ecx, [ser_tx_head]
+    and ecx, SER_TX_SIZE - 1
+    mov [SER_TX_RING + ecx], al
+    inc dword [ser_tx_head]
+    cmp byte [ser_tx_armed], 0
+    jne .out                    ; isr_serial will get to it
+    mov dx, COM1_PORT + 5
+    in al, dx
+    test al, 0x20
+    jz .arm                     ; FIFO still busy
+    call ser_tx_fill_           ; Idle line: start now
+    mov eax, [ser_tx_tail]
+    cmp eax, [ser_tx_head]
+    je .out                     ; All of it fit
+.arm:
+    mov byte [ser_tx_armed], 1
+    mov dx, COM1_PORT + 1
+    mov al, 0x03                ; IER: received data + THR empty
+    out dx, al
+.out:
+    pop edx
+    pop ecx
+    pop eax
+    popfd
+    ret
+
 ; ----------------------------------------------------------------------------
 ; serial_getchar - Read character from serial port into AL (non-blocking)
 ; Returns: AL = char, CF clear = data available, CF set = no data
 ; (Previously used ZF which broke on NULL characters)
+; Bytes isr_serial queued in SER_RX_RING come first; the UART itself is
+; only polled while COM1 runs without interrupts.
 ; ----------------------------------------------------------------------------
 serial_getchar:
     cmp byte [serial_present], 0
     je .no_data             ; No COM1 hardware — skip
     push edx
+    mov edx, [ser_rx_tail]
+    cmp edx, [ser_rx_head]
+    je .poll
+    and edx, SER_RX_SIZE - 1
+    mov al, [SER_RX_RING + edx]
+    inc dword [ser_rx_tail]
+    pop edx
+    clc                     ; CF=0: data available
+    ret
+.poll:
+    cmp dword [ser_irq_on], 0
+    jne .no_data_pop        ; isr_serial will queue it
     mov dx, COM1_PORT + 5
     in al, dx
     test al, 1              ; Data ready?
@@ -3750,39 +6318,36 @@ init_screen:
     ret
 
 ; ----------------------------------------------------------------------------
-; net_flush - Flush net console buffer as UDP packet via RTL8168 TX
-; Called from print_char when LF detected or buffer full.
-; Uses pre-built frame header template at net_frame_hdr (42 bytes).
-; Patches: IP total length, IP ID, IP checksum, UDP length.
-; Synchronous: waits for TxOK in ISR before returning.
+; net_flush - Send the net console frame in the current TX slot
+; Called from print_char (size or aged LF), the prompt, NET-FLUSH and the
+; timer tick once a partial frame is NET_CON_TICKS old.
+; The payload is already in the slot behind the header; copies the 42-byte
+; header template in front of it and patches IP total length, IP ID, IP
+; checksum and UDP length. Hands the descriptor to the NIC and moves to the
+; next slot without waiting: net_slot_wait runs before the next frame's
+; first character lands in that slot.
 ; ----------------------------------------------------------------------------
 net_flush:
     pushad
+    cld                         ; May run from IRQ0 inside a CMOVE>
     mov byte [net_flushing], 1
 
     mov ecx, [net_buf_pos]
     test ecx, ecx
     jz .nf_done
 
-    ; Copy 42-byte header template to TX-BUF
-    mov edi, [net_tx_buf]
+    ; Header template in front of the payload
+    call net_slot_buf           ; EBX = slot buffer
+    mov edi, ebx
     mov esi, net_frame_hdr
     push ecx
-    push edi                    ; save TX-BUF base
-    mov ecx, 42
-    rep movsb
-    ; EDI now at TX-BUF + 42
-
-    ; Copy payload (net_buf) to TX-BUF + 42
-    pop ebx                     ; EBX = TX-BUF base
+    mov ecx, NET_HDR_SIZE / 4
+    rep movsd
+    movsw
     pop ecx                     ; ECX = payload_len
-    mov esi, net_buf
-    push ecx
-    rep movsb
 
     ; Compute frame length (min 60)
-    pop ecx                     ; payload_len
-    lea edx, [ecx + 42]
+    lea edx, [ecx + NET_HDR_SIZE]
     cmp edx, 60
     jge .nf_no_pad
     mov edx, 60
@@ -3838,32 +6403,55 @@ net_flush:
     mov byte [ebx + 24], ah
     mov byte [ebx + 25], al
 
-    ; Set up TX descriptor
+    ; Descriptor for this slot; EOR on the ring's last one
     pop edx                     ; frame_len
-    mov edi, [net_tx_desc]
-    or edx, 0xF0000000          ; OWN + EOR + FS + LS
-    mov [edi], edx              ; opts1
+    cmp dword [net_tx_kind], NET_KIND_8139
+    je .nf_8139
+    or edx, NET_DESC_OWN | NET_DESC_FS_LS
+    mov edi, [net_tx_slot]
+    mov eax, edi
+    shl edi, 4
+    add edi, [net_tx_desc]
+    inc eax
+    cmp eax, [net_tx_n]
+    jae .nf_last
+    cmp eax, NET_TX_SLOTS
+    jb .nf_slot
+.nf_last:
+    or edx, NET_DESC_EOR
+    xor eax, eax
+.nf_slot:
+    mov [net_tx_slot], eax
     mov dword [edi + 4], 0      ; opts2
-    mov [edi + 8], ebx          ; buf addr low (= TX-BUF)
+    mov [edi + 8], ebx          ; buf addr low (= slot buffer)
     mov dword [edi + 12], 0     ; buf addr high
+    mov [edi], edx              ; opts1 last: OWN hands it to the NIC
 
-    ; Clear TX status, trigger TX, wait for wire completion
+    ; Clear stale TX status and kick the NIC; completion is seen by
+    ; net_slot_wait as OWN clearing
     mov eax, [net_rtl_base]
     mov word [eax + 0x3E], 0x000C   ; Clear TxOK + TxErr (w1c)
     mov byte [eax + 0x38], 0x40     ; TxPoll = NPQ
+    jmp .nf_sent
+
+    ; RTL8139: the slot's buffer goes in TSAD n, then the size in TSD n
+    ; with OWN clear starts the send. The chip takes the pairs in order.
+.nf_8139:
+    mov edi, edx
+    and edi, 0x1FFF             ; TSD size field
+    mov ecx, [net_tx_slot]
+    mov edx, [net_rtl_base]
+    lea edx, [edx + ecx*4 + RTL8139_TSAD0]
+    mov eax, ebx
+    out dx, eax
+    sub edx, RTL8139_TSAD0 - RTL8139_TSD0
+    mov eax, edi
+    out dx, eax
+    inc ecx
+    and ecx, NET_TX_SLOTS - 1
+    mov [net_tx_slot], ecx
 
-    ; Wait for TxOK or TxErr (ISR bits 2-3) — frame on wire
-    mov ecx, 100000
-.nf_wait_txok:
-    test word [eax + 0x3E], 0x000C
-    jnz .nf_txdone
-    pause
-    dec ecx
-    jnz .nf_wait_txok
-.nf_txdone:
-    mov word [eax + 0x3E], 0x000C   ; Acknowledge TX status
-    movzx ecx, word [eax + 0x3E]   ; Read-back flushes PCI posted writes
-
+.nf_sent:
     ; Reset buffer
     mov dword [net_buf_pos], 0
 
@@ -3872,36 +6460,95 @@ net_flush:
     popad
     ret
 
+; net_slot_buf - EBX = TX buffer of the current slot
+net_slot_buf:
+    imul ebx, [net_tx_slot], NET_TX_STRIDE
+    add ebx, [net_tx_buf]
+    ret
+
+; net_slot_wait - Wait (bounded) until the NIC is done with the current
+; slot's descriptor. Only stalls when every slot is still in flight.
+net_slot_wait:
+    push eax
+    push ecx
+    mov ecx, 100000
+    cmp dword [net_tx_kind], NET_KIND_8139
+    je .nsw_8139
+    mov eax, [net_tx_slot]
+    shl eax, 4
+    add eax, [net_tx_desc]
+.nsw_poll:
+    test dword [eax], NET_DESC_OWN
+    jz .nsw_done
+    pause
+    dec ecx
+    jnz .nsw_poll
+.nsw_done:
+    pop ecx
+    pop eax
+    ret
+    ; RTL8139: TSD n gets OWN back once the chip has read the buffer
+.nsw_8139:
+    push edx
+    mov edx, [net_tx_slot]
+    shl edx, 2
+    add edx, [net_rtl_base]
+    add edx, RTL8139_TSD0
+.nsw_8139_poll:
+    in eax, dx
+    test eax, RTL8139_TSD_OWN
+    jnz .nsw_8139_done
+    pause
+    dec ecx
+    jnz .nsw_8139_poll
+.nsw_8139_done:
+    pop edx
+    jmp .nsw_done
+
 ; ----------------------------------------------------------------------------
 ; print_char - Print character in AL to both VGA and serial port
 ; ----------------------------------------------------------------------------
 print_char:
     call serial_putchar     ; Mirror to serial port
 
-    ; --- Net console: buffer char for UDP ---
+    ; --- Net console: append char to the current TX slot ---
     cmp byte [net_console_enabled], 0
     je .no_net
     cmp byte [net_flushing], 0
     jne .no_net
+    cmp dword [net_tx_buf], 0
+    je .no_net
+    mov byte [net_flushing], 1  ; Keep the timer flush out while appending
+    push ebx
     push edx
-    movzx edx, al
-    push eax
-    mov eax, [net_buf_pos]
-    mov byte [net_buf + eax], dl
-    inc eax
-    mov [net_buf_pos], eax
-    pop eax
-    pop edx
-    ; Flush on LF (0x0A) or buffer full
-    cmp dl, 10
-    je .net_do_flush
-    cmp dword [net_buf_pos], 256
-    jge .net_do_flush
-    jmp .no_net
+    mov edx, [net_buf_pos]
+    test edx, edx
+    jnz .net_append
+    call net_slot_wait          ; First char: slot must be back from the NIC
+    mov ebx, [isr_tick_count]
+    mov [net_first_tick], ebx
+.net_append:
+    call net_slot_buf
+    mov [ebx + NET_HDR_SIZE + edx], al
+    inc edx
+    mov [net_buf_pos], edx
+    mov byte [net_flushing], 0
+    ; Flush when full, or on LF once the frame is NET_CON_TICKS old
+    cmp edx, NET_CON_LIMIT
+    jae .net_do_flush
+    cmp edx, [net_con_max]
+    jae .net_do_flush
+    cmp al, 10
+    jne .net_kept
+    mov edx, [isr_tick_count]
+    sub edx, [net_first_tick]
+    cmp edx, NET_CON_TICKS
+    jb .net_kept
 .net_do_flush:
-    push eax
     call net_flush
-    pop eax
+.net_kept:
+    pop edx
+    pop ebx
 .no_net:
 
     push ebx
@@ -4217,7 +6864,28 @@ read_key:
     ; Check keyboard ring buffer (filled by IRQ1 ISR)
     cmp dword [kb_ring_count], 0
     jne .read_ring
-    hlt                     ; Sleep until interrupt (timer/keyboard)
+    ; Idle: run a due write-behind flush (deadline counted in PIT ticks)
+    cmp dword [blk_wb_due], 0
+    je .sleep
+    mov eax, [isr_tick_count]
+    sub eax, [blk_wb_due]
+    js .sleep
+    pushad
+    call blk_flush_all_
+    popad
+    jmp .wait
+.sleep:
+    ; Idle: hand pending ECHOPORT entries to TRACE-DRAIN, one chunk a nap
+    cmp dword [trace_drain], 0
+    je .nap
+    mov eax, [trace_head]
+    cmp eax, [trace_tail]
+    je .nap
+    pushad
+    call trace_run_drain_
+    popad
+.nap:
+    call task_idle          ; Other tasks, or sleep until timer/keyboard
     jmp .wait
 
 .read_ring:
@@ -4443,6 +7111,95 @@ find_:
 .got_len:
     mov edx, ecx            ; EDX = word length
 
+    ; Hash index is authoritative while dict_hash_ok is set; if it ever
+    ; overflowed, fall through to the linear chain walk below.
+    cmp byte [dict_hash_ok], 0
+    je .linear
+    mov eax, [VAR_HERE]
+    cmp eax, [dict_hash_top]
+    ja .hash_synced
+    call dict_hash_purge    ; HERE rolled back over indexed headers
+.hash_synced:
+    mov esi, word_buffer
+    call dict_hash_name     ; EAX = name hash (ECX = length)
+    push eax                ; Keep name hash for each vocabulary probe
+
+    xor ecx, ecx
+.h_next_vocab:
+    cmp ecx, [VAR_SEARCH_DEPTH]
+    jge .h_fallback
+    mov eax, [VAR_SEARCH_ORDER + ecx * 4]
+    call .h_probe
+    test eax, eax
+    jnz .h_found
+    inc ecx
+    jmp .h_next_vocab
+
+.h_fallback:
+    ; Same FORTH last-resort rule as the linear walk
+    mov eax, VAR_FORTH_LATEST
+    call .h_probe
+    test eax, eax
+    jz .h_not_found
+
+.h_found:
+    add esp, 4              ; Drop name hash
+    mov ebx, eax            ; EBX = header
+    movzx ecx, byte [ebx + 4]
+    lea eax, [ebx + 5 + edx]
+    add eax, 3
+    and eax, ~3             ; EAX = XT
+    pop esi
+    pop edi
+    pop edx
+    pop ebx
+    ret
+
+.h_not_found:
+    add esp, 4
+    jmp .truly_not_found
+
+; .h_probe - Look up word_buffer in one vocabulary's bucket chain
+; Input:  EAX = vocab LATEST cell, EDX = length, name hash at [esp+4]
+; Output: EAX = header address or 0. Preserves ECX, EDX.
+.h_probe:
+    push ecx
+    mov ecx, eax            ; ECX = vocab cell
+    mov eax, [esp + 8]      ; Name hash
+    call dict_hash_bucket
+    mov ebx, [eax]          ; First node
+.h_walk:
+    test ebx, ebx
+    jz .h_miss
+    cmp [ebx + 8], ecx      ; Same vocabulary?
+    jne .h_skip
+    mov eax, [ebx + 4]      ; EAX = header
+    test byte [eax + 4], F_HIDDEN
+    jnz .h_skip             ; Hidden: keep going to the older definition
+    push ecx
+    movzx ecx, byte [eax + 4]
+    and ecx, F_LENMASK
+    cmp ecx, edx
+    jne .h_skip_pop
+    lea esi, [eax + 5]
+    mov edi, word_buffer
+    repe cmpsb
+    je .h_hit
+.h_skip_pop:
+    pop ecx
+.h_skip:
+    mov ebx, [ebx]          ; Next node in bucket
+    jmp .h_walk
+.h_hit:
+    pop ecx
+    pop ecx
+    ret
+.h_miss:
+    xor eax, eax
+    pop ecx
+    ret
+
+.linear:
     ; Walk the search order: VAR_SEARCH_ORDER[0..depth-1]
     ; Each entry is the address of a vocabulary's LATEST cell
     xor ecx, ecx            ; ECX = search order index
@@ -4640,33 +7397,160 @@ comma_:
     ret
 
 ; ----------------------------------------------------------------------------
-; create_ - Create dictionary header for word in word_buffer
+; peep_compile_ - Compile XT in EAX, then try to fuse it with the items before
+; peep_literal_ - Compile LIT <EAX> the same way
 ; ----------------------------------------------------------------------------
-create_:
-    push eax
-    push ebx
-    push ecx
-    push edi
-    push esi
+; Only the outer interpreter's compile path comes through here. peep_hist
+; holds the start of the last PEEP_DEPTH items it compiled, newest first;
+; the history is dropped whenever HERE was moved by anyone else (",", ALLOT,
+; COMPILE,) or an immediate word ran, so fusing never reaches back over data
+; or a control-flow mark. Clobbers EAX, ECX, EDX.
+peep_compile_:
+    call peep_begin_
+    call comma_
+    jmp peep_fuse_
 
-    mov edi, [VAR_HERE]
+peep_literal_:
+    push eax
+    call peep_begin_
+    mov eax, LIT
+    call comma_
+    pop eax
+    call comma_
+    jmp peep_fuse_
 
-    ; Write link: chain into the current vocabulary
-    mov ebx, [VAR_CURRENT]      ; Address of current vocab's LATEST cell
-    mov eax, [ebx]              ; Dereference: actual latest word in this vocab
-    stosd
+; Start a new item at HERE (EAX preserved)
+peep_begin_:
+    mov ecx, [VAR_HERE]
+    cmp ecx, [peep_here]
+    je .push
+    mov dword [peep_n], 0          ; Something else wrote: forget history
+.push:
+    mov edx, PEEP_DEPTH - 1
+.shift:
+    test edx, edx
+    jz .store
+    push eax
+    mov eax, [peep_hist + edx*4 - 4]
+    mov [peep_hist + edx*4], eax
+    pop eax
+    dec edx
+    jmp .shift
+.store:
+    mov [peep_hist], ecx
+    cmp dword [peep_n], PEEP_DEPTH
+    jae .done
+    inc dword [peep_n]
+.done:
+    ret
 
-    ; Calculate name length
-    mov esi, word_buffer
-    xor ecx, ecx
-.len:
-    lodsb
-    test al, al
-    jz .got_len
+; Rewrite the newest items while any rule in peep_rules matches
+peep_fuse_:
+    push ebx
+    push esi
+    push edi
+    cmp dword [peep_enabled], 0
+    je .done
+.again:
+    mov esi, peep_rules
+.rule:
+    mov eax, [esi]                 ; First XT (0 = end of table)
+    test eax, eax
+    jz .done
+    mov ecx, 2                     ; Items in this rule
+    cmp dword [esi + 8], 0
+    je .have_count
     inc ecx
-    jmp .len
-.got_len:
-
+.have_count:
+    cmp [peep_n], ecx
+    jb .next_rule
+    mov edx, [peep_hist + ecx*4 - 4]
+    cmp eax, [edx]
+    jne .next_rule
+    mov edx, [peep_hist + ecx*4 - 8]
+    mov eax, [esi + 4]
+    cmp eax, [edx]
+    jne .next_rule
+    cmp ecx, 3
+    jne .matched
+    mov edx, [peep_hist]
+    mov eax, [esi + 8]
+    cmp eax, [edx]
+    jne .next_rule
+.matched:
+    ; The fused item replaces the matched ones at the first one's address
+    mov edi, [peep_hist + ecx*4 - 4]
+    mov ebx, [esi + 16]            ; 1 + history index of operand item, 0 = none
+    test ebx, ebx
+    jz .no_operand
+    mov ebx, [peep_hist + ebx*4 - 4]
+    mov ebx, [ebx + 4]             ; Read operand before anything moves
+.no_operand:
+    mov eax, [esi + 12]
+    mov [edi], eax
+    add edi, 4
+    cmp dword [esi + 16], 0
+    je .set_here
+    mov [edi], ebx
+    add edi, 4
+.set_here:
+    mov [VAR_HERE], edi
+    ; History: hist[j] = hist[j + ecx - 1], so hist[0] is the fused item
+    dec ecx
+    sub [peep_n], ecx
+    xor edx, edx
+.shift:
+    lea eax, [edx + ecx]
+    cmp eax, PEEP_DEPTH
+    jae .again                     ; Fused item may fuse again with its predecessor
+    mov eax, [peep_hist + eax*4]
+    mov [peep_hist + edx*4], eax
+    inc edx
+    jmp .shift
+.next_rule:
+    add esi, PEEP_RULE_SIZE
+    jmp .rule
+.done:
+    mov eax, [VAR_HERE]
+    mov [peep_here], eax
+    pop edi
+    pop esi
+    pop ebx
+    ret
+
+; ----------------------------------------------------------------------------
+; create_ - Create dictionary header for word in word_buffer
+; ----------------------------------------------------------------------------
+create_:
+    push eax
+    push ebx
+    push ecx
+    push edi
+    push esi
+
+    ; Drop index entries for headers a rollback has already discarded
+    mov edi, [VAR_HERE]
+    cmp edi, [dict_hash_top]
+    ja .hash_synced
+    call dict_hash_purge
+.hash_synced:
+
+    ; Write link: chain into the current vocabulary
+    mov ebx, [VAR_CURRENT]      ; Address of current vocab's LATEST cell
+    mov eax, [ebx]              ; Dereference: actual latest word in this vocab
+    stosd
+
+    ; Calculate name length
+    mov esi, word_buffer
+    xor ecx, ecx
+.len:
+    lodsb
+    test al, al
+    jz .got_len
+    inc ecx
+    jmp .len
+.got_len:
+
     ; Write flags + length
     mov al, cl
     stosb
@@ -4688,6 +7572,11 @@ create_:
     mov [VAR_LATEST], eax       ; Also update global LATEST (for ; IMMEDIATE etc.)
     mov [VAR_HERE], edi
 
+    ; Index the new header (newest first, so it shadows older definitions)
+    mov ecx, ebx                ; ECX = vocab cell
+    mov ebx, eax                ; EBX = header
+    call dict_hash_insert
+
     pop esi
     pop edi
     pop ecx
@@ -4695,6 +7584,283 @@ create_:
     pop eax
     ret
 
+; ============================================================================
+; Dictionary Hash Index
+; ============================================================================
+; Every header in every vocabulary chain has a node in a shared bucket table;
+; the bucket is chosen by name hash XOR the vocabulary's LATEST cell address,
+; so each vocabulary effectively has its own index. Chains are kept newest
+; first, which gives redefinition shadowing for free; hidden headers are
+; skipped at lookup time, exactly like the linear walk.
+; The link chains stay the source of truth: WORDS, SEE, disasm and MIRROR
+; never look at the index, and REHASH rebuilds it from the chains.
+; Rollback (Ctrl+C restoring save_here, LOOKINGGLASS) is detected by
+; HERE <= dict_hash_top and handled by dict_hash_purge.
+; If the node pool or vocab worklist overflows, dict_hash_ok drops to 0 and
+; find_ falls back to the linear walk until the next REHASH.
+
+; ----------------------------------------------------------------------------
+; dict_hash_name - Hash a name
+; Input:  ESI = name, ECX = length
+; Output: EAX = hash. Preserves all other registers.
+; ----------------------------------------------------------------------------
+dict_hash_name:
+    push ecx
+    push edx
+    push esi
+    mov eax, ecx                ; Seed with length
+.loop:
+    test ecx, ecx
+    jz .done
+    movzx edx, byte [esi]
+    imul eax, eax, 31
+    add eax, edx
+    inc esi
+    dec ecx
+    jmp .loop
+.done:
+    pop esi
+    pop edx
+    pop ecx
+    ret
+
+; ----------------------------------------------------------------------------
+; dict_hash_bucket - Bucket head address for a name in a vocabulary
+; Input:  EAX = name hash, ECX = vocab LATEST cell address
+; Output: EAX = bucket head address. Preserves all other registers.
+; ----------------------------------------------------------------------------
+dict_hash_bucket:
+    push edx
+    xor eax, ecx
+    mov edx, eax
+    shr edx, 10
+    xor eax, edx
+    and eax, DICT_HASH_NBUCKETS - 1
+    lea eax, [DICT_HASH_BUCKETS + eax * 4]
+    pop edx
+    ret
+
+; ----------------------------------------------------------------------------
+; dict_hash_node - Allocate and fill an (unlinked) node
+; Input:  EBX = header address, ECX = vocab LATEST cell address
+; Output: EDI = node (0 if the index is off or the pool is full)
+;         EAX = bucket head address for the node
+; ----------------------------------------------------------------------------
+dict_hash_node:
+    xor edi, edi
+    cmp byte [dict_hash_ok], 0
+    je .done
+    mov eax, [dict_hash_count]
+    cmp eax, DICT_HASH_MAX_NODES
+    jae .full
+    inc dword [dict_hash_count]
+    imul edi, eax, DICT_HASH_NODE_SZ
+    add edi, DICT_HASH_NODES
+    mov dword [edi], 0
+    mov [edi + 4], ebx
+    mov [edi + 8], ecx
+    cmp ebx, [dict_hash_top]
+    jbe .hash
+    mov [dict_hash_top], ebx
+.hash:
+    push ecx
+    push esi
+    movzx ecx, byte [ebx + 4]
+    and ecx, F_LENMASK
+    lea esi, [ebx + 5]
+    call dict_hash_name
+    pop esi
+    pop ecx
+    call dict_hash_bucket
+.done:
+    ret
+.full:
+    mov byte [dict_hash_ok], 0  ; Index incomplete: find_ walks chains
+    xor edi, edi
+    ret
+
+; ----------------------------------------------------------------------------
+; dict_hash_insert - Index a header at the head of its bucket (newest)
+; Input:  EBX = header address, ECX = vocab LATEST cell address
+; Preserves all registers.
+; ----------------------------------------------------------------------------
+dict_hash_insert:
+    push eax
+    push edx
+    push edi
+    call dict_hash_node
+    test edi, edi
+    jz .done
+    mov edx, [eax]
+    mov [edi], edx              ; node.next = old head
+    mov [eax], edi              ; head = node
+.done:
+    pop edi
+    pop edx
+    pop eax
+    ret
+
+; ----------------------------------------------------------------------------
+; dict_hash_append - Index a header at the tail of its bucket (oldest)
+; Used by dict_hash_rebuild, which walks chains newest-first.
+; Input:  EBX = header address, ECX = vocab LATEST cell address
+; Preserves all registers.
+; ----------------------------------------------------------------------------
+dict_hash_append:
+    push eax
+    push edi
+    call dict_hash_node
+    test edi, edi
+    jz .done
+.tail:
+    cmp dword [eax], 0          ; node.next is at offset 0, so a node
+    je .link                    ; pointer doubles as a "next cell" pointer
+    mov eax, [eax]
+    jmp .tail
+.link:
+    mov [eax], edi
+.done:
+    pop edi
+    pop eax
+    ret
+
+; ----------------------------------------------------------------------------
+; dict_hash_purge - Drop nodes for headers at or above HERE
+; Compacts the node pool in place and relinks each survivor by header
+; address, so buckets stay newest-first. Pool order is not definition
+; order: dict_hash_rebuild fills the pool newest-first.
+; Preserves all registers.
+; ----------------------------------------------------------------------------
+dict_hash_purge:
+    pushad
+    cmp byte [dict_hash_ok], 0
+    je .done
+    mov edi, DICT_HASH_BUCKETS
+    mov ecx, DICT_HASH_NBUCKETS
+    xor eax, eax
+    rep stosd
+    mov esi, DICT_HASH_NODES    ; Read cursor (write cursor never passes it)
+    mov edx, [dict_hash_count]
+    mov dword [dict_hash_count], 0
+    mov dword [dict_hash_top], 0
+.scan:
+    test edx, edx
+    jz .done
+    mov ebx, [esi + 4]          ; header
+    cmp ebx, [VAR_HERE]
+    jae .drop                   ; Discarded by the rollback
+    mov ecx, [esi + 8]          ; vocab cell
+    call dict_hash_node         ; EDI = node, EAX = bucket head
+    test edi, edi
+    jz .drop
+.seek:
+    mov ecx, [eax]              ; Skip past every newer header (EBP stays
+    test ecx, ecx               ; the return stack an IRQ hook runs on)
+    jz .link
+    cmp ebx, [ecx + 4]
+    ja .link
+    mov eax, ecx
+    jmp .seek
+.link:
+    mov [edi], ecx
+    mov [eax], edi
+.drop:
+    add esi, DICT_HASH_NODE_SZ
+    dec edx
+    jmp .scan
+.done:
+    popad
+    ret
+
+; ----------------------------------------------------------------------------
+; dict_hash_add_vocab - Queue a vocab LATEST cell for dict_hash_rebuild
+; Input:  EAX = cell address. Ignores duplicates. Preserves all registers.
+; ----------------------------------------------------------------------------
+dict_hash_add_vocab:
+    push ecx
+    xor ecx, ecx
+.scan:
+    cmp ecx, [dict_hash_nvocabs]
+    jae .add
+    cmp [DICT_HASH_VOCABS + ecx * 4], eax
+    je .done
+    inc ecx
+    jmp .scan
+.add:
+    cmp ecx, DICT_HASH_MAX_VOCABS
+    jae .full
+    mov [DICT_HASH_VOCABS + ecx * 4], eax
+    inc dword [dict_hash_nvocabs]
+.done:
+    pop ecx
+    ret
+.full:
+    mov byte [dict_hash_ok], 0
+    jmp .done
+
+; ----------------------------------------------------------------------------
+; dict_hash_rebuild - Rebuild the whole index from the vocabulary chains
+; Starts from FORTH, the search order and CURRENT, and queues the LATEST
+; cell of every DOVOC word it meets along the way.
+; Preserves all registers.
+; ----------------------------------------------------------------------------
+dict_hash_rebuild:
+    pushad
+    mov byte [dict_hash_ok], 1
+    mov dword [dict_hash_count], 0
+    mov dword [dict_hash_top], 0
+    mov dword [dict_hash_nvocabs], 0
+    mov edi, DICT_HASH_BUCKETS
+    mov ecx, DICT_HASH_NBUCKETS
+    xor eax, eax
+    rep stosd
+
+    mov eax, VAR_FORTH_LATEST
+    call dict_hash_add_vocab
+    xor ecx, ecx
+.seed:
+    cmp ecx, [VAR_SEARCH_DEPTH]
+    jge .seeded
+    mov eax, [VAR_SEARCH_ORDER + ecx * 4]
+    call dict_hash_add_vocab
+    inc ecx
+    jmp .seed
+.seeded:
+    mov eax, [VAR_CURRENT]
+    call dict_hash_add_vocab
+
+    xor edx, edx                ; EDX = worklist index
+.next_vocab:
+    cmp edx, [dict_hash_nvocabs]
+    jae .done
+    mov ecx, [DICT_HASH_VOCABS + edx * 4]
+    mov ebx, [ecx]              ; Newest header in this vocabulary
+.walk:
+    test ebx, ebx
+    jz .vocab_done
+    cmp ebx, dict_origin        ; Kernel chain sentinel, not a real word
+    je .vocab_done
+    call dict_hash_append
+    ; Vocabulary word? Queue its LATEST cell (the parameter field)
+    movzx eax, byte [ebx + 4]
+    and eax, F_LENMASK
+    lea eax, [ebx + 5 + eax]
+    add eax, 3
+    and eax, ~3                 ; EAX = CFA
+    cmp dword [eax], DOVOC
+    jne .not_vocab
+    add eax, 4
+    call dict_hash_add_vocab
+.not_vocab:
+    mov ebx, [ebx]              ; Follow link
+    jmp .walk
+.vocab_done:
+    inc edx
+    jmp .next_vocab
+.done:
+    popad
+    ret
+
 ; ----------------------------------------------------------------------------
 ; read_line - Read a line of input into TIB
 ; If Ctrl+C is pressed during input, break_flag is set and line is discarded.
@@ -4773,19 +7939,50 @@ read_line:
 ; ATA PIO Driver
 ; ============================================================================
 
+; ----------------------------------------------------------------------------
+; ata_timeout_ - Start an ATA_TIMEOUT_US wait: arms the TSC deadline, and
+; sets ECX to the poll cap used when there is no calibrated TSC
+; ata_expired_ - CF set once the wait is over (TSC deadline, else the
+; poll cap counted down in ECX)
+; Clobbers: ECX; ata_timeout_ preserves EAX, EDX
+; ----------------------------------------------------------------------------
+ata_timeout_:
+    mov ecx, ATA_POLL_CAP
+    cmp dword [tsc_khz], 0
+    je .done
+    push eax
+    push edx
+    mov eax, ATA_TIMEOUT_US
+    call tsc_deadline_
+    pop edx
+    pop eax
+.done:
+    ret
+
+ata_expired_:
+    cmp dword [tsc_khz], 0
+    jne tsc_past_
+    dec ecx
+    jz .over
+    clc
+    ret
+.over:
+    stc
+    ret
+
 ; ----------------------------------------------------------------------------
 ; ata_wait_ready - Wait for ATA drive to be ready (BSY clear)
-; Clobbers: AL, DX
+; Clobbers: AL, ECX, DX
 ; ----------------------------------------------------------------------------
 ata_wait_ready:
+    call ata_timeout_
     mov dx, ATA_CMD_STATUS
-    mov ecx, 10000000           ; timeout ~100ms at 3GHz
 .wait:
     in al, dx
     test al, 0x80               ; BSY bit
     jz .ready
-    dec ecx
-    jnz .wait
+    call ata_expired_
+    jnc .wait
     stc                         ; CF=1: timeout
     ret
 .ready:
@@ -4795,11 +7992,11 @@ ata_wait_ready:
 ; ----------------------------------------------------------------------------
 ; ata_wait_drq - Wait for DRQ (data request) after command
 ; Returns: CF clear = OK, CF set = error
-; Clobbers: AL, DX
+; Clobbers: AL, ECX, DX
 ; ----------------------------------------------------------------------------
 ata_wait_drq:
+    call ata_timeout_
     mov dx, ATA_CMD_STATUS
-    mov ecx, 10000000           ; timeout ~100ms at 3GHz
 .wait:
     in al, dx
     test al, 0x80               ; Still busy?
@@ -4809,8 +8006,8 @@ ata_wait_drq:
     test al, 0x08               ; DRQ bit?
     jnz .ready
 .check_timeout:
-    dec ecx
-    jnz .wait
+    call ata_expired_
+    jnc .wait
     stc                         ; timeout
     ret
 .error:
@@ -4828,41 +8025,11 @@ ata_wait_drq:
 ; Note: Does NOT clobber ESI (uses rep insw with EDI only)
 ; ----------------------------------------------------------------------------
 ata_read_sector:
-    call ata_wait_ready
+    mov al, ATA_CMD_READ
+    mov cl, 1                   ; Sector count = 1
+    call ata_command_
     jc .done                     ; bail on timeout
 
-    ; Set sector count = 1
-    mov dx, ATA_SECCOUNT
-    mov al, 1
-    out dx, al
-
-    ; Set LBA bytes
-    mov dx, ATA_LBA_LO
-    mov al, bl
-    out dx, al
-
-    mov dx, ATA_LBA_MID
-    mov al, bh
-    out dx, al
-
-    mov dx, ATA_LBA_HI
-    mov eax, ebx
-    shr eax, 16
-    out dx, al
-
-    ; Drive select: IDE slave (index=1), LBA mode, top 4 LBA bits
-    mov dx, ATA_DRIVE
-    mov eax, ebx
-    shr eax, 24
-    and al, 0x0F
-    or al, 0xF0                 ; LBA mode + slave (bit 4 = 1)
-    out dx, al
-
-    ; Send READ SECTORS command
-    mov dx, ATA_CMD_STATUS
-    mov al, 0x20
-    out dx, al
-
     ; Wait for data
     call ata_wait_drq
     jc .done
@@ -4876,10 +8043,156 @@ ata_read_sector:
 .done:
     ret
 
+; ----------------------------------------------------------------------------
+; snap_read_block - Read block EAX into EDI (EDI advances 1024 bytes)
+; Returns: CF set on error or when there is no IDE drive to read
+; Clobbers: EAX, ECX, EDX
+; ----------------------------------------------------------------------------
+snap_read_block:
+    cmp dword [MEMDISK_BASE], 0
+    jne .ram
+    mov dx, ATA_CMD_STATUS
+    in al, dx
+    cmp al, 0xFF                    ; Floating bus: no drive, don't wait
+    je .fail
+    push ebx
+    shl eax, 1
+    add eax, BLOCKS_LBA_BASE
+    mov ebx, eax
+    call ata_read_sector
+    jc .done
+    inc ebx
+    call ata_read_sector
+.done:
+    pop ebx
+    ret
+.ram:
+    call ram_read_block
+    clc
+    ret
+.fail:
+    stc
+    ret
+
+; ----------------------------------------------------------------------------
+; snap_restore_ - Restore the dictionary snapshot at SNAP_BLOCK
+; Copies the image to DICT_START and reloads the compiler state captured
+; with it (HERE, LATEST, BASE, search order, vocabulary heads, block
+; vectors a vocabulary installed), then rebuilds the hash index.
+; Returns: CF set = no snapshot, or one from another kernel (boot from text)
+; Clobbers: EAX, ECX, EDX, EDI
+; ----------------------------------------------------------------------------
+snap_restore_:
+    mov eax, SNAP_BLOCK
+    mov edi, SNAP_HDR_BUF
+    call snap_read_block
+    jc .none
+    mov byte [SNAP_HDR_BUF + BLOCK_SIZE - 1], 0  ; Replay text always ends
+    cmp dword [SNAP_HDR_BUF], SNAP_MAGIC
+    jne .none
+    cmp dword [SNAP_HDR_BUF + 4], SNAP_VERSION
+    jne .none
+    call kernel_hash_
+    cmp eax, [SNAP_HDR_BUF + SNAP_OFF_HASH]
+    jne .none
+    ; HERE must lie inside the image and the image inside dictionary space
+    mov ecx, [SNAP_HDR_BUF + SNAP_OFF_NBLOCKS]
+    cmp ecx, DICT_SIZE / BLOCK_SIZE
+    ja .none
+    mov eax, ecx
+    shl eax, 10
+    add eax, DICT_START
+    cmp [SNAP_HDR_BUF + SNAP_OFF_HERE], eax
+    ja .none
+    cmp dword [SNAP_HDR_BUF + SNAP_OFF_HERE], DICT_START
+    jb .none
+
+    mov eax, SNAP_BLOCK + 1
+    mov edi, DICT_START
+.copy:
+    test ecx, ecx
+    jz .copied
+    push eax
+    push ecx
+    call snap_read_block
+    pop ecx
+    pop eax
+    jc .none
+    inc eax
+    dec ecx
+    jmp .copy
+.copied:
+    mov eax, [SNAP_HDR_BUF + SNAP_OFF_HERE]
+    mov [VAR_HERE], eax
+    mov eax, [SNAP_HDR_BUF + SNAP_OFF_LATEST]
+    mov [VAR_LATEST], eax
+    mov eax, [SNAP_HDR_BUF + SNAP_OFF_BASE]
+    mov [VAR_BASE], eax
+    mov eax, [SNAP_HDR_BUF + SNAP_OFF_SDEPTH]
+    mov [VAR_SEARCH_DEPTH], eax
+    xor ecx, ecx
+.order:
+    mov eax, [SNAP_HDR_BUF + SNAP_OFF_SORDER + ecx*4]
+    mov [VAR_SEARCH_ORDER + ecx*4], eax
+    inc ecx
+    cmp ecx, 8
+    jb .order
+    mov eax, [SNAP_HDR_BUF + SNAP_OFF_CURRENT]
+    mov [VAR_CURRENT], eax
+    mov eax, [SNAP_HDR_BUF + SNAP_OFF_FLATEST]
+    mov [VAR_FORTH_LATEST], eax
+    ; Block vectors: only ones a vocabulary installed (xt in the image).
+    ; Kernel defaults depend on how this boot happened (memdisk or disk).
+    mov eax, [SNAP_HDR_BUF + SNAP_OFF_WRITE_VEC]
+    cmp eax, DICT_START
+    jb .keep_write_vec
+    mov [BLK_WRITE_VEC], eax
+.keep_write_vec:
+    mov eax, [SNAP_HDR_BUF + SNAP_OFF_READ_VEC]
+    cmp eax, DICT_START
+    jb .keep_read_vec
+    mov [BLK_READ_VEC], eax
+.keep_read_vec:
+    call dict_hash_rebuild
+    clc
+    ret
+.none:
+    stc
+    ret
+
+; ----------------------------------------------------------------------------
+; kernel_hash_ - FNV-1a over the kernel code and the embedded text blob
+; Both are read-only once loaded. Any change to either (a rebuilt kernel,
+; a TOS_CACHE build, edited vocabularies) invalidates older snapshots.
+; Returns: EAX = hash. Clobbers: ECX, EDX
+; ----------------------------------------------------------------------------
+kernel_hash_:
+    push esi
+    mov eax, 0x811C9DC5             ; FNV offset basis
+    mov esi, kernel_start
+    mov ecx, kernel_code_end - kernel_start
+    call .bytes
+    mov esi, embed_data
+    mov ecx, embed_end - embed_data
+    call .bytes
+    pop esi
+    ret
+.bytes:
+    test ecx, ecx
+    jz .bytes_done
+    movzx edx, byte [esi]
+    xor eax, edx
+    imul eax, eax, 0x01000193       ; FNV prime
+    inc esi
+    dec ecx
+    jmp .bytes
+.bytes_done:
+    ret
+
 ; ----------------------------------------------------------------------------
 ; ram_read_block - Copy one 1024-byte block from memdisk RAM image
 ; Input:  EAX = block number
-;         EDI = destination buffer (in BLK_BUF_DATA pool)
+;         EDI = destination buffer (in the buffer pool)
 ; The combined image layout in RAM:
 ;   MEMDISK_BASE + 0       = boot sector (512 bytes)
 ;   MEMDISK_BASE + 512     = kernel (KERNEL_PADDED_SIZE bytes)
@@ -4903,18 +8216,64 @@ ram_read_block:
     ret
 
 ; ----------------------------------------------------------------------------
-; ata_write_sector - Write one 512-byte sector via ATA PIO
-; Input:  EBX = LBA sector number, ESI = source buffer
+; ata_write_sectors - Write ECX consecutive sectors via ATA PIO
+; Input:  EBX = first LBA, ECX = sector count (1-255), ESI = source buffer
 ; Output: CF clear = success, CF set = error
+; One WRITE SECTORS command and one FLUSH CACHE for the whole run.
 ; Clobbers: EAX, ECX, EDX, ESI (caller must save/restore Forth IP!)
 ; ----------------------------------------------------------------------------
-ata_write_sector:
+ata_write_sectors:
+    push ecx                    ; Sectors left
+    mov al, ATA_CMD_WRITE
+    call ata_command_           ; CL = sector count
+    jc .fail
+
+.sector:
+    ; Wait for DRQ
+    call ata_wait_drq
+    jc .fail
+
+    ; Write 256 words (512 bytes) to data port
+    mov dx, ATA_DATA
+    mov ecx, 256
+    rep outsw
+    dec dword [esp]
+    jnz .sector
+    pop ecx
+
+    ; Flush write cache
+    call ata_wait_ready
+    jc .done                     ; bail on timeout
+    mov dx, ATA_CMD_STATUS
+    mov al, ATA_CMD_FLUSH
+    out dx, al
     call ata_wait_ready
     jc .done                     ; bail on timeout
 
-    ; Set sector count = 1
+    clc
+.done:
+    ret
+.fail:
+    pop ecx
+    stc
+    ret
+
+; ----------------------------------------------------------------------------
+; ata_command_ - Program the task file and issue an ATA command
+; Input:  AL = command, EBX = LBA, CL = sector count (0 = 256)
+; Output: CF set = drive stayed busy (command not sent)
+; Clobbers: EAX, ECX, EDX
+; ----------------------------------------------------------------------------
+ata_command_:
+    push eax
+    push ecx
+    call ata_wait_ready
+    pop ecx
+    jc .busy
+
+    ; Sector count
     mov dx, ATA_SECCOUNT
-    mov al, 1
+    mov al, cl
     out dx, al
 
     ; Set LBA bytes
@@ -4931,153 +8290,830 @@ ata_write_sector:
     shr eax, 16
     out dx, al
 
-    ; Drive select: IDE slave, LBA mode, top 4 LBA bits
+    ; Drive select: IDE slave (index=1), LBA mode, top 4 LBA bits
     mov dx, ATA_DRIVE
     mov eax, ebx
     shr eax, 24
     and al, 0x0F
-    or al, 0xF0                 ; LBA mode + slave
+    or al, 0xF0                 ; LBA mode + slave (bit 4 = 1)
     out dx, al
 
-    ; Send WRITE SECTORS command
+    ; Send the command
+    pop eax
     mov dx, ATA_CMD_STATUS
-    mov al, 0x30
     out dx, al
+    clc
+    ret
+.busy:
+    pop eax
+    stc
+    ret
 
-    ; Wait for DRQ
+; ----------------------------------------------------------------------------
+; ata_probe_ - One-time drive probe before the first block transfer
+; IDENTIFY the slave drive; enable READ MULTIPLE with 2-sector DRQ blocks
+; (one DRQ per Forth block) and, if the drive does DMA, look for a
+; bus-master IDE controller on PCI bus 0 (sets ata_dma_base / ATA-DMA).
+; Clobbers: EAX, EBX, ECX, EDX, EDI
+; ----------------------------------------------------------------------------
+ata_probe_:
+    mov dword [ata_probed], -1
+    mov dx, ATA_CMD_STATUS
+    in al, dx
+    cmp al, 0xFF                ; Floating bus: no drive
+    je .done
+
+    xor ebx, ebx
+    xor ecx, ecx
+    mov al, ATA_CMD_IDENTIFY
+    call ata_command_
+    jc .done
     call ata_wait_drq
     jc .done
-
-    ; Write 256 words (512 bytes) to data port
+    mov edi, ATA_IDENT_BUF
     mov dx, ATA_DATA
     mov ecx, 256
-    rep outsw
+    rep insw
 
-    ; Flush write cache
+    ; Word 47 low byte: most sectors per READ MULTIPLE DRQ block
+    cmp byte [ATA_IDENT_BUF + 47*2], 2
+    jb .no_multi
+    xor ebx, ebx
+    mov cl, 2
+    mov al, ATA_CMD_SET_MULTI
+    call ata_command_
+    jc .no_multi
     call ata_wait_ready
-    jc .done                     ; bail on timeout
+    jc .no_multi
     mov dx, ATA_CMD_STATUS
-    mov al, 0xE7                ; FLUSH CACHE command
+    in al, dx
+    test al, 0x01               ; ERR: mode rejected
+    jnz .no_multi
+    mov dword [ata_multi], 2
+.no_multi:
+    ; Word 49 bit 8: DMA supported
+    test byte [ATA_IDENT_BUF + 49*2 + 1], 0x01
+    jz .done
+    call ata_find_bmide_
+.done:
+    ret
+
+; ----------------------------------------------------------------------------
+; ata_find_bmide_ - Find a bus-master IDE controller on PCI bus 0
+; Class 01:01 with the primary channel in compatibility mode (0x1F0) and
+; bus mastering (prog-if bit 7). Sets ata_dma_base to BAR4 and enables
+; I/O decode + bus mastering in the command register.
+; Clobbers: EAX, EBX, ECX, EDX
+; ----------------------------------------------------------------------------
+ata_find_bmide_:
+    mov ebx, 0x80000000         ; Enable bit, bus 0, dev 0, func 0
+.scan:
+    lea eax, [ebx + 0x08]       ; Class / subclass / prog-if / revision
+    call pci_read_
+    mov ecx, eax
+    shr ecx, 16
+    cmp cx, 0x0101              ; Mass storage / IDE
+    jne .next
+    mov cl, ah                  ; prog-if
+    and cl, 0x81
+    cmp cl, 0x80                ; Bus master, primary in compatibility mode
+    jne .next
+    lea eax, [ebx + 0x20]       ; BAR4: bus-master I/O block
+    call pci_read_
+    test al, 0x01               ; Must be an I/O BAR
+    jz .next
+    and eax, 0xFFFC
+    jz .next
+    mov [ata_dma_base], eax
+    lea eax, [ebx + 0x04]       ; Command register
+    call pci_read_
+    or al, 0x05                 ; I/O space + bus master
+    mov ecx, eax
+    lea eax, [ebx + 0x04]
+    call pci_write_
+    ret
+.next:
+    add ebx, 0x100              ; Next function
+    cmp ebx, 0x80010000         ; Past device 31 of bus 0
+    jb .scan
+    ret
+
+; ----------------------------------------------------------------------------
+; pci_read_ / pci_write_ - PCI configuration mechanism #1
+; Input:  EAX = config address (0x80000000 | bus<<16 | dev<<11 | fn<<8 | reg)
+;         ECX = value (pci_write_)
+; Output: EAX = dword read (pci_read_)
+; Clobbers: EDX
+; ----------------------------------------------------------------------------
+pci_read_:
+    mov dx, 0xCF8
+    out dx, eax
+    mov dx, 0xCFC
+    in eax, dx
+    ret
+
+pci_write_:
+    mov dx, 0xCF8
+    out dx, eax
+    mov dx, 0xCFC
+    mov eax, ecx
+    out dx, eax
+    ret
+
+; ----------------------------------------------------------------------------
+; ata_read_blocks_ - Read the blk_xfer_* run from disk in one ATA command
+; Blocks blk_xfer_first .. +blk_xfer_count-1 land in the buffers listed in
+; blk_xfer_hdrs (not contiguous in memory). Uses READ DMA when a bus-master
+; controller was found, else READ MULTIPLE / READ SECTORS. A DMA failure
+; is retried by PIO; if PIO succeeds, DMA is switched off for good.
+; Output: CF set = read error
+; Clobbers: EAX, EBX, ECX, EDX, EDI
+; ----------------------------------------------------------------------------
+ata_read_blocks_:
+    cmp dword [ata_probed], 0
+    jne .probed
+    call ata_probe_
+.probed:
+    cmp dword [ata_dma_base], 0
+    je ata_pio_read_
+    call ata_dma_read_
+    jnc .done
+    call ata_pio_read_
+    jc .done
+    mov dword [ata_dma_base], 0 ; PIO worked where DMA didn't
+.done:
+    ret
+
+; EBX = LBA of blk_xfer_first, CL = sectors for the whole run
+blk_xfer_lba_:
+    mov ebx, [blk_xfer_first]
+    shl ebx, 1
+    add ebx, BLOCKS_LBA_BASE
+    mov ecx, [blk_xfer_count]
+    shl ecx, 1
+    ret
+
+; PIO: one command, then one DRQ block per Forth block (READ MULTIPLE) or
+; per sector (READ SECTORS), switching EDI to each listed buffer.
+ata_pio_read_:
+    call blk_xfer_lba_
+    mov al, ATA_CMD_READ
+    cmp dword [ata_multi], 0
+    je .issue
+    mov al, ATA_CMD_READ_MULTI
+.issue:
+    call ata_command_
+    jc .fail
+    push esi
+    xor esi, esi                ; Transfer list index
+.block:
+    mov eax, [blk_xfer_hdrs + esi*4]
+    mov edi, [eax + BLK_HDR_DATA]
+    call ata_wait_drq
+    jc .fail_pop
+    mov dx, ATA_DATA
+    mov ecx, 256
+    cmp dword [ata_multi], 0
+    je .sector
+    mov ecx, 512                ; Both sectors in one DRQ block
+    rep insw
+    jmp .next
+.sector:
+    rep insw
+    mov dx, ATA_CTRL
+    in al, dx                   ; Alternate status: 400ns settle
+    call ata_wait_drq
+    jc .fail_pop
+    mov dx, ATA_DATA
+    mov ecx, 256
+    rep insw
+.next:
+    mov dx, ATA_CTRL
+    in al, dx
+    inc esi
+    cmp esi, [blk_xfer_count]
+    jb .block
+    pop esi
+    clc
+    ret
+.fail_pop:
+    pop esi
+.fail:
+    stc
+    ret
+
+; DMA: one PRD entry per Forth block (two when a pool buffer straddles a
+; 64K boundary, which a PRD entry must not cross), poll the bus-master
+; status for the drive's interrupt (IRQ14 stays masked at the PIC).
+ata_dma_read_:
+    push esi
+    push edi
+    xor esi, esi                ; Transfer list index
+    mov edi, ATA_PRD_TABLE
+.prd:
+    mov eax, [blk_xfer_hdrs + esi*4]
+    mov eax, [eax + BLK_HDR_DATA]
+    mov ecx, eax
+    or ecx, 0xFFFF0000
+    neg ecx                     ; ECX = bytes to the next 64K boundary
+    cmp ecx, BLOCK_SIZE
+    jae .whole
+    mov [edi], eax
+    mov [edi + 4], ecx
+    add edi, 8
+    add eax, ecx
+    sub ecx, BLOCK_SIZE
+    neg ecx                     ; Remainder past the boundary
+    jmp .entry
+.whole:
+    mov ecx, BLOCK_SIZE
+.entry:
+    mov [edi], eax
+    mov [edi + 4], ecx
+    add edi, 8
+    inc esi
+    cmp esi, [blk_xfer_count]
+    jb .prd
+    or dword [edi - 4], 0x80000000  ; End of table
+    pop edi
+
+    mov esi, [ata_dma_base]
+    lea edx, [esi + ATA_BM_CMD]
+    xor al, al
+    out dx, al                  ; Engine stopped
+    lea edx, [esi + ATA_BM_PRD]
+    mov eax, ATA_PRD_TABLE
+    out dx, eax
+    lea edx, [esi + ATA_BM_STATUS]
+    mov al, 0x06                ; Clear interrupt + error (write 1 to clear)
+    out dx, al
+    lea edx, [esi + ATA_BM_CMD]
+    mov al, 0x08                ; Direction: device -> memory
+    out dx, al
+
+    call blk_xfer_lba_
+    mov al, ATA_CMD_READ_DMA
+    call ata_command_
+    jc .fail
+    lea edx, [esi + ATA_BM_CMD]
+    mov al, 0x09                ; Start, device -> memory
+    out dx, al
+
+    call ata_timeout_
+.wait:
+    lea edx, [esi + ATA_BM_STATUS]
+    in al, dx
+    test al, 0x02               ; Bus-master error
+    jnz .stop
+    test al, 0x04               ; Drive interrupt: transfer done
+    jnz .stop
+    call ata_expired_
+    jnc .wait
+    mov al, 0x02                ; Timeout counts as an error
+.stop:
+    mov ah, al
+    lea edx, [esi + ATA_BM_CMD]
+    xor al, al
     out dx, al
-    call ata_wait_ready
-    jc .done                     ; bail on timeout
-
+    lea edx, [esi + ATA_BM_STATUS]
+    mov al, 0x06
+    out dx, al
+    test ah, 0x02
+    jnz .fail
+    mov dx, ATA_CMD_STATUS
+    in al, dx                   ; Also acknowledges the drive interrupt
+    test al, 0x21               ; ERR / device fault
+    jnz .fail
+    pop esi
     clc
-.done:
+    ret
+.fail:
+    mov dx, ATA_CMD_STATUS
+    in al, dx
+    pop esi
+    stc
     ret
 
 ; ============================================================================
 ; Block Buffer Manager
 ; ============================================================================
 
+; ----------------------------------------------------------------------------
+; blk_pool_init_ - (Re)build the buffer pool with ECX buffers, all empty
+; Headers are linked into the LRU list in index order, buffer 0 at the
+; LRU end, so an empty pool hands out buffers 0, 1, 2, ... in turn.
+; Input:  ECX = buffer count (clamped to BLK_POOL_MIN..BLK_POOL_MAX)
+; Clobbers: EAX, ECX, EDX, EDI
+; ----------------------------------------------------------------------------
+blk_pool_init_:
+    cmp ecx, BLK_POOL_MIN
+    jae .min_ok
+    mov ecx, BLK_POOL_MIN
+.min_ok:
+    cmp ecx, BLK_POOL_MAX
+    jbe .max_ok
+    mov ecx, BLK_POOL_MAX
+.max_ok:
+    mov [blk_nbufs], ecx
+    push ecx
+    mov edi, BLK_HASH
+    mov ecx, BLK_HASH_BUCKETS
+    xor eax, eax
+    rep stosd                       ; Empty hash chains
+    pop ecx
+    mov dword [BLK_LRU + BLK_HDR_BLOCK], 0xFFFFFFFF
+    mov dword [BLK_LRU + BLK_HDR_FLAGS], 0
+    mov dword [BLK_LRU + BLK_HDR_PREV], BLK_LRU
+    mov dword [BLK_LRU + BLK_HDR_NEXT], BLK_LRU
+    mov edi, BLK_POOL_HDRS
+    mov edx, BLK_POOL_DATA
+.hdr:
+    mov dword [edi + BLK_HDR_BLOCK], 0xFFFFFFFF
+    mov dword [edi + BLK_HDR_FLAGS], 0
+    mov dword [edi + BLK_HDR_HNEXT], 0
+    mov [edi + BLK_HDR_DATA], edx
+    mov byte [edx + BLOCK_SIZE], 0  ; NUL guard: LOAD parsing stops here
+    mov eax, [BLK_LRU + BLK_HDR_NEXT]
+    mov [edi + BLK_HDR_NEXT], eax   ; Insert at the MRU end
+    mov dword [edi + BLK_HDR_PREV], BLK_LRU
+    mov [eax + BLK_HDR_PREV], edi
+    mov [BLK_LRU + BLK_HDR_NEXT], edi
+    add edi, BLK_HEADER_SIZE
+    add edx, BLK_BUF_STRIDE
+    loop .hdr
+    mov dword [BLK_BUF_CUR], BLK_POOL_HDRS
+    ret
+
+; ----------------------------------------------------------------------------
+; blk_lookup_ - Hash lookup of a block's header (valid or not)
+; Input:  EAX = block number. Output: EBX = header address, 0 = not cached
+; Clobbers: ECX
+; ----------------------------------------------------------------------------
+blk_lookup_:
+    mov ecx, eax
+    and ecx, BLK_HASH_BUCKETS - 1
+    mov ebx, [BLK_HASH + ecx*4]
+.walk:
+    test ebx, ebx
+    jz .done
+    cmp [ebx + BLK_HDR_BLOCK], eax
+    je .done
+    mov ebx, [ebx + BLK_HDR_HNEXT]
+    jmp .walk
+.done:
+    ret
+
+; ----------------------------------------------------------------------------
+; blk_rehash_ - Move a header to another block number's hash chain
+; Input:  EBX = header, EAX = new block number (-1 = none: just unhash)
+; Clobbers: ECX, EDX
+; ----------------------------------------------------------------------------
+blk_rehash_:
+    mov edx, [ebx + BLK_HDR_BLOCK]
+    cmp edx, 0xFFFFFFFF
+    je .insert
+    and edx, BLK_HASH_BUCKETS - 1
+    lea ecx, [BLK_HASH + edx*4]     ; ECX = link that may point at EBX
+.unlink:
+    mov edx, [ecx]
+    test edx, edx
+    jz .insert                      ; Not on its chain (cannot happen)
+    cmp edx, ebx
+    je .found
+    lea ecx, [edx + BLK_HDR_HNEXT]
+    jmp .unlink
+.found:
+    mov edx, [ebx + BLK_HDR_HNEXT]
+    mov [ecx], edx
+.insert:
+    mov [ebx + BLK_HDR_BLOCK], eax
+    mov dword [ebx + BLK_HDR_HNEXT], 0
+    cmp eax, 0xFFFFFFFF
+    je .done
+    mov edx, eax
+    and edx, BLK_HASH_BUCKETS - 1
+    mov ecx, [BLK_HASH + edx*4]
+    mov [ebx + BLK_HDR_HNEXT], ecx
+    mov [BLK_HASH + edx*4], ebx
+.done:
+    ret
+
+; ----------------------------------------------------------------------------
+; blk_touch_ - Move a header to the MRU end of the LRU list
+; Input: EBX = header. Clobbers: ECX, EDX
+; ----------------------------------------------------------------------------
+blk_touch_:
+    mov ecx, [ebx + BLK_HDR_PREV]
+    mov edx, [ebx + BLK_HDR_NEXT]
+    mov [ecx + BLK_HDR_NEXT], edx
+    mov [edx + BLK_HDR_PREV], ecx
+    mov edx, [BLK_LRU + BLK_HDR_NEXT]
+    mov [ebx + BLK_HDR_NEXT], edx
+    mov dword [ebx + BLK_HDR_PREV], BLK_LRU
+    mov [edx + BLK_HDR_PREV], ebx
+    mov [BLK_LRU + BLK_HDR_NEXT], ebx
+    ret
+
+; ----------------------------------------------------------------------------
+; blk_view_ - LIST/BLOCK-VIEW lookup, mapping memdisk blocks in place
+; On memdisk boot (with MEMDISK-MAP set) an uncached block is not copied:
+; EDI points into the RAM image and no buffer is taken. Only readers get
+; this: a store through BLOCK must stay in the pool until UPDATE, so that
+; EMPTY-BUFFERS can still discard it. A cached block (BLOCKed, BUFFERed,
+; LOADed) comes from its header, dirty data included. BLK_BUF_CUR is left
+; alone, so UPDATE still means the last BLOCK or BUFFER. Otherwise this
+; is blk_get_.
+; Input:  EAX = block number
+; Output: EDI = data address, CF set = read error
+; Preserves EAX, ESI. Clobbers: EBX, ECX, EDX
+; ----------------------------------------------------------------------------
+blk_view_:
+    cmp dword [MEMDISK_BASE], 0
+    je blk_get_
+    cmp dword [blk_map_on], 0
+    je blk_get_
+    call blk_lookup_
+    test ebx, ebx
+    jz .map
+    test dword [ebx + BLK_HDR_FLAGS], BLK_BUF_FLAG_VALID
+    jz .map
+    call blk_touch_
+    mov edi, [ebx + BLK_HDR_DATA]
+    clc
+    ret
+.map:
+    mov edi, eax
+    shl edi, 10                     ; block# * 1024
+    add edi, COMBINED_HEADER_SIZE
+    add edi, [MEMDISK_BASE]
+    clc
+    ret
+
 ; ----------------------------------------------------------------------------
 ; blk_find_buffer - Find or allocate a buffer for a given block number
 ; Input:  EAX = block number
 ; Output: EDI = buffer data address
-;         EBX = header address
+;         EBX = header address (becomes BLK_BUF_CUR, moved to MRU)
 ;         CF set = buffer needs loading from disk, CF clear = already cached
-; Clobbers: ECX, EDX
+; A miss takes the least recently used buffer that no transfer has
+; claimed. If that one is dirty, only it is written back (blk_flush_one);
+; under WRITE-BEHIND the walk passes over dirty buffers and writes them
+; all back only when no clean one is left. A miss also runs an overdue
+; write-behind flush, for programs that never reach the input idle loop.
+; Preserves EAX. Clobbers: ECX, EDX
 ; ----------------------------------------------------------------------------
 blk_find_buffer:
+    call blk_lookup_
+    test ebx, ebx
+    jz .miss
+    test dword [ebx + BLK_HDR_FLAGS], BLK_BUF_FLAG_VALID
+    jz .reuse                       ; Left invalid by a failed read
+    mov [BLK_BUF_CUR], ebx
+    call blk_touch_
+    mov edi, [ebx + BLK_HDR_DATA]
+    clc                             ; Already cached
+    ret
+
+.miss:
+    mov ecx, [blk_wb_due]
+    test ecx, ecx
+    jz .pick
+    sub ecx, [isr_tick_count]
+    jg .pick                        ; Deadline not reached yet
+    push eax
+    call blk_flush_all_             ; preserves EBX, EDI, ESI
+    pop eax
+.pick:
+    mov ebx, [BLK_LRU + BLK_HDR_PREV]
+.victim:
+    cmp ebx, BLK_LRU
+    je .write_back                  ; Write-behind, nothing clean left
+    mov ecx, [ebx + BLK_HDR_FLAGS]
+    test ecx, BLK_BUF_FLAG_PENDING
+    jnz .skip
+    test ecx, BLK_BUF_FLAG_DIRTY
+    jz .claim
+    cmp dword [blk_wb_ticks], 0
+    jne .skip
+    push eax                        ; Write-through: just the victim
+    call blk_flush_one              ; preserves EBX, EDI, ESI
+    pop eax
+    jmp .claim                      ; (A failed write is reused, announced)
+.skip:
+    mov ebx, [ebx + BLK_HDR_PREV]
+    jmp .victim
+.write_back:
+    push eax                        ; Save requested block#
+    call blk_flush_all_             ; preserves EBX, EDI, ESI
+    pop eax
+    mov ebx, [BLK_LRU + BLK_HDR_PREV]
+.victim_any:
+    test dword [ebx + BLK_HDR_FLAGS], BLK_BUF_FLAG_PENDING
+    jz .claim                       ; (A failed write is reused, announced)
+    mov ebx, [ebx + BLK_HDR_PREV]
+    jmp .victim_any
+.claim:
+    call blk_rehash_
+.reuse:
+    mov dword [ebx + BLK_HDR_FLAGS], 0  ; Not valid yet, caller will set
+    mov [BLK_BUF_CUR], ebx
+    call blk_touch_
+    mov edi, [ebx + BLK_HDR_DATA]
+    stc                             ; Needs loading from disk
+    ret
+
+; ----------------------------------------------------------------------------
+; blk_get_ - Buffer for a block, reading it (plus read-ahead) if needed
+; Input:  EAX = block number
+; Output: EDI = buffer data address, EBX = header address
+;         CF set = read error (buffer left invalid, EDI still returned)
+; A miss reads the block and up to READ-AHEAD following blocks in one
+; ATA command; the last read-ahead block carries BLK_BUF_FLAG_AHEAD, and
+; a hit on it fetches the next window, so LOAD/THRU/--> stay ahead of the
+; interpreter instead of paying one command per block.
+; Preserves EAX, ESI. Clobbers: ECX, EDX
+; ----------------------------------------------------------------------------
+blk_get_:
+    call blk_find_buffer        ; EDI=buffer addr, EBX=header addr, CF=needs load
+    jc .miss
+    test dword [ebx + BLK_HDR_FLAGS], BLK_BUF_FLAG_AHEAD
+    jz .hit
+    ; A sequential reader reached the window marker: start the next window
+    and dword [ebx + BLK_HDR_FLAGS], ~BLK_BUF_FLAG_AHEAD
     push eax
-    mov edx, eax                ; EDX = requested block#
-
-    ; Search existing buffers for a match
-    mov ebx, BLK_BUF_HEADERS
-    mov ecx, BLK_NUM_BUFFERS
-.search:
-    cmp [ebx], edx              ; block# match?
-    jne .next_search
-    test dword [ebx + 4], BLK_BUF_FLAG_VALID
-    jz .next_search
-    ; Found! Update age for LRU
-    inc dword [BLK_BUF_CLOCK]
-    mov eax, [BLK_BUF_CLOCK]
-    mov [ebx + 8], eax          ; Update age
-    ; Calculate buffer index and data address
-    mov eax, ebx
-    sub eax, BLK_BUF_HEADERS
-    push edx
-    xor edx, edx
     push ebx
-    mov ebx, BLK_HEADER_SIZE
-    div ebx                     ; EAX = buffer index
+    push edi
+    inc eax
+    mov [blk_xfer_first], eax
+    xor eax, eax
+    mov [blk_xfer_count], eax
+    mov [blk_xfer_ahead], eax   ; Whole list is read-ahead
+    call blk_plan_ahead_
+    call blk_xfer_              ; A failed read-ahead is simply dropped
+    pop edi
+    pop ebx
+    pop eax
+.hit:
+    clc
+    ret
+
+.miss:
+    push eax
+    push ebx
+    push edi
+    mov [blk_xfer_first], eax
+    mov [blk_xfer_hdrs], ebx
+    mov dword [blk_xfer_count], 1
+    mov dword [blk_xfer_ahead], 1
+    or dword [ebx + BLK_HDR_FLAGS], BLK_BUF_FLAG_PENDING
+    call blk_plan_ahead_
+    call blk_xfer_
+    jnc .loaded
+    cmp dword [blk_xfer_count], 1
+    je .failed
+    ; A read-ahead block past the end of the disk fails the whole command:
+    ; retry the requested block on its own
+    mov dword [blk_xfer_count], 1
+    call blk_xfer_
+    jnc .loaded
+.failed:
+    pop edi
     pop ebx
-    pop edx
-    mov [BLK_BUF_CUR], eax
-    imul eax, BLOCK_SIZE
-    lea edi, [BLK_BUF_DATA + eax]
     pop eax
-    clc                         ; Already cached
+    stc
+    ret
+.loaded:
+    pop edi
+    pop ebx
+    pop eax
+    clc
     ret
 
-.next_search:
-    add ebx, BLK_HEADER_SIZE
-    dec ecx
-    jnz .search
+; ----------------------------------------------------------------------------
+; blk_plan_ahead_ - Append read-ahead blocks to the transfer list
+; Takes the blocks after the run (blk_xfer_first + blk_xfer_count ...) up
+; to READ-AHEAD of them, stopping at the first one already cached or when
+; no buffer can be spared (see blk_ra_victim_).
+; Skipped on memdisk boot: the RAM copy has no latency to hide.
+; Clobbers: EAX, EBX, ECX, EDX, EDI
+; ----------------------------------------------------------------------------
+blk_plan_ahead_:
+    cmp dword [MEMDISK_BASE], 0
+    jne .done
+    mov ecx, [blk_read_ahead]
+    cmp ecx, BLK_RA_MAX
+    jbe .capped
+    mov ecx, BLK_RA_MAX
+.capped:
+    mov eax, [blk_nbufs]
+    sub eax, 2                      ; Requested and source buffers stay
+    cmp ecx, eax
+    jbe .fits
+    mov ecx, eax
+.fits:
+    add ecx, [blk_xfer_ahead]       ; ECX = list length limit
+
+.next:
+    mov eax, [blk_xfer_count]
+    cmp eax, ecx
+    jae .done
+    add eax, [blk_xfer_first]       ; EAX = next block#
+    push ecx
+    call blk_lookup_
+    test ebx, ebx
+    jz .uncached
+    test dword [ebx + BLK_HDR_FLAGS], BLK_BUF_FLAG_VALID | BLK_BUF_FLAG_PENDING
+    jnz .stop                       ; Already there: the run ends here
+.uncached:
+    call blk_ra_victim_             ; EBX = header or 0
+    test ebx, ebx
+    jz .stop
+    call blk_rehash_
+    mov dword [ebx + BLK_HDR_FLAGS], BLK_BUF_FLAG_PENDING
+    call blk_touch_
+    mov edx, [blk_xfer_count]
+    mov [blk_xfer_hdrs + edx*4], ebx
+    inc dword [blk_xfer_count]
+    pop ecx
+    jmp .next
+.stop:
+    pop ecx
+.done:
+    ret
 
-    ; Not found — find a free buffer or LRU victim
-    mov ebx, BLK_BUF_HEADERS
-    mov ecx, BLK_NUM_BUFFERS
-    xor eax, eax                ; Best candidate index
-    mov edi, 0xFFFFFFFF         ; Lowest age so far (for LRU)
-    push esi                    ; Save temporarily
+; ----------------------------------------------------------------------------
+; blk_ra_victim_ - Pick a buffer read-ahead may take
+; The least recently used buffer that is clean, not claimed by this
+; transfer, not the latest BLOCK result (BLK_BUF_CUR) and not the one
+; being LOADed from (VAR_TIB). Read-ahead never writes anything back.
+; Output: EBX = header address, 0 = none
+; Clobbers: EDX
+; ----------------------------------------------------------------------------
+blk_ra_victim_:
+    mov ebx, [BLK_LRU + BLK_HDR_PREV]
+.scan:
+    cmp ebx, BLK_LRU
+    je .none
+    test dword [ebx + BLK_HDR_FLAGS], BLK_BUF_FLAG_DIRTY | BLK_BUF_FLAG_PENDING
+    jnz .skip
+    cmp ebx, [BLK_BUF_CUR]
+    je .skip
+    mov edx, [ebx + BLK_HDR_DATA]
+    cmp edx, [VAR_TIB]
+    jne .done
+.skip:
+    mov ebx, [ebx + BLK_HDR_PREV]
+    jmp .scan
+.none:
+    xor ebx, ebx
+.done:
+    ret
 
-    ; First pass: look for a free (invalid) buffer
-    mov esi, BLK_BUF_HEADERS
+; ----------------------------------------------------------------------------
+; blk_xfer_ - Read the transfer list and mark its buffers valid
+; Entries from blk_xfer_ahead on are read-ahead; the last of them gets the
+; AHEAD marker. On error every listed buffer is left invalid and the
+; read-ahead ones are released (unhashed).
+; Output: CF set = read error
+; Clobbers: EAX, EBX, ECX, EDX, EDI
+; ----------------------------------------------------------------------------
+blk_xfer_:
+    cmp dword [blk_xfer_count], 0
+    je .ok
+    cmp dword [MEMDISK_BASE], 0
+    jne .ram
+    call ata_read_blocks_
+    jc .fail
+.mark:
     xor ecx, ecx
-.find_free:
-    cmp ecx, BLK_NUM_BUFFERS
-    jge .find_lru
-    test dword [esi + 4], BLK_BUF_FLAG_VALID
-    jz .found_slot
-    ; Track LRU while searching
-    mov ebx, [esi + 8]         ; age
-    cmp ebx, edi
-    jge .not_older
-    mov edi, ebx               ; New lowest age
-    mov eax, ecx               ; Remember this index
-.not_older:
-    add esi, BLK_HEADER_SIZE
+.mark_loop:
+    mov ebx, [blk_xfer_hdrs + ecx*4]
+    mov dword [ebx + BLK_HDR_FLAGS], BLK_BUF_FLAG_VALID
     inc ecx
-    jmp .find_free
-
-.find_lru:
-    ; No free buffer — use LRU victim (index in EAX)
-    ; If victim is dirty, flush it first
-    imul ebx, eax, BLK_HEADER_SIZE
-    add ebx, BLK_BUF_HEADERS
-    test dword [ebx + 4], BLK_BUF_FLAG_DIRTY
-    jz .setup_slot
-    pop esi
-    push edx                   ; Save requested block#
-    call blk_flush_one
-    pop edx
-    push esi                   ; Re-save
-    jmp .setup_slot
+    cmp ecx, [blk_xfer_count]
+    jb .mark_loop
+    cmp ecx, [blk_xfer_ahead]
+    jbe .ok
+    or dword [ebx + BLK_HDR_FLAGS], BLK_BUF_FLAG_AHEAD
+.ok:
+    clc
+    ret
 
-.found_slot:
-    ; Free buffer at index ECX
-    mov eax, ecx
-    imul ebx, eax, BLK_HEADER_SIZE
-    add ebx, BLK_BUF_HEADERS
+.ram:
+    ; Memdisk: one block from the RAM image (no read-ahead planned)
+    mov eax, [blk_xfer_hdrs]
+    mov edi, [eax + BLK_HDR_DATA]
+    mov eax, [blk_xfer_first]
+    call ram_read_block
+    jmp .mark
 
-.setup_slot:
-    pop esi                    ; Restore
-    ; Set up the header
-    mov [ebx], edx             ; block#
-    mov dword [ebx + 4], 0    ; flags = 0 (not valid yet, caller will set)
-    inc dword [BLK_BUF_CLOCK]
-    mov ecx, [BLK_BUF_CLOCK]
-    mov [ebx + 8], ecx        ; age
-    mov [BLK_BUF_CUR], eax    ; Current buffer index
+.fail:
+    xor edi, edi
+.fail_loop:
+    mov ebx, [blk_xfer_hdrs + edi*4]
+    mov dword [ebx + BLK_HDR_FLAGS], 0
+    cmp edi, [blk_xfer_ahead]
+    jb .fail_next
+    mov eax, 0xFFFFFFFF
+    call blk_rehash_
+.fail_next:
+    inc edi
+    cmp edi, [blk_xfer_count]
+    jb .fail_loop
+    stc
+    ret
 
-    ; Calculate data address
-    imul eax, BLOCK_SIZE
-    lea edi, [BLK_BUF_DATA + eax]
+; ----------------------------------------------------------------------------
+; trace_log_ - Append one ECHOPORT entry (TRACE_PORT)
+; Stack: type, pushed by the macro (popped on return). DX = port, EAX =
+; value, ESI = caller. A port outside every TRACE-FILTERS range is not
+; logged. On a full ring the TRACE-DRAIN xt gets one call to make room,
+; but only with IF set: an ISR, a hook or an INT-SAVE section must not
+; sit on a polled UART. Otherwise, or if the drain freed nothing, the
+; oldest entry is overwritten and counted in trace_lost. The idle loop
+; in read_key drains the rest. Preserves all registers.
+; ----------------------------------------------------------------------------
+trace_log_:
+    pushad                      ; EAX at [esp+28], EDX [esp+20], ESI [esp+4]
+    mov ecx, [trace_nfilt]
+    test ecx, ecx
+    jz .keep
+    cmp ecx, TRACE_FILTERS
+    jbe .filters
+    mov ecx, TRACE_FILTERS
+.filters:
+    mov edi, trace_filt
+.filter:
+    cmp dx, [edi]
+    jb .filter_next
+    cmp dx, [edi + 2]
+    jbe .keep
+.filter_next:
+    add edi, 4
+    dec ecx
+    jnz .filter
+    jmp .done
+.keep:
+    mov eax, [trace_head]
+    sub eax, [trace_tail]
+    cmp eax, [trace_mask]
+    jbe .room                   ; Fewer than mask+1 entries in use
+    pushfd
+    pop eax
+    test eax, 0x200             ; IF clear: interrupt context, no drain
+    jz .overwrite
+    call trace_run_drain_
+    mov eax, [trace_head]
+    sub eax, [trace_tail]
+    cmp eax, [trace_mask]
+    jbe .room
+.overwrite:
+    inc dword [trace_tail]
+    inc dword [trace_lost]
+.room:
+    mov ebx, [trace_head]
+    and ebx, [trace_mask]
+    shl ebx, 4                  ; TRACE_ENTRY_SZ
+    add ebx, [trace_base]
+    mov eax, [esp + 36]
+    mov [ebx], al               ; type
+    mov byte [ebx + 1], 0       ; pad
+    mov edx, [esp + 20]
+    mov [ebx + 2], dx           ; port
+    mov eax, [esp + 28]
+    mov [ebx + 4], eax          ; value
+    mov eax, [esp + 4]
+    mov [ebx + 8], eax          ; caller (Forth IP)
+    xor eax, eax
+    cmp dword [tsc_khz], 0
+    je .stamp
+    rdtsc
+.stamp:
+    mov [ebx + 12], eax         ; tsc
+    inc dword [trace_head]
+    inc dword [trace_count]
+.done:
+    popad
+    ret 4
 
-    pop eax                    ; Restore original block#
-    stc                        ; Needs loading from disk
+; ----------------------------------------------------------------------------
+; trace_run_drain_ - Run the TRACE-DRAIN xt once, if there is one, with
+; tracing off so its own I/O is not logged; trace_enabled is put back to
+; what the caller had. Clobbers: EAX, ECX, EDX (execute_xt)
+; ----------------------------------------------------------------------------
+trace_run_drain_:
+    mov eax, [trace_drain]
+    test eax, eax
+    jz .done
+    movzx ecx, byte [trace_enabled]
+    push ecx
+    mov byte [trace_enabled], 0
+    push ebx
+    call execute_xt
+    pop ebx
+    pop ecx
+    mov [trace_enabled], cl
+.done:
     ret
 
 ; ----------------------------------------------------------------------------
@@ -5115,6 +9151,7 @@ align 4
 exec_xt_resume:
     dd exec_xt_resume_code      ; CFA: code field -> resume code
 exec_xt_resume_code:
+    SPILL                       ; asm caller expects the whole stack in memory
     POPRSP esi                  ; restore Forth IP
     POPRSP edx                  ; asm return address
     jmp edx
@@ -5135,43 +9172,11 @@ blk_flush_one:
     push ebx
     push edi
 
-    ; Calculate buffer data address from header address
-    mov eax, ebx
-    sub eax, BLK_BUF_HEADERS
-    push edx
-    push ebx
-    xor edx, edx
-    mov ecx, BLK_HEADER_SIZE
-    div ecx                     ; EAX = buffer index
-    pop ebx
-    pop edx
-
 %ifdef DEBUG_FLUSH
-    ; Trace entry: F<slot> <block#_hex> <flags_hex>
-    push eax                    ; save buffer index
-    push eax
-    mov al, 'F'
-    call serial_putchar
-    pop eax
-    add al, '0'                 ; slot index as ASCII digit
-    call serial_putchar
-    mov al, ' '
-    call serial_putchar
-    mov eax, [ebx]              ; block#
-    call serial_print_hex
-    mov al, ' '
-    call serial_putchar
-    mov eax, [ebx + 4]          ; flags
-    call serial_print_hex
-    mov al, 13
-    call serial_putchar
-    mov al, 10
-    call serial_putchar
-    pop eax                     ; restore buffer index
+    call blk_trace_flush_
 %endif
 
-    imul eax, BLOCK_SIZE
-    add eax, BLK_BUF_DATA       ; EAX = buffer data address
+    mov eax, [ebx + BLK_HDR_DATA] ; EAX = buffer data address
 
     ; Invoke active writer through the vector: ( buf-addr blk# -- ior )
     push eax                    ; buf-addr (under)
@@ -5195,6 +9200,7 @@ blk_flush_one:
 .write_fail:
     ; Loud failure: announce the loss, leave buffer DIRTY.
     ; (EBX/EDI already restored — both exit paths pop what entry pushed.)
+    inc dword [blk_flush_errs]
     push dword [ebx]            ; blk# — print calls below clobber registers
     push esi
     mov esi, msg_blk_write_fail
@@ -5208,7 +9214,178 @@ blk_flush_one:
     call print_char
     ret
 
+; ----------------------------------------------------------------------------
+; blk_flush_all_ - Write back every dirty buffer, in block order
+; Dirty headers are insertion-sorted by block number into BLK_DIRTY_LIST.
+; A run of consecutive blocks goes to the run writer in one call when
+; one is installed for the active writer (BLK-RUN-WRITER!); single blocks,
+; and runs the run writer refused, go through blk_flush_one so each
+; failure is announced. Cancels a pending write-behind deadline.
+; Preserves EBX, EDI, ESI (Forth IP). Clobbers: EAX, ECX, EDX
+; ----------------------------------------------------------------------------
+blk_flush_all_:
+    push ebx
+    push edi
+    mov dword [blk_wb_due], 0
+    xor edx, edx                ; EDX = dirty count
+    mov ebx, BLK_POOL_HDRS
+.collect:
+    test dword [ebx + BLK_HDR_FLAGS], BLK_BUF_FLAG_DIRTY
+    jz .next_hdr
+    mov edi, edx
+.shift:
+    test edi, edi
+    jz .put
+    mov eax, [BLK_DIRTY_LIST + edi*4 - 4]
+    mov ecx, [eax + BLK_HDR_BLOCK]
+    cmp ecx, [ebx + BLK_HDR_BLOCK]
+    jbe .put
+    mov [BLK_DIRTY_LIST + edi*4], eax
+    dec edi
+    jmp .shift
+.put:
+    mov [BLK_DIRTY_LIST + edi*4], ebx
+    inc edx
+.next_hdr:
+    add ebx, BLK_HEADER_SIZE
+    mov eax, [blk_nbufs]
+    shl eax, 5                  ; x BLK_HEADER_SIZE
+    add eax, BLK_POOL_HDRS
+    cmp ebx, eax
+    jb .collect
+    mov [blk_flush_n], edx
+
+    xor edi, edi                ; EDI = list index of the run start
+.run:
+    cmp edi, [blk_flush_n]
+    jae .done
+    mov ebx, [BLK_DIRTY_LIST + edi*4]
+    mov eax, [ebx + BLK_HDR_BLOCK]
+    mov ecx, 1                  ; ECX = run length
+.extend:
+    cmp ecx, BLK_RUN_MAX
+    jae .have_run
+    lea edx, [edi + ecx]
+    cmp edx, [blk_flush_n]
+    jae .have_run
+    mov edx, [BLK_DIRTY_LIST + edx*4]
+    inc eax
+    cmp [edx + BLK_HDR_BLOCK], eax
+    jne .have_run
+    inc ecx
+    jmp .extend
+.have_run:
+    cmp ecx, 1
+    je .each
+    cmp dword [blk_run_writer], 0
+    je .each
+    mov eax, [blk_run_writer_for]
+    cmp eax, [BLK_WRITE_VEC]
+    jne .each
+    call blk_flush_run_         ; preserves ECX, EDI
+    jc .each                    ; Refused: retry block by block
+    add edi, ecx
+    jmp .run
+.each:
+    push ecx
+.each_loop:
+    mov ebx, [BLK_DIRTY_LIST + edi*4]
+    call blk_flush_one          ; preserves EBX, EDI
+    inc edi
+    dec dword [esp]
+    jnz .each_loop
+    pop ecx
+    jmp .run
+.done:
+    pop edi
+    pop ebx
+    ret
+
+; ----------------------------------------------------------------------------
+; blk_flush_run_ - Stage a run of dirty buffers and hand it to the run writer
+; Input:  EDI = BLK_DIRTY_LIST index of the first block, ECX = run length
+; Output: CF clear = written (dirty flags cleared), CF set = writer failed
+; Preserves ECX, EDI, ESI (Forth IP). Clobbers: EAX, EBX, EDX
+; ----------------------------------------------------------------------------
+blk_flush_run_:
+    push ecx
+    push edi
+    push esi
+    lea ebx, [BLK_DIRTY_LIST + edi*4]
+    mov edx, ecx
+    mov edi, BLK_STAGE
+.copy:
+    mov eax, [ebx]
+%ifdef DEBUG_FLUSH
+    push ebx
+    mov ebx, eax
+    call blk_trace_flush_
+    mov eax, ebx
+    pop ebx
+%endif
+    mov esi, [eax + BLK_HDR_DATA]
+    mov ecx, BLOCK_SIZE / 4
+    rep movsd
+    add ebx, 4
+    dec edx
+    jnz .copy
+    pop esi
+
+    ; Invoke the run writer: ( buf-addr blk# n -- ior )
+    mov edi, [esp]              ; Run start index
+    mov ecx, [esp + 4]          ; Run length
+    mov eax, [BLK_DIRTY_LIST + edi*4]
+    push dword BLK_STAGE
+    push dword [eax + BLK_HDR_BLOCK]
+    push ecx
+    mov eax, [blk_run_writer]
+    call execute_xt             ; preserves ESI; clobbers EAX/ECX/EDX
+    pop eax                     ; ior
+    pop edi
+    pop ecx
+    test eax, eax
+    jnz .fail
+
+    xor edx, edx
+.clean:
+    lea eax, [edi + edx]
+    mov eax, [BLK_DIRTY_LIST + eax*4]
+    and dword [eax + BLK_HDR_FLAGS], ~BLK_BUF_FLAG_DIRTY
+    inc edx
+    cmp edx, ecx
+    jb .clean
+    clc
+    ret
+.fail:
+    stc
+    ret
+
 %ifdef DEBUG_FLUSH
+; ----------------------------------------------------------------------------
+; blk_trace_flush_ - Serial trace of a write-back: F<slot> <block#> <flags>
+; Input: EBX = header address. Clobbers: EAX
+; ----------------------------------------------------------------------------
+blk_trace_flush_:
+    mov al, 'F'
+    call serial_putchar
+    mov eax, ebx
+    sub eax, BLK_POOL_HDRS
+    shr eax, 5                  ; slot index (BLK_HEADER_SIZE = 32)
+    call serial_print_hex
+    mov al, ' '
+    call serial_putchar
+    mov eax, [ebx]              ; block#
+    call serial_print_hex
+    mov al, ' '
+    call serial_putchar
+    mov eax, [ebx + 4]          ; flags
+    call serial_print_hex
+    mov al, 13
+    call serial_putchar
+    mov al, 10
+    call serial_putchar
+    ret
+
 ; ----------------------------------------------------------------------------
 ; serial_print_hex - Print 8-digit hex number in EAX to serial port only
 ; (Does not touch VGA, unlike print_hex which calls print_char)
@@ -5252,6 +9429,8 @@ cold_start:
 ; Data
 ; ============================================================================
 
+kernel_code_end:                    ; kernel_hash_ covers kernel_start up to here
+
 cursor_x:       dd 0
 cursor_y:       dd 0
 
@@ -5261,12 +9440,22 @@ shift_held:     db 0                ; 1 = Shift key currently pressed
 caps_lock:      db 0                ; 1 = Caps Lock active
 serial_present: db 1                ; 0 = no COM1 hardware (set by init_serial probe)
 break_flag:     db 0                ; 1 = Ctrl+C detected, pending break
+ser_tx_armed:   db 0                ; 1 = THR-empty interrupt enabled
+                align 4
+ser_irq_on:     dd 0                ; SERIAL-IRQ: -1 = isr_serial owns COM1
+ser_tx_head:    dd 0                ; SER_TX_RING bytes queued (free-running)
+ser_tx_tail:    dd 0                ; SER_TX_RING bytes sent
+ser_rx_head:    dd 0                ; SER_RX_RING bytes received
+ser_rx_tail:    dd 0                ; SER_RX_RING bytes read by KEY
+ser_rx_lost:    dd 0                ; SERIAL-LOST
                 align 4
 save_esp:       dd 0                ; Snapshot: data stack pointer
 save_ebp:       dd 0                ; Snapshot: return stack pointer
 save_state:     dd 0                ; Snapshot: compiler STATE
 save_here:      dd 0                ; Snapshot: dictionary HERE pointer
 save_latest:    dd 0                ; Snapshot: LATEST word pointer
+save_current:   dd 0                ; Snapshot: CURRENT (compilation vocab cell)
+save_current_head: dd 0             ; Snapshot: that vocab's chain head
 
 msg_welcome:    db 'Bare-Metal Forth v0.1 - Ship Builders System', 13, 10
                 db 'Type WORDS to see available commands', 13, 10, 0
@@ -5331,23 +9520,109 @@ more_enabled:       db 0            ; 0 = off (default), 1 = on
                     align 4
 more_lines:         dd 0            ; Lines printed since last pause
 
+sse2_ok:            dd 0            ; -1 = init_sse enabled SSE2
+erms_ok:            dd 0            ; -1 = CPU has ERMSB (init_erms)
+tsc_khz:            dd 0            ; TSC-KHZ: cycles per ms (init_tsc), 0 = none
+tsc_deadline:       dd 0, 0         ; 64-bit TSC deadline (tsc_deadline_)
+boot_tsc:           times BOOT_STAMPS dd 0, 0   ; boot_stamp_ slots
+paging_on:          dd 0            ; -1 = PAGING-ON built the identity map
+pat_ok:             dd 0            ; -1 = PAT entry 4 is write-combining
+tlb_shootdown:      dd 0            ; TLB-SHOOTDOWN: xt run by LFB-WC, 0 = none
+
+; Cooperative tasks
+task_cur:           dd 0            ; Running TCB, 0 = tasks off
+task_switches:      dd 0
+main_task:          times TCB_SIZE db 0   ; Interpreter's TCB (stacks are the boot ones)
+
+; Application processors
+cpu_count:          dd 1            ; CPUs started; cpu_index is 0 while 1
+lapic_base:         dd 0xFEE00000
+cpu_by_apic:        times 256 db 0  ; Local APIC ID -> CPU number
+cpu_table:          dd 0, 0, CPU_RUN, DATA_STACK_TOP, RETURN_STACK_TOP, 0, 0, 0
+                    times PCPU_SIZE - 32 db 0
+                    times (CPU_MAX - 1) * PCPU_SIZE db 0
+
 ; Net console state (UDP output mirror)
 net_console_enabled:    db 0        ; 1 = mirror output to UDP
 net_flushing:           db 0        ; 1 = flush in progress (re-entrancy guard)
                         align 4
 net_buf_pos:            dd 0        ; Current position in output buffer
-net_rtl_base:           dd 0        ; Copy of RTL-BASE (MMIO address)
+net_rtl_base:           dd 0        ; Copy of RTL-BASE (MMIO, or RTL8139 I/O port)
 net_tx_desc:            dd 0        ; TX descriptor physical address
-net_tx_buf:             dd 0        ; TX frame buffer physical address
+net_tx_buf:             dd 0        ; TX buffer slot 0 physical address
+net_tx_n:               dd 1        ; Descriptors in the TX ring
+net_tx_kind:            dd NET_KIND_8168 ; NET-TX-KIND
+net_tx_slot:            dd 0        ; Slot being filled
+net_con_max:            dd 256      ; Payload bytes that force a flush
+net_first_tick:         dd 0        ; Tick of the frame's first character
 net_pkt_id:             dd 0        ; IP packet ID counter
-net_frame_hdr:          times 42 db 0   ; Pre-built Ethernet+IP+UDP header
-net_buf:                times 256 db 0  ; Output character buffer
+net_frame_hdr:          times NET_HDR_SIZE db 0 ; Pre-built Ethernet+IP+UDP header
+
+; Dictionary hash index state (tables live at DICT_HASH_BUCKETS)
+dict_hash_ok:       db 0            ; 1 = index complete, find_ may trust it
+                    align 4
+dict_hash_count:    dd 0            ; Nodes in use
+dict_hash_top:      dd 0            ; Highest indexed header address
+dict_hash_nvocabs:  dd 0            ; Rebuild worklist length
+
+; Dictionary snapshot boot (see snap_restore_)
+snap_booted:        dd 0            ; SNAPSHOT-BOOT variable
+
+; Block read path (see blk_get_, ata_read_blocks_)
+blk_read_ahead:     dd 2            ; READ-AHEAD: blocks fetched past a miss
+blk_nbufs:          dd BLK_POOL_DEFAULT ; #BUFFERS: headers in the pool
+blk_map_on:         dd -1           ; MEMDISK-MAP: LIST/BLOCK-VIEW map memdisk blocks
+blk_wb_ticks:       dd 0            ; WRITE-BEHIND: flush deadline in ticks (0 = off)
+blk_wb_due:         dd 0            ; Tick count the deadline expires at (0 = none)
+blk_watch:          dd 0, 0, 0      ; BLK-WATCH: first block, count, UPDATE generation
+blk_flush_n:        dd 0            ; Entries in BLK_DIRTY_LIST
+blk_flush_errs:     dd 0            ; Blocks the writers refused (BLK-BARRIER ior)
+blk_run_writer:     dd BLKWRITERUNATA ; Run writer XT (BLK-RUN-WRITER!)
+blk_run_writer_for: dd BLKWRITEATA  ; Block writer the run writer belongs to
+blk_xfer_first:     dd 0            ; First block# of the transfer run
+blk_xfer_count:     dd 0            ; Entries in blk_xfer_hdrs
+blk_xfer_ahead:     dd 0            ; Index of the first read-ahead entry
+blk_xfer_hdrs:      times BLK_RA_MAX + 1 dd 0
+ata_probed:         dd 0            ; ata_probe_ has run
+ata_multi:          dd 0            ; Sectors per READ MULTIPLE DRQ, 0 = off
+ata_dma_base:       dd 0            ; Bus-master IDE base, 0 = PIO (ATA-DMA)
+
+; Peephole optimizer state (see peep_compile_)
+peep_enabled:       dd -1           ; PEEPHOLE variable
+peep_here:          dd 0            ; HERE after the last fused-path compile
+peep_n:             dd 0            ; Valid entries in peep_hist
+peep_hist:          times PEEP_DEPTH dd 0
+
+; Rules: first XT, second XT, third XT (0 = pair), fused XT,
+; 1 + history index of the item whose operand the fused XT keeps (0 = none).
+; History index 0 is the newest item. Later rules may match the output of
+; earlier ones: 2DUP ! SWAP 4 + SWAP -> (2DUP!) (UNDER+) 4 -> (2DUP!UNDER+) 4.
+peep_rules:
+    dd LIT,         ADD, 0,       LITPLUS,          2
+    dd SWAP,        LITPLUS, SWAP, UNDERPLUS,       2
+    dd TWODUP,      STORE, 0,     TWODUPSTORE,      0
+    dd TWODUPSTORE, UNDERPLUS, 0, TWODUPSTOREUNDER, 1
+    dd FETCH,       ADD, 0,       FETCHPLUS,        0
+    dd DUP,         ZEQU, 0,      DUPZEQU,          0
+    dd OVER,        ADD, 0,       OVERPLUS,         0
+    dd 0
+
+; Profiler sampler state
+prof_sampling:      dd 0            ; PROF-SAMPLING: 0 = off
+prof_head:          dd 0            ; Samples taken (ring index via AND mask)
 
 ; ECHOPORT trace state
 trace_enabled:      db 0            ; 0 = off, 1 = on
                     align 4
 trace_head:         dd 0            ; Next write index (wraps via AND mask)
+trace_tail:         dd 0            ; Oldest unread index (TRACE-TAIL)
 trace_count:        dd 0            ; Total entries logged (may exceed BUF_SIZE)
+trace_lost:         dd 0            ; Entries overwritten (TRACE-LOST)
+trace_base:         dd trace_buf    ; Ring in use (TRACE-RING!)
+trace_mask:         dd TRACE_BUF_SIZE - 1
+trace_drain:        dd 0            ; TRACE-DRAIN xt, 0 = wrap
+trace_nfilt:        dd 0            ; TRACE-#FILT
+trace_filt:         times TRACE_FILTERS dd 0    ; [lo:2][hi:2] port ranges
 trace_buf:          times (TRACE_BUF_SIZE * TRACE_ENTRY_SZ) db 0
 
 ; ============================================================================
@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+"""Run the BENCH vocabulary and compare against a stored baseline.
+
+Loads BENCH (and its REQUIRES) with LOAD-VOCAB, runs BENCH-RUN and
+collects the JSON lines it prints between BENCH-BEGIN and BENCH-END.
+Each line is one workload: {"bench": name, "iters": n, "us": t}, t
+being the fastest of BN-REPS runs.
+
+The results are written to --out. With a baseline file, a workload
+whose time grew by more than --tolerance (fraction) and by more than
+--floor microseconds is a regression, and the exit status is 1.
+--update stores this run as the new baseline instead.
+
+Usage:
+    python3 tests/bench.py PORT [--baseline FILE] [--out FILE]
+                                [--tolerance 0.25] [--floor 50]
+                                [--update]
+
+QEMU must be running with the block disk attached on PORT. BENCH
+overwrites blocks 1900-1915 of that disk.
+"""
+import argparse
+import json
+import os
+import socket
+import sys
+import time
+
+p = argparse.ArgumentParser()
+p.add_argument('port', type=int, nargs='?', default=4560)
+p.add_argument('--baseline')
+p.add_argument('--out')
+p.add_argument('--tolerance', type=float, default=0.25)
+p.add_argument('--floor', type=int, default=50)
+p.add_argument('--update', action='store_true')
+args = p.parse_args()
+
+s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+s.settimeout(10)
+
+for attempt in range(20):
+    try:
+        s.connect(('127.0.0.1', args.port))
+        break
+    except (ConnectionRefusedError, OSError):
+        time.sleep(0.5)
+else:
+    print("FAIL: Could not connect to QEMU on port", args.port)
+    sys.exit(1)
+
+time.sleep(2)
+try:
+    while True:
+        s.recv(4096)
+except Exception:
+    pass
+
+
+def send(cmd, wait=1.0):
+    """Send a Forth command and collect the response."""
+    s.sendall((cmd + '\r').encode())
+    time.sleep(wait)
+    s.settimeout(2)
+    resp = b''
+    while True:
+        try:
+            d = s.recv(4096)
+            if not d:
+                break
+            resp += d
+        except Exception:
+            break
+    return resp.decode('ascii', errors='replace')
+
+
+def send_until(cmd, marker, timeout=180):
+    """Send a command and read until marker appears (or timeout)."""
+    s.sendall((cmd + '\r').encode())
+    s.settimeout(1)
+    resp = ''
+    deadline = time.time() + timeout
+    while marker not in resp and time.time() < deadline:
+        try:
+            d = s.recv(4096)
+            if not d:
+                break
+            resp += d.decode('ascii', errors='replace')
+        except Exception:
+            pass
+    return resp
+
+
+# ---- Load and run ----
+print("Loading BENCH...")
+r = send('S" BENCH" LOAD-VOCAB', 20)
+if '?' in r:
+    print(f"FAIL: LOAD-VOCAB BENCH: {r.strip()!r}")
+    sys.exit(1)
+
+print("Running BENCH-RUN...")
+r = send_until('USING BENCH BENCH-RUN', 'BENCH-END')
+if 'BENCH-END' not in r:
+    print(f"FAIL: no BENCH-END: {r.strip()[-400:]!r}")
+    sys.exit(1)
+
+khz = 0
+results = {}
+body = r.split('BENCH-BEGIN', 1)[-1].split('BENCH-END', 1)[0]
+for line in body.splitlines():
+    line = line.strip()
+    if not line.startswith('{'):
+        continue
+    try:
+        obj = json.loads(line)
+    except ValueError:
+        print(f"FAIL: bad JSON line {line!r}")
+        sys.exit(1)
+    if 'khz' in obj:
+        khz = obj['khz']
+    else:
+        results[obj['bench']] = {'iters': obj['iters'], 'us': obj['us']}
+
+if not results:
+    print("FAIL: BENCH-RUN printed no results")
+    sys.exit(1)
+
+run = {'khz': khz, 'results': results}
+if args.out:
+    os.makedirs(os.path.dirname(os.path.abspath(args.out)), exist_ok=True)
+    with open(args.out, 'w') as f:
+        json.dump(run, f, indent=2, sort_keys=True)
+
+if args.update:
+    if not args.baseline:
+        print("FAIL: --update needs --baseline")
+        sys.exit(1)
+    os.makedirs(os.path.dirname(os.path.abspath(args.baseline)),
+                exist_ok=True)
+    with open(args.baseline, 'w') as f:
+        json.dump(run, f, indent=2, sort_keys=True)
+    print(f"Baseline written: {args.baseline}")
+
+base = {}
+if args.baseline and not args.update:
+    if os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            base = json.load(f).get('results', {})
+    else:
+        print(f"No baseline at {args.baseline} (make bench-baseline)")
+
+# ---- Report ----
+print(f"\nTSC: {khz} kHz")
+print(f"{'bench':<14}{'iters':>7}{'us':>11}{'us/iter':>10}"
+      f"{'baseline':>11}{'change':>9}")
+regressions = []
+for name, res in results.items():
+    us, iters = res['us'], res['iters']
+    per = us / iters if iters else 0
+    line = f"{name:<14}{iters:>7}{us:>11}{per:>10.1f}"
+    old = base.get(name)
+    if old is not None and old['us']:
+        change = (us - old['us']) / old['us']
+        line += f"{old['us']:>11}{change:>+9.1%}"
+        if change > args.tolerance and us - old['us'] > args.floor:
+            regressions.append(name)
+            line += '  REGRESSION'
+    print(line)
+
+for name in base:
+    if name not in results:
+        print(f"{name:<14} missing from this run")
+
+if regressions:
+    print(f"\nFAIL: {len(regressions)} regression(s): "
+          f"{', '.join(regressions)}")
+    sys.exit(1)
+print("\nBench complete")
+sys.exit(0)
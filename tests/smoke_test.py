@@ -70,6 +70,35 @@ r = send(': COUNTUP 5 0 DO I . LOOP ;')
 r = send('COUNTUP')
 check('DO/LOOP', r, '0')
 
+# Test 7: FILL / CMOVE / MOVE / CELL-FILL across the dword head and tail
+send('CREATE BUF 600 ALLOT', 1.0)
+r = send('BUF 300 0 FILL BUF 1+ 257 65 FILL '
+         'BUF C@ . BUF 1+ C@ . BUF 257 + C@ . BUF 258 + C@ .')
+check('FILL', r, '0 65 65 0')
+r = send('7 BUF C! BUF BUF 1+ 40 CMOVE BUF 40 + C@ .')
+check('CMOVE overlapping forward propagates', r, '7')
+send(': SEQ 300 0 DO I BUF I + C! LOOP ; SEQ', 1.0)
+r = send('BUF BUF 3 + 290 MOVE BUF 293 + C@ . BUF 3 + C@ .')
+check('MOVE overlapping', r, '34 0')
+r = send('BUF 300 0 FILL BUF 5 305419896 CELL-FILL '
+         'BUF 16 + @ . BUF 20 + @ .')
+check('CELL-FILL', r, '305419896 0')
+
+# Test 8: TSC calibrated at boot; TSC-WAIT waits that long
+r = send('TSC-KHZ @ 0> .')
+check('TSC-KHZ calibrated', r, '-1')
+r = send('TSC@ 10000 TSC-WAIT TSC@ SWAP - CYCLES>US 9990 > .')
+check('TSC-WAIT 10ms', r, '-1')
+
+# Test 9: COM1 on IRQ4 rings; type-ahead past the 16-byte FIFO survives
+r = send('SERIAL-IRQ @ .')
+check('SERIAL-IRQ on', r, '-1')
+ahead = '1 DROP ' * 30 + '777 .'
+r = send('500000 TSC-WAIT\r' + ahead, 2.0)
+check('Type-ahead during TSC-WAIT', r, '777')
+r = send('SERIAL-LOST @ 0= .')
+check('No received bytes lost', r, '-1')
+
 # Summary
 print()
 TOTAL = PASS + FAIL
@@ -190,6 +190,30 @@ print('  Testing ORDER...')
 r = send_cmd('ORDER', 1)
 check('ORDER shows search order', r, 'Search:')
 
+# Test 6: LOAD-VOCAB memoizes; the index rebuilds after UPDATE
+print('  Testing catalog index...')
+r = send_cmd('S\" SHUTDOWN\" LOAD-VOCAB', 8)
+check_not('LOAD-VOCAB SHUTDOWN (no error)', r, '?')
+r = send_cmd('S\" SHUTDOWN\" VOCAB-LOADED? .', 0.5)
+check('VOCAB-LOADED? after LOAD-VOCAB', r, '-1')
+r = send_cmd('ALSO CATALOG-RESOLVER CI-FRESH? .', 0.5)
+check('Index current after lookup', r, '-1')
+r = send_cmd('1 BLOCK DROP UPDATE CI-FRESH? .', 0.5)
+check('UPDATE of a catalog block invalidates', r, '0')
+r = send_cmd('S\" SHUTDOWN\" CATALOG-FIND . 2DROP CI-FRESH? . PREVIOUS', 0.5)
+check('Lookup rebuilds the index', r, '-1 -1')
+
+# Test 7: the memo is dropped once the vocabulary word is gone
+# (a forged memo for MIRROR, never loaded, stands in for FORGET)
+print('  Testing stale memo...')
+r = send_cmd('ALSO CATALOG-RESOLVER S\" MIRROR\" CI-FIND '
+             'CI-FLAGS + DUP @ CI-DONE CI-VOC OR OR SWAP ! PREVIOUS', 0.5)
+check_not('Forge MIRROR memo (no error)', r, '?')
+r = send_cmd('S\" MIRROR\" VOCAB-LOADED? .', 0.5)
+check('Memo without its vocabulary is ignored', r, '0 ')
+r = send_cmd('S\" SHUTDOWN\" VOCAB-LOADED? .', 0.5)
+check('Memo with its vocabulary still holds', r, '-1')
+
 # Summary
 print()
 TOTAL = PASS + FAIL
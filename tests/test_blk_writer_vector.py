@@ -119,9 +119,8 @@ def main():
     chk('writer called exactly once', r, '1 ')
     r = cmd(s, 'WBLK @ .')
     chk('blk# arg = 199', r, '199 ')
-    # buf-addr must lie inside BLK_BUF_DATA (0x28200-0x29200 =
-    # 164352-168448 decimal)
-    r = cmd(s, 'WBUF @ DUP 164351 > SWAP 168449 < AND .')
+    # buf-addr must lie inside the buffer pool's data area
+    r = cmd(s, 'WBUF @ DUP BLK-POOL-DATA 1- > SWAP BLK-POOL-END < AND .')
     chk('buf-addr inside buffer pool', r, '-1 ')
     r = cmd(s, 'DEPTH .')
     chk('stacks balanced after trampoline', r, '0 ')
@@ -0,0 +1,193 @@
+#!/usr/bin/env python3
+"""Test the hashed, LRU-ordered block buffer pool.
+
+Needs the IDE slave image (test-vocabs topology). Checks the boot pool
+size, that a working set larger than the old 4-slot cache stays resident,
+BLK-BUFFERS resizing and clamping, that dirty buffers survive both a
+resize and eviction from a small pool (which writes back only the
+victim), and write-behind: a coalesced out-of-order flush, the idle-loop
+and buffer-miss background flushes and BLK-BARRIER.
+"""
+import socket
+import time
+import sys
+
+PORT = int(sys.argv[1]) if len(sys.argv) > 1 else 4518
+
+s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+s.settimeout(10)
+for attempt in range(20):
+    try:
+        s.connect(('127.0.0.1', PORT))
+        break
+    except (ConnectionRefusedError, OSError):
+        time.sleep(0.5)
+else:
+    print("FAIL: connect")
+    sys.exit(1)
+
+time.sleep(2)
+try:
+    while True:
+        s.recv(4096)
+except Exception:
+    pass
+
+
+def send(cmd, wait=1.0):
+    s.sendall((cmd + '\r').encode())
+    time.sleep(wait)
+    s.settimeout(2)
+    resp = b''
+    while True:
+        try:
+            d = s.recv(4096)
+            if not d:
+                break
+            resp += d
+        except Exception:
+            break
+    return resp.decode('ascii', errors='replace')
+
+
+def extract_number(text):
+    words = text.replace('\r', ' ').replace('\n', ' ').split()
+    for i in range(len(words) - 1, -1, -1):
+        if words[i] in ('ok', 'OK'):
+            if i > 0:
+                try:
+                    return int(words[i - 1])
+                except ValueError:
+                    pass
+    return None
+
+
+PASS = FAIL = 0
+
+
+def check(name, ok, detail=''):
+    global PASS, FAIL
+    if ok:
+        PASS += 1
+        print(f'  PASS: {name}')
+    else:
+        FAIL += 1
+        print(f'  FAIL: {name} -- {detail}' if detail else
+              f'  FAIL: {name}')
+
+
+# Test 1: Boot pool size
+print("\nTest 1: Defaults")
+r = send('#BUFFERS .', 1)
+val = extract_number(r)
+check('#BUFFERS default', val == 256, f'expected 256, got {val}')
+
+# Test 2: 64 blocks stay resident (same buffer on the second pass)
+print("\nTest 2: Working set larger than 4 blocks")
+send('CREATE BC-ADDR 64 CELLS ALLOT', 1)
+send(': BC-FILL 64 0 DO 100 I + BLOCK BC-ADDR I CELLS + ! LOOP ;', 1)
+send(': BC-SAME ( -- n ) 0 64 0 DO 100 I + BLOCK '
+     'BC-ADDR I CELLS + @ = IF 1+ THEN LOOP ;', 1)
+r = send('EMPTY-BUFFERS BC-FILL BC-SAME .', 3)
+val = extract_number(r)
+check('All 64 blocks still cached', val == 64, f'expected 64, got {val}')
+
+# Test 3: Resize and clamp
+print("\nTest 3: BLK-BUFFERS")
+r = send('16 BLK-BUFFERS #BUFFERS .', 1)
+val = extract_number(r)
+check('Resized to 16', val == 16, f'expected 16, got {val}')
+r = send('2 BLK-BUFFERS #BUFFERS .', 1)
+val = extract_number(r)
+check('Clamped to 8', val == 8, f'expected 8, got {val}')
+r = send('9999 BLK-BUFFERS #BUFFERS .', 1)
+val = extract_number(r)
+check('Clamped to 512', val == 512, f'expected 512, got {val}')
+
+# Test 4: Dirty data survives a resize
+print("\nTest 4: Resize writes back")
+send('1001 BUFFER 1024 77 FILL UPDATE', 1)
+r = send('64 BLK-BUFFERS 1001 BLOCK 512 + C@ .', 2)
+val = extract_number(r)
+check('Block 1001 written before resize', val == 77,
+      f'expected 77, got {val}')
+
+# Test 5: Eviction from a small pool writes dirty buffers back
+print("\nTest 5: Dirty eviction")
+send('8 BLK-BUFFERS 1002 BUFFER 1024 88 FILL UPDATE', 1)
+send('0 READ-AHEAD ! 30 0 DO 200 I + BLOCK DROP LOOP 2 READ-AHEAD !', 3)
+r = send('1002 BLOCK 1023 + C@ .', 2)
+val = extract_number(r)
+check('Evicted block 1002 read back', val == 88, f'expected 88, got {val}')
+send('256 BLK-BUFFERS', 1)
+
+# Test 5b: Write-through eviction writes back the victim only
+print("\nTest 5b: Victim-only write-back")
+send('CREATE BC-PB 1024 ALLOT', 1)
+send(': BC-DISK ( blk -- c ) BC-PB SWAP PBLK-READ DROP BC-PB C@ ;', 1)
+send('1002 BUFFER 1024 0 FILL UPDATE 1003 BUFFER 1024 0 FILL UPDATE '
+     'BLK-BARRIER DROP', 2)
+# Two dirty buffers in an empty 8-buffer pool; the seventh read evicts 1002
+send('8 BLK-BUFFERS 1002 BUFFER 1024 31 FILL UPDATE '
+     '1003 BUFFER 1024 32 FILL UPDATE', 1)
+r = send('0 READ-AHEAD ! 7 0 DO 200 I + BLOCK DROP LOOP 2 READ-AHEAD ! '
+         '1002 BC-DISK .', 2)
+val = extract_number(r)
+check('Evicted block 1002 written', val == 31, f'expected 31, got {val}')
+r = send('1003 BC-DISK .', 1)
+val = extract_number(r)
+check('Block 1003 still only in the pool', val == 0,
+      f'expected 0, got {val}')
+r = send('256 BLK-BUFFERS 1003 BC-DISK .', 2)
+val = extract_number(r)
+check('Block 1003 written by the resize', val == 32,
+      f'expected 32, got {val}')
+
+# Test 6: Dirty buffers UPDATEd out of order come back intact
+print("\nTest 6: Coalesced flush")
+send(': BC-DIRTY ( blk c -- ) SWAP BUFFER 1024 ROT FILL UPDATE ;', 1)
+send('1013 13 BC-DIRTY 1010 10 BC-DIRTY 1012 12 BC-DIRTY 1011 11 BC-DIRTY', 1)
+r = send('BLK-BARRIER .', 2)
+val = extract_number(r)
+check('BLK-BARRIER ior', val == 0, f'expected 0, got {val}')
+r = send('EMPTY-BUFFERS 1010 BLOCK C@ 1011 BLOCK C@ 1012 BLOCK C@ '
+         '1013 BLOCK 1023 + C@ + + + .', 2)
+val = extract_number(r)
+check('Run of four read back', val == 46, f'expected 46, got {val}')
+
+# Test 7: Write-behind flushes from the idle loop, not at UPDATE
+print("\nTest 7: Write-behind")
+send('1020 BUFFER 1024 0 FILL UPDATE BLK-BARRIER DROP', 2)
+# 100 ticks at the PIT's 18.2 Hz is about 5.5 s; check on the same line
+r = send('100 WRITE-BEHIND ! 1020 21 BC-DIRTY '
+         'BC-PB 1020 PBLK-READ DROP BC-PB C@ .', 1)
+val = extract_number(r)
+check('Not written at UPDATE', val == 0, f'expected 0, got {val}')
+time.sleep(7)
+r = send('BC-PB 1020 PBLK-READ DROP BC-PB C@ .', 1)
+val = extract_number(r)
+check('Written while idle', val == 21, f'expected 21, got {val}')
+send('0 WRITE-BEHIND !', 1)
+
+# Test 7b: An overdue flush also runs from a buffer miss, without the
+# idle loop: spin past the deadline, then miss on block 1500
+print("\nTest 7b: Write-behind from a buffer miss")
+send('1021 BUFFER 1024 0 FILL UPDATE BLK-BARRIER DROP', 2)
+send(': BC-SPIN ( ticks -- ) TICK-COUNT @ + '
+     'BEGIN DUP TICK-COUNT @ - 0< UNTIL DROP ;', 1)
+r = send('4 WRITE-BEHIND ! 1021 22 BC-DIRTY 8 BC-SPIN 1021 BC-DISK . '
+         '1500 BLOCK DROP 1021 BC-DISK .', 3)
+words = r.replace('\r', ' ').replace('\n', ' ').split()
+vals = words[-3:-1] if len(words) >= 3 else []
+check('Overdue, not yet written', vals[:1] == ['0'], f'got {vals}')
+check('Written by the miss', vals[1:] == ['22'], f'got {vals}')
+send('0 WRITE-BEHIND !', 1)
+
+# Test 8: Stack clean
+print("\nTest 8: Stack clean")
+r = send('.S', 1)
+check('Stack clean', '<>' in r, f'stack: {r.strip()!r}')
+
+print(f'\nPassed: {PASS}/{PASS + FAIL}')
+s.close()
+sys.exit(0 if FAIL == 0 else 1)
@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""Test multi-sector block reads, bus-master DMA and read-ahead.
+
+Needs the IDE slave image (test-vocabs topology). The same ten blocks are
+read by DMA, by PIO with read-ahead and by PIO without it; all three must
+give identical data. Also checks a write round-trip and a read-ahead window
+running off the end of the disk.
+"""
+import socket
+import time
+import sys
+
+PORT = int(sys.argv[1]) if len(sys.argv) > 1 else 4517
+
+s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+s.settimeout(10)
+for attempt in range(20):
+    try:
+        s.connect(('127.0.0.1', PORT))
+        break
+    except (ConnectionRefusedError, OSError):
+        time.sleep(0.5)
+else:
+    print("FAIL: connect")
+    sys.exit(1)
+
+time.sleep(2)
+try:
+    while True:
+        s.recv(4096)
+except Exception:
+    pass
+
+
+def send(cmd, wait=1.0):
+    s.sendall((cmd + '\r').encode())
+    time.sleep(wait)
+    s.settimeout(2)
+    resp = b''
+    while True:
+        try:
+            d = s.recv(4096)
+            if not d:
+                break
+            resp += d
+        except Exception:
+            break
+    return resp.decode('ascii', errors='replace')
+
+
+def extract_number(text):
+    words = text.replace('\r', ' ').replace('\n', ' ').split()
+    for i in range(len(words) - 1, -1, -1):
+        if words[i] in ('ok', 'OK'):
+            if i > 0:
+                try:
+                    return int(words[i - 1])
+                except ValueError:
+                    pass
+    return None
+
+
+PASS = FAIL = 0
+
+
+def check(name, ok, detail=''):
+    global PASS, FAIL
+    if ok:
+        PASS += 1
+        print(f'  PASS: {name}')
+    else:
+        FAIL += 1
+        print(f'  FAIL: {name} -- {detail}' if detail else
+              f'  FAIL: {name}')
+
+
+# Test 1: Defaults
+print("\nTest 1: Defaults")
+r = send('READ-AHEAD @ .', 1)
+val = extract_number(r)
+check('READ-AHEAD default', val == 2, f'expected 2, got {val}')
+send('1 BLOCK DROP', 1)
+r = send('ATA-DMA @ 0<> .', 1)
+val = extract_number(r)
+check('Bus-master IDE found', val == -1, f'expected -1, got {val}')
+send('ATA-DMA @ CONSTANT RA-DMA', 1)
+
+# Test 2: Same data over every path
+print("\nTest 2: DMA / PIO / no read-ahead agree")
+send(': RA-CKS ( blk -- u ) BLOCK 0 SWAP DUP 1024 + SWAP DO I C@ + LOOP ;', 1)
+send(': RA-SUMS ( -- u ) 0 11 1 DO I RA-CKS I * + LOOP ;', 1)
+r = send('EMPTY-BUFFERS RA-SUMS .', 2)
+dma = extract_number(r)
+check('DMA checksum', dma is not None and dma > 0, f'got {dma}')
+r = send('0 ATA-DMA ! EMPTY-BUFFERS RA-SUMS .', 2)
+pio = extract_number(r)
+check('PIO + read-ahead matches DMA', pio == dma, f'{pio} vs {dma}')
+r = send('0 READ-AHEAD ! EMPTY-BUFFERS RA-SUMS .', 2)
+single = extract_number(r)
+check('No read-ahead matches', single == dma, f'{single} vs {dma}')
+send('2 READ-AHEAD ! RA-DMA ATA-DMA !', 1)
+
+# Test 3: Sequential BLOCK after a miss hits the read-ahead buffers
+print("\nTest 3: Read-ahead fills the pool")
+send('EMPTY-BUFFERS 20 BLOCK DROP', 1)
+r = send('21 BLOCK 22 BLOCK - ABS 0> .', 1)
+val = extract_number(r)
+check('Distinct buffers for 21/22', val == -1, f'expected -1, got {val}')
+r = send('EMPTY-BUFFERS 20 RA-CKS 21 RA-CKS 22 RA-CKS + + '
+         'EMPTY-BUFFERS 0 READ-AHEAD ! 20 RA-CKS 21 RA-CKS 22 RA-CKS + + '
+         '= . 2 READ-AHEAD !', 2)
+val = extract_number(r)
+check('Read-ahead data correct', val == -1, f'expected -1, got {val}')
+
+# Test 4: Write round-trip (one WRITE SECTORS per block)
+print("\nTest 4: Write round-trip")
+send('1000 BUFFER 1024 66 FILL UPDATE FLUSH', 2)
+r = send('1000 BLOCK 1023 + C@ .', 1)
+val = extract_number(r)
+check('Block 1000 written and read back', val == 66, f'expected 66, got {val}')
+
+# Test 5: Window past the end of the disk falls back to the block alone
+print("\nTest 5: Read-ahead at end of disk")
+r = send('EMPTY-BUFFERS 2047 BLOCK C@ 0 >= .', 3)
+val = extract_number(r)
+check('Last block readable', val == -1, f'expected -1, got {val}')
+
+# Test 6: Stack clean
+print("\nTest 6: Stack clean")
+r = send('.S', 1)
+check('Stack clean', '<>' in r, f'stack: {r.strip()!r}')
+
+print(f'\nPassed: {PASS}/{PASS + FAIL}')
+s.close()
+sys.exit(0 if FAIL == 0 else 1)
@@ -66,7 +66,7 @@ def extract_number(text):
 
 # Set up search order for vocab words
 send('ALSO CATALOG-RESOLVER', 1)
-send('ALSO UI-PARSER', 1)
+send('USING UI-PARSER', 3)     # Block-loaded in the full tier
 send('ALSO UI-CORE', 1)
 
 # Test 1: CATALOG-FIND returns TRUE
@@ -97,6 +97,19 @@ check('Widget count >= 10',
       count is not None and count >= 10,
       f'got {count}')
 
+# Test 3b: second FORM-LOAD comes from the compiled cache
+print("\nTest 3b: FORM-LOAD cache hit")
+r = send('FC-HITS @ T3 FC-HITS @ SWAP - .', 3)
+print(f"  hits: {r.strip()!r}")
+check('Second load is a cache hit',
+      extract_number(r) == 1, f'got {extract_number(r)}')
+r = send('WT-COUNT @ .', 2)
+check('Cached widget count matches parse',
+      extract_number(r) == count, f'got {extract_number(r)}')
+r = send('0 FORM-CACHE ! T3 -1 FORM-CACHE ! WT-COUNT @ .', 3)
+check('Uncached parse gives the same count',
+      extract_number(r) == count, f'got {extract_number(r)}')
+
 # Test 4: Stack clean
 print("\nTest 4: Stack clean")
 r = send('.S', 2)
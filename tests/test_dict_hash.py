@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+"""Test the hashed dictionary lookup in find_.
+
+Checks that the hash index gives the same answers as the link-chain walk:
+newest definition wins, hidden (in-progress) definitions are skipped,
+vocabularies shadow FORTH, REHASH rebuilds an equivalent index, and
+a dictionary rollback after REHASH keeps the newest definition on top.
+"""
+import socket
+import time
+import sys
+
+PORT = int(sys.argv[1]) if len(sys.argv) > 1 else 4484
+
+s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+s.settimeout(10)
+for attempt in range(20):
+    try:
+        s.connect(('127.0.0.1', PORT))
+        break
+    except (ConnectionRefusedError, OSError):
+        time.sleep(0.5)
+else:
+    print("FAIL: connect")
+    sys.exit(1)
+
+time.sleep(2)
+try:
+    while True:
+        s.recv(4096)
+except Exception:
+    pass
+
+
+def send(cmd, wait=1.0):
+    s.sendall((cmd + '\r').encode())
+    time.sleep(wait)
+    s.settimeout(2)
+    resp = b''
+    while True:
+        try:
+            d = s.recv(4096)
+            if not d:
+                break
+            resp += d
+        except Exception:
+            break
+    return resp.decode('ascii', errors='replace')
+
+
+def extract_number(text):
+    words = text.replace('\r', ' ').replace('\n', ' ').split()
+    for i in range(len(words) - 1, -1, -1):
+        if words[i] in ('ok', 'OK'):
+            if i > 0:
+                try:
+                    return int(words[i - 1])
+                except ValueError:
+                    pass
+    return None
+
+
+PASS = FAIL = 0
+
+
+def check(name, ok, detail=''):
+    global PASS, FAIL
+    if ok:
+        PASS += 1
+        print(f'  PASS: {name}')
+    else:
+        FAIL += 1
+        print(f'  FAIL: {name} -- {detail}' if detail else
+              f'  FAIL: {name}')
+
+
+# Test 1: Redefinition shadows the old word
+print("\nTest 1: Redefinition shadows")
+send(': HT-A 11 ;', 1)
+send(': HT-A 22 ;', 1)
+r = send('HT-A .', 1)
+val = extract_number(r)
+print(f"  result: {r.strip()!r} (parsed: {val})")
+check('Newest HT-A wins', val == 22, f'expected 22, got {val}')
+
+# Test 2: A definition can call the word it is replacing
+print("\nTest 2: Hidden definition falls through to the old one")
+send(': HT-B 5 ;', 1)
+send(': HT-B HT-B 1+ ;', 1)
+r = send('HT-B .', 1)
+val = extract_number(r)
+print(f"  result: {r.strip()!r} (parsed: {val})")
+check('HT-B compiles the previous HT-B', val == 6, f'expected 6, got {val}')
+
+# Test 3: Vocabulary shadowing and FORTH fallback
+print("\nTest 3: Vocabulary shadowing")
+send(': HT-C 1 ;', 1)
+send('VOCABULARY HT-VOC', 1)
+send('HT-VOC DEFINITIONS', 1)
+send(': HT-C 2 ;', 1)
+r = send('HT-C .', 1)
+val = extract_number(r)
+check('HT-VOC version found first', val == 2, f'expected 2, got {val}')
+r = send('3 4 + .', 1)
+val = extract_number(r)
+check('FORTH words still reachable', val == 7, f'expected 7, got {val}')
+send('FORTH DEFINITIONS', 1)
+r = send('HT-C .', 1)
+val = extract_number(r)
+check('FORTH version after switching back', val == 1, f'expected 1, got {val}')
+
+# Test 4: Unknown words still report an error
+print("\nTest 4: Undefined word")
+r = send('HT-NO-SUCH-WORD', 1)
+print(f"  result: {r.strip()!r}")
+check('Undefined word rejected', '?' in r, f'got {r.strip()!r}')
+
+# Test 5: REHASH rebuilds an equivalent index
+print("\nTest 5: REHASH")
+send('REHASH', 1)
+r = send('HT-A HT-B + .', 1)
+val = extract_number(r)
+check('Lookups unchanged after REHASH', val == 28, f'expected 28, got {val}')
+send('HT-VOC', 1)
+r = send('HT-C .', 1)
+val = extract_number(r)
+check('Vocabulary rediscovered by REHASH', val == 2, f'expected 2, got {val}')
+send('FORTH', 1)
+r = send('HASH-NODES @ 0> .', 1)
+val = extract_number(r)
+check('Index populated', val == -1, f'expected -1, got {val}')
+
+# Test 6: Rollback after REHASH keeps redefinitions newest-first
+# REHASH fills the node pool newest-first; the purge that follows a
+# rollback must not reverse the buckets. Roll back the way a Ctrl+C
+# break does (HERE, LATEST and the FORTH chain head), then break for real.
+print("\nTest 6: Rollback after REHASH")
+send('VARIABLE HT-H', 1)
+send(': HT-E 1 ;', 1)
+send(': HT-E 2 ;', 1)
+send('REHASH', 1)
+send('HERE @ HT-H !', 1)
+send(': HT-F 3 ;', 1)
+send('HT-H @ @ LATEST !  HT-H @ @ ADDR-FORTH-LATEST !  HT-H @ HERE !', 1)
+r = send('HT-E .', 1)
+val = extract_number(r)
+print(f"  result: {r.strip()!r} (parsed: {val})")
+check('Newest HT-E after rollback', val == 2, f'expected 2, got {val}')
+r = send('HT-F', 1)
+check('Rolled-back HT-F gone', '?' in r, f'got {r.strip()!r}')
+s.sendall(b'\x03')
+time.sleep(1)
+send('', 1)
+r = send('HT-E .', 1)
+val = extract_number(r)
+check('Newest HT-E after Ctrl+C', val == 2, f'expected 2, got {val}')
+
+# Test 7: Stack clean
+print("\nTest 7: Stack clean")
+r = send('.S', 1)
+check('Stack clean', '<>' in r, f'stack: {r.strip()!r}')
+
+print(f'\nPassed: {PASS}/{PASS + FAIL}')
+s.close()
+sys.exit(0 if FAIL == 0 else 1)
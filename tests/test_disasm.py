@@ -220,8 +220,16 @@ check('DIS ST shows S" and hello',
       has_sq and has_hello,
       f'response: {r.strip()[:200]!r}')
 
-# Test 14: Stack clean after all operations
-print("\nTest 14: Stack clean")
+# Test 14: DECOMP prints superinstructions as their originals
+print("\nTest 14: DECOMP with fused sequences")
+r = send(': FZ 2DUP ! SWAP 4 + SWAP DUP 0= ;', 2)
+r = send("' FZ DECOMP", 3)
+check('DECOMP FZ shows original words',
+      '2DUP ! SWAP LIT 4 + SWAP' in r and 'DUP 0=' in r,
+      f'response: {r.strip()[:200]!r}')
+
+# Test 15: Stack clean after all operations
+print("\nTest 15: Stack clean")
 r = send('.S', 1)
 check('Stack clean after all tests',
       '<>' in r,
@@ -184,6 +184,68 @@ for name in vocabs_to_test:
         print(f"  System crashed! Stopping.")
         break
 
+# HARDWARE physical allocator tests
+print("\nHARDWARE allocator tests:")
+r = send('USING HARDWARE HEX', 2)
+
+
+def hexnum(cmd):
+    """Run cmd and return the last hex number printed."""
+    r = send(cmd, 1)
+    for w in reversed(r.split()):
+        try:
+            return int(w, 16)
+        except ValueError:
+            pass
+    return None
+
+
+top = hexnum('MEM-TOP U.')
+check('MEM-TOP above 16MB (QEMU 128MB)',
+      top is not None and top > 0x1000000, f'got: {top}')
+a = hexnum('2000 PHYS-ALLOC DUP U.')
+check('PHYS-ALLOC prefers memory above 16MB',
+      a is not None and a >= 0x1000000 and a % 0x1000 == 0,
+      f'got: {a}')
+b = hexnum('2000 PHYS-ALLOC DUP U.')
+check('second run follows the first',
+      b is not None and a is not None and b == a + 0x2000,
+      f'a={a} b={b}')
+send('SWAP PHYS-FREE', 1)
+c = hexnum('1000 PHYS-ALLOC DUP U.')
+check('PHYS-FREE makes the run reusable', c == a, f'a={a} c={c}')
+send('PHYS-FREE PHYS-FREE', 1)
+d = hexnum('1000 DMA-ALLOC DUP U.')
+check('DMA-ALLOC below 16MB, outside reserved 2MB-210000',
+      d is not None and 0x100000 <= d < 0x1000000
+      and not (0x200000 <= d < 0x210000), f'got: {d}')
+send('PHYS-FREE', 1)
+d = hexnum('300000 DMA-ALLOC DUP U.')
+check('large DMA-ALLOC skips the block pool',
+      d is not None and d >= 0x393000,
+      f'got: {d}')
+send('PHYS-FREE', 1)
+r = send('300000 PHYS-FREE', 1)
+check('PHYS-FREE refuses a reserved run', 'not allocated' in r,
+      f'got: {r.strip()!r}')
+send('40 SLAB-CACHE TC', 1)
+e = hexnum('TC SLAB-GET DUP U.')
+f = hexnum('TC SLAB-GET DUP U.')
+check('SLAB-GET hands out distinct objects',
+      e is not None and f is not None and abs(e - f) == 0x40,
+      f'e={e} f={f}')
+send('TC SLAB-PUT', 1)
+g = hexnum('TC SLAB-GET DUP U.')
+check('SLAB-PUT object is reused first', g == f, f'f={f} g={g}')
+send('TC SLAB-PUT TC SLAB-PUT TC SLAB-EMPTY', 1)
+r = send('DECIMAL TC SLAB-STATS', 1)
+check('SLAB-EMPTY resets the cache', 'of 0' in r,
+      f'got: {r.strip()!r}')
+r = send('PHYS-STATS', 2)
+check('PHYS-STATS reports usage', 'In use' in r and 'failed 0' in r,
+      f'got: {r.strip()[:120]!r}')
+send('DECIMAL FORTH', 1)
+
 # PS2-MOUSE specific tests
 print("\nPS2-MOUSE word tests:")
 r = send('USING PS2-MOUSE', 2)
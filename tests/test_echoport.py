@@ -128,6 +128,15 @@ r = send('ECHOPORT-COUNT .', 1)
 check('ECHOPORT-CLEAR resets count to 0',
       '0' in r, f'got: {r.strip()!r}')
 
+# Test a string transfer logs one batched entry
+r = send('ECHOPORT-ON HEX 80 HERE @ 4 INSB ECHOPORT-OFF', 2)
+r = send('ECHOPORT-COUNT .', 1)
+check('INSB logs a single entry',
+      '1' in r.split(), f'got: {r.strip()!r}')
+r = send('ECHOPORT-DUMP', 3)
+check('ECHOPORT-DUMP shows INSB with its count',
+      'INSB' in r and 'cnt=0004' in r, f'got: {r.strip()[:100]!r}')
+
 # Test ECHOPORT-WATCH
 r = send(
     "USING PORT-MAPPER",
@@ -140,6 +149,27 @@ check('ECHOPORT-WATCH traces PIC-STATUS',
       or 'ECHOPORT' in r,
       f'got: {r.strip()[:120]!r}')
 
+# Test the ring moved to the physical pool
+r = send('DECIMAL TRACE-BUF-SIZE 256 > . HEX', 1)
+check('ECHOPORT-ON enlarges the ring',
+      '-1' in r, f'got: {r.strip()!r}')
+
+# Test a port filter
+r = send('ECHOPORT-OFF 60 ECHOPORT-PORT ECHOPORT-ON '
+         '20 INB DROP 60 INB DROP ECHOPORT-OFF ECHOPORT-ALL', 2)
+r = send('ECHOPORT-COUNT .', 1)
+check('ECHOPORT-PORT logs only that port',
+      '1' in r.split(), f'got: {r.strip()!r}')
+
+# Test a trace longer than the ring: drained, nothing lost
+r = send(': EP-LONG 5000 0 DO 80 INB DROP LOOP ;', 1)
+r = send('ECHOPORT-ON EP-LONG ECHOPORT-OFF TRACE-LOST @ 0= .', 5)
+check('Long trace loses nothing',
+      '-1' in r, f'got: {r.strip()!r}')
+r = send('ECHOPORT-SUMMARY', 3)
+check('ECHOPORT-SUMMARY counts every access',
+      '20480 IN' in r, f'got: {r.strip()[:160]!r}')
+
 # Final checks
 print("\nFinal check:")
 r = send('DECIMAL', 1)
@@ -2,7 +2,8 @@
 """Test FE-STRIP-ALL-CR: unconditional CR stripping in FILE-EDITOR.
 
 Loads embedded vocabs, writes known byte patterns into FE-BUF,
-calls FE-STRIP-ALL-CR, verifies all 0x0D bytes removed.
+calls FE-STRIP-ALL-CR, verifies all 0x0D bytes removed. Then edits
+the result through the gap buffer and checks the line index.
 """
 import socket
 import time
@@ -195,6 +196,35 @@ for i in range(20):
         break
 check('No CR bytes remain in buffer', not cr_found)
 
+# ---- Test 8: Gap buffer edits and line index ----
+# Buffer from Test 7: "Line one.\nLine two.\n", 3 lines
+print("\nTest 8: Gap buffer edits and line index")
+
+
+def num(cmd):
+    """Run cmd in DECIMAL and return the last number printed."""
+    r = send(f'DECIMAL {cmd} . HEX', 1)
+    toks = [t for t in r.replace('\r', ' ').replace('\n', ' ').split()
+            if t.lstrip('-').isdigit()]
+    return int(toks[-1]) if toks else None
+
+
+check('TOTAL-LINES = 3', num('TOTAL-LINES') == 3)
+check('LINE-START 1 = 10', num('1 LINE-START') == 10)
+send('DECIMAL 88 5 BUF-INS HEX', 0.5)
+check('insert X: line 1 starts at 11', num('1 LINE-START') == 11)
+send('DECIMAL 10 2 BUF-INS HEX', 0.5)
+check('insert LF: 4 lines', num('TOTAL-LINES') == 4)
+check('insert LF: line 1 at 3, line 2 at 12',
+      num('1 LINE-START') == 3 and num('2 LINE-START') == 12)
+check('line 1 length 8', num('1 FE-LINE-LEN') == 8)
+send('DECIMAL 2 BUF-DEL HEX', 0.5)
+check('delete LF: 3 lines', num('TOTAL-LINES') == 3)
+check('FE-SIZE = 21', get_size() == 21)
+send('FE-FLAT', 0.5)
+check('flat: byte 5 = X, byte 11 = L',
+      get_byte(5) == 88 and get_byte(11) == 76)
+
 # ---- Final ----
 print("\nFinal check:")
 ok = alive()
@@ -90,12 +90,12 @@ def parse_traces(output):
         elif line == ']':
             traces.append({'type': ']'})
         elif line.startswith('F') and ' ' in line[1:]:
-            # F<slot> <block_hex> <flags_hex>
-            m = re.match(r'F(\d)\s+([0-9A-Fa-f]+)\s+([0-9A-Fa-f]+)', line)
+            # F<slot_hex> <block_hex> <flags_hex>
+            m = re.match(r'F([0-9A-Fa-f]+)\s+([0-9A-Fa-f]+)\s+([0-9A-Fa-f]+)', line)
             if m:
                 traces.append({
                     'type': 'F',
-                    'slot': int(m.group(1)),
+                    'slot': int(m.group(1), 16),
                     'block': int(m.group(2), 16),
                     'flags': int(m.group(3), 16),
                 })
@@ -271,10 +271,10 @@ send('900 BUFFER DROP')       # slot 0: valid, NOT dirty
 send('901 BUFFER DROP UPDATE')  # slot 1: valid + dirty
 
 # Read header flags via memory access
-# Slot 0 header at 0x28060: [block#(4)][flags(4)][age(4)]
-# Slot 1 header at 0x2806C: [block#(4)][flags(4)][age(4)]
-r_flags0 = send('HEX 28064 @ .')  # slot 0 flags
-r_flags1 = send('28070 @ .')      # already in HEX
+# Slot 0 header at 0x302000: [block#(4)][flags(4)][hash/LRU links, data]
+# Slot 1 header at 0x302020 (32-byte headers)
+r_flags0 = send('HEX 302004 @ .')  # slot 0 flags
+r_flags1 = send('302024 @ .')      # already in HEX
 send('DECIMAL')  # restore base
 
 v_flags0 = extract_hex(r_flags0)
@@ -304,16 +304,16 @@ a1 = extract_number(r_a1)
 a2 = extract_number(r_a2)
 a3 = extract_number(r_a3)
 
-# Expected: 0x28200, 0x28600, 0x28A00, 0x28E00
+# Expected: 0x306000 + slot * 1040 (1 KB + NUL guard gap)
 a0 = extract_hex(r_a0)
 a1 = extract_hex(r_a1)
 a2 = extract_hex(r_a2)
 a3 = extract_hex(r_a3)
 
-check_val('buffer 900 addr', a0, 0x28200)
-check_val('buffer 901 addr', a1, 0x28600)
-check_val('buffer 902 addr', a2, 0x28A00)
-check_val('buffer 903 addr', a3, 0x28E00)
+check_val('buffer 900 addr', a0, 0x306000)
+check_val('buffer 901 addr', a1, 0x306410)
+check_val('buffer 902 addr', a2, 0x306820)
+check_val('buffer 903 addr', a3, 0x306C30)
 
 # ============================================================================
 print()
@@ -368,7 +368,7 @@ else:
 # H2: Register corruption (wrong block# or address)?
 for t_f, t_w in zip(bulk_F, bulk_W):
     expected_lba = t_f['block'] * 2
-    expected_esi = 0x28200 + t_f['slot'] * 1024
+    expected_esi = 0x306000 + t_f['slot'] * 1040
     if t_w['lba'] != expected_lba:
         print(f'  >>> H2 CONFIRMED: slot {t_f["slot"]} LBA mismatch: '
               f'expected {expected_lba}, got {t_w["lba"]}')
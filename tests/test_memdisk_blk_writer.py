@@ -7,7 +7,10 @@ the kernel installs (BLK-WRITE-NONE) as the default block writer.
 
 Scenario B (loud refusal):
   1. BLK-WRITER@ equals ' (BLK-WRITE-NONE) at boot.
-  2. Block reads work (RAM-backed memdisk path).
+  2. Block reads work (RAM-backed memdisk path). BLOCK-VIEW maps
+     in place (MEMDISK-MAP) with the same bytes as a copy; BLOCK
+     copies, so a store without UPDATE is discarded by
+     EMPTY-BUFFERS and never reaches the image.
   3. SAVE-BUFFERS of a dirty buffer prints BLOCK WRITE FAIL,
      leaves the system alive, stacks balanced.
 
@@ -177,6 +180,24 @@ def main():
         r = cmd(s, '1 BLOCK C@ . ', 2)
         chk('RAM-backed BLOCK read works', r, 'ok',
             unwanted='?')
+        # Zero-copy mapping: BLOCK-VIEW points into the image,
+        # outside the buffer pool, and matches a copy
+        cmd(s, 'EMPTY-BUFFERS')
+        r = cmd(s, '1 BLOCK-VIEW DUP BLK-POOL-DATA < SWAP BLK-POOL-END < 0= OR .')
+        chk('memdisk BLOCK-VIEW mapped in place', r, '-1 ')
+        r = cmd(s, '1 BLOCK-VIEW 100 + C@ 1 BLOCK 100 + C@ = .')
+        chk('mapped block equals copied block', r, '-1 ')
+        r = cmd(s, '1 BLOCK DUP BLK-POOL-DATA 1- > SWAP BLK-POOL-END < AND .')
+        chk('memdisk BLOCK copied into the pool', r, '-1 ')
+        # A store through BLOCK without UPDATE stays in the pool:
+        # EMPTY-BUFFERS drops it and the image keeps the old byte
+        cmd(s, 'EMPTY-BUFFERS VARIABLE OLDB 1 BLOCK-VIEW 100 + C@ OLDB !')
+        cmd(s, 'OLDB @ 1+ 1 BLOCK 100 + C!')
+        r = cmd(s, '1 BLOCK-VIEW 100 + C@ OLDB @ 1+ 255 AND = .')
+        chk('BLOCK-VIEW sees the cached store', r, '-1 ')
+        cmd(s, 'EMPTY-BUFFERS')
+        r = cmd(s, '1 BLOCK-VIEW 100 + C@ OLDB @ = .')
+        chk('EMPTY-BUFFERS discards a store without UPDATE', r, '-1 ')
         # Loud read refusal: the stub must NEVER fall back to
         # the RAM copy — that silent fallback is the stale-
         # settings bug the read vector exists to kill.
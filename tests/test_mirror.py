@@ -145,6 +145,17 @@ if ok1:
           has_flag,
           f'response: {r.strip()!r}')
 
+# Test 4b: MIRROR-DELTA writes only what changed
+print("\nTest 4b: MIRROR-DELTA")
+send('DECIMAL : MIR-T1 123 ;', 1)
+r = send('DECIMAL 900 MIRROR-DELTA', 4)
+check('MIRROR-DELTA appends delta 1',
+      'delta 1 ' in r, f'response: {r.strip()[:120]!r}')
+blocks = r.split('(')[-1].split()[0] if '(' in r else ''
+check('MIRROR-DELTA writes a few blocks',
+      blocks.isdigit() and int(blocks) <= 4,
+      f'response: {r.strip()[:120]!r}')
+
 # Test 5: MIRROR-INFO runs without crash
 print("\nTest 5: MIRROR-INFO")
 r = send('DECIMAL 900 MIRROR-INFO', 3)
@@ -155,6 +166,9 @@ if ok:
     check('MIRROR-INFO shows HERE',
           'HERE' in r,
           f'response: {r.strip()[:120]!r}')
+    check('MIRROR-INFO counts the delta',
+          'Deltas:' in r and '1' in r.split('Deltas:')[-1][:12],
+          f'response: {r.strip()[-120:]!r}')
 
 # Test 6: Stack is clean
 print("\nTest 6: Stack clean")
@@ -0,0 +1,263 @@
+#!/usr/bin/env python3
+"""Test NATIVE compiler mode.
+
+Loads X86-ASM, DISASM and NATIVE from blocks, compiles
+colon words both threaded and native, verifies the results
+match and that DIS decodes the emitted code.
+
+Usage:
+    python3 tests/test_native.py [PORT]
+"""
+import socket
+import time
+import sys
+import subprocess
+import os
+
+PORT = int(sys.argv[1]) if len(sys.argv) > 1 else 4478
+
+PROJECT_DIR = os.path.dirname(os.path.dirname(
+    os.path.abspath(__file__)))
+
+
+def get_vocab_blocks(vocab_name):
+    """Get vocab start and end block from catalog."""
+    try:
+        result = subprocess.run(
+            [sys.executable, '-c', f"""
+import sys, os
+sys.path.insert(0, os.path.join('{PROJECT_DIR}', 'tools'))
+from importlib.machinery import SourceFileLoader
+wc = SourceFileLoader('wc', os.path.join(
+    '{PROJECT_DIR}', 'tools', 'write-catalog.py'
+)).load_module()
+vocabs = wc.scan_vocabs(os.path.join(
+    '{PROJECT_DIR}', 'forth', 'dict'))
+_nc = (len(vocabs) + wc.CATALOG_DATA_LINES - 1) // wc.CATALOG_DATA_LINES
+nb = 1 + _nc
+for v in vocabs:
+    nb = wc.place_vocab(nb, v['blocks_needed'])
+    if v['name'] == '{vocab_name}':
+        print(f"{{nb}} {{nb + v['blocks_needed'] - 1}}")
+        break
+    nb += v['blocks_needed']
+"""],
+            capture_output=True, text=True, timeout=10
+        )
+        if result.stdout.strip():
+            parts = result.stdout.strip().split()
+            return int(parts[0]), int(parts[1])
+    except Exception:
+        pass
+    return None, None
+
+
+RANGES = {}
+for name in ('X86-ASM', 'DISASM', 'NATIVE'):
+    start, end = get_vocab_blocks(name)
+    if start is None:
+        print(f"FAIL: Could not determine {name} block range")
+        sys.exit(1)
+    RANGES[name] = (start, end)
+    print(f"{name} blocks: {start}-{end}")
+
+s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+s.settimeout(10)
+
+for attempt in range(20):
+    try:
+        s.connect(('127.0.0.1', PORT))
+        break
+    except (ConnectionRefusedError, OSError):
+        time.sleep(0.5)
+else:
+    print("FAIL: Could not connect to QEMU on port", PORT)
+    sys.exit(1)
+
+time.sleep(2)
+try:
+    while True:
+        s.recv(4096)
+except:
+    pass
+
+
+def send(cmd, wait=1.0):
+    """Send a Forth command and collect the response."""
+    s.sendall((cmd + '\r').encode())
+    time.sleep(wait)
+    s.settimeout(2)
+    resp = b''
+    while True:
+        try:
+            d = s.recv(4096)
+            if not d:
+                break
+            resp += d
+        except:
+            break
+    return resp.decode('ascii', errors='replace')
+
+
+def extract_number(text):
+    """Extract a decimal number from Forth output."""
+    words = text.replace('\r', ' ').replace('\n', ' ').split()
+    for i in range(len(words) - 1, -1, -1):
+        if words[i] in ('ok', 'OK'):
+            if i > 0:
+                try:
+                    return int(words[i - 1])
+                except ValueError:
+                    pass
+    for word in words:
+        word = word.strip()
+        if word in ('ok', 'OK', ''):
+            continue
+        try:
+            return int(word)
+        except ValueError:
+            continue
+    return None
+
+
+PASS = 0
+FAIL = 0
+
+
+def check(name, ok, detail=''):
+    global PASS, FAIL
+    if ok:
+        PASS += 1
+        print(f'  PASS: {name}')
+    else:
+        FAIL += 1
+        msg = f'  FAIL: {name}'
+        if detail:
+            msg += f' -- {detail}'
+        print(msg)
+
+
+# ---- Load vocabularies ----
+for name in ('X86-ASM', 'DISASM', 'NATIVE'):
+    start, end = RANGES[name]
+    print(f"\nLoading {name} ({start} {end} THRU)...")
+    r = send(f'{start} {end} THRU', 12)
+    print(f"  THRU response: {r.strip()[-80:]!r}")
+
+# ---- Test 1: NATIVE vocab accessible ----
+print("\nTest 1: NATIVE vocabulary accessible")
+r = send('USING DISASM USING NATIVE DECIMAL', 2)
+check('USING NATIVE succeeds',
+      'ok' in r.lower() and '?' not in r,
+      f'response: {r.strip()!r}')
+
+# Each case: (name, definition body, invocation)
+# Defined twice: T<name> threaded, N<name> native.
+CASES = [
+    ('ARITH', '( a b -- n ) 2DUP + -ROT - * 1+ 1- ;', '7 3'),
+    ('MEM', 'HERE @ 100 + DUP >R ! R@ @ 5 + R> DROP ;', '42'),
+    ('BYTE', 'HERE @ 200 + DUP >R C! R> C@ ;', '300'),
+    ('IFE', 'DUP 0< IF NEGATE ELSE 1+ THEN ;', '-9'),
+    ('UNTIL', '0 SWAP BEGIN SWAP OVER + SWAP 1- DUP 0= UNTIL DROP ;',
+     '10'),
+    ('LOOP', '0 SWAP 0 DO I + LOOP ;', '10'),
+    ('PLOOP', '0 100 0 DO I + 7 +LOOP ;', ''),
+    ('NLOOP', '0 0 10 DO I + -1 +LOOP ;', ''),
+    ('NEST', '0 3 0 DO 4 0 DO I J * + LOOP LOOP ;', ''),
+    ('STR', 'S" native" NIP + ;', '12'),
+    ('LOGIC', 'OVER XOR SWAP 15 AND OR ;', '12 6'),
+    ('EXIT', 'DUP 5 > IF DROP 99 EXIT THEN 2 * ;', '3'),
+    ('EXIT2', 'DUP 5 > IF DROP 99 EXIT THEN 2 * ;', '8'),
+]
+
+# ---- Test 2: native results match threaded ----
+print("\nTest 2: native results match threaded")
+for name, body, args in CASES:
+    send(f': T{name} {body}', 1)
+    send(f': N{name} {body} >NATIVE', 1)
+    rt = send(f'{args} T{name} .', 1)
+    rn = send(f'{args} N{name} .', 1)
+    vt = extract_number(rt)
+    vn = extract_number(rn)
+    print(f"  {name}: threaded={vt} native={vn}")
+    check(f'{name} native == threaded',
+          vt is not None and vt == vn,
+          f'threaded {rt.strip()!r}, native {rn.strip()!r}')
+
+# ---- Test 3: CFA no longer DOCOL ----
+print("\nTest 3: native word is a code word")
+r = send("' NARITH COLON? .", 1)
+val = extract_number(r)
+check('NARITH is not a colon word', val == 0, f'got {val}')
+r = send("' TARITH COLON? .", 1)
+val = extract_number(r)
+check('TARITH is still a colon word', val == -1, f'got {val}')
+
+# ---- Test 4: calls into colon words and RECURSE ----
+print("\nTest 4: calls and recursion")
+send(': SQ DUP * ;', 1)
+send(': NSUMSQ SQ SWAP SQ + ; >NATIVE', 1)
+r = send('3 4 NSUMSQ .', 1)
+val = extract_number(r)
+check('native word calls colon word', val == 25, f'got {val}')
+send(': NFACT DUP 1 > IF DUP 1- RECURSE * THEN ; >NATIVE', 1)
+r = send('6 NFACT .', 1)
+val = extract_number(r)
+check('native RECURSE', val == 720, f'got {val}')
+send(': CALLER 5 NSUMSQ 1+ ;', 1)
+r = send('2 CALLER .', 1)
+val = extract_number(r)
+check('threaded word calls native word', val == 30, f'got {val}')
+
+# ---- Test 5: string output through trampolines ----
+print("\nTest 5: S\" TYPE")
+send(': NHELLO S" zq-native" TYPE ; >NATIVE', 1)
+r = send('NHELLO', 1)
+check('native S" TYPE prints', 'zq-native' in r, f'got {r!r}')
+
+# ---- Test 6: DIS decodes native code ----
+print("\nTest 6: DIS on native word")
+r = send('DIS NSUMSQ', 3)
+print(f"  DIS NSUMSQ => {r.strip()!r}")
+check('DIS shows CALL SQ', 'CALL SQ' in r, f'got {r!r}')
+check('DIS reaches NEXT', 'NEXT' in r, f'got {r!r}')
+r = send('DIS NARITH', 3)
+check('DIS shows inlined ADD', 'ADD' in r, f'got {r!r}')
+
+# ---- Test 7: vocabulary-wide mode ----
+print("\nTest 7: NATIVE-ON")
+send('NATIVE-ON', 1)
+send(': VA 3 + ;', 1)
+send(': VB VA VA 2 * ;', 1)
+send('NATIVE-OFF', 1)
+send(': VC VB 1+ ;', 1)
+r = send("' VA COLON? ' VB COLON? + .", 1)
+val = extract_number(r)
+check('NATIVE-ON compiles natively', val == 0, f'got {val}')
+r = send("' VC COLON? .", 1)
+val = extract_number(r)
+check('NATIVE-OFF compiles threaded', val == -1, f'got {val}')
+r = send('1 VC .', 1)
+val = extract_number(r)
+check('mixed native/threaded chain', val == 15, f'got {val}')
+
+# ---- Test 8: refuses non-colon words ----
+print("\nTest 8: >NATIVE on a variable")
+send('VARIABLE NV', 1)
+r = send('>NATIVE', 1)
+check('>NATIVE rejects non-colon word',
+      'not a colon word' in r, f'got {r!r}')
+
+# ---- Test 9: Stack is clean ----
+print("\nTest 9: Stack is clean")
+r = send('.S', 1)
+print(f"  .S => {r.strip()!r}")
+check('Stack is clean after all tests',
+      '<>' in r,
+      f'stack: {r.strip()!r}')
+
+# ---- Summary ----
+print()
+print(f'Passed: {PASS}/{PASS + FAIL}')
+s.close()
+sys.exit(0 if FAIL == 0 else 1)
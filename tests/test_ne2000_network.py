@@ -4,9 +4,11 @@ QEMU instances connected via socket backend.
 
 Phases tested:
 1. Raw frame send/receive
-2. Single block transfer
-3. Vocabulary transfer (PIT-TIMER)
+2. Single block transfer (polled, then through the IRQ receive ring)
+3. Windowed NET-PUSH / NET-PULL throughput, clean and lossy
+4. Vocabulary transfer (PIT-TIMER)
 """
+import re
 import socket
 import time
 import sys
@@ -236,13 +238,15 @@ if not alive(sa) or not alive(sb):
 
 # Find vocab blocks
 pci_s, pci_e = get_vocab_blocks('PCI-ENUM')
+pr_s, pr_e = get_vocab_blocks('PKT-RING')
 ne_s, ne_e = get_vocab_blocks('NE2000')
 nd_s, nd_e = get_vocab_blocks('NET-DICT')
 # pit_s, pit_e already retrieved above (for zeroing)
 
-if None in (pci_s, ne_s, nd_s, pit_s):
+if None in (pci_s, pr_s, ne_s, nd_s, pit_s):
     print("FAIL: Could not find required vocab blocks")
     print(f"  PCI-ENUM: {pci_s}-{pci_e}")
+    print(f"  PKT-RING: {pr_s}-{pr_e}")
     print(f"  NE2000: {ne_s}-{ne_e}")
     print(f"  NET-DICT: {nd_s}-{nd_e}")
     print(f"  PIT-TIMER: {pit_s}-{pit_e}")
@@ -251,6 +255,7 @@ if None in (pci_s, ne_s, nd_s, pit_s):
 
 print(f"\nVocab blocks:")
 print(f"  PCI-ENUM: {pci_s}-{pci_e}")
+print(f"  PKT-RING: {pr_s}-{pr_e}")
 print(f"  NE2000: {ne_s}-{ne_e}")
 print(f"  NET-DICT: {nd_s}-{nd_e}")
 print(f"  PIT-TIMER: {pit_s}-{pit_e}")
@@ -266,6 +271,14 @@ for label, sock in [('A', sa), ('B', sb)]:
         cleanup()
         sys.exit(1)
 
+    r = send(sock, f'{pr_s} {pr_e} THRU', 10)
+    ok = alive(sock)
+    check(f'Instance {label}: PKT-RING loads', ok,
+          f'{r.strip()[:80]!r}')
+    if not ok:
+        cleanup()
+        sys.exit(1)
+
     r = send(sock, f'{ne_s} {ne_e} THRU', 10)
     ok = alive(sock)
     check(f'Instance {label}: NE2000 loads', ok,
@@ -411,6 +424,111 @@ check('A alive after consecutive transfers',
 check('B alive after consecutive transfers',
       alive(sb) if consec_ok else False)
 
+# ---- IRQ-driven receive ring ----
+# B hooks the NIC IRQ; frames must pile up in
+# PKT-RING with nobody polling, then drain in order.
+print("\nTest: IRQ receive ring")
+r = send(sb, 'NE2K-RX-ON NE-RX-IRQ @ .', 3)
+check('B: NE2K-RX-ON hooks the IRQ', '-1' in r,
+      f'{r.strip()[:80]!r}')
+ring_blks = [(905, 17), (906, 34), (907, 51), (908, 68)]
+for blk_num, fill_byte in ring_blks:
+    send(sa,
+         f'DECIMAL {blk_num} BUFFER '
+         f'DUP 1024 {fill_byte} FILL '
+         f'DROP UPDATE HEX', 2)
+send(sa, 'SAVE-BUFFERS', 3)
+send(sa, 'DECIMAL 905 908 BLOCKS-SEND HEX', 4)
+time.sleep(2)
+r = send(sb, 'ALSO PKT-RING DECIMAL '
+             'PKT-HEAD @ PKT-TAIL @ - . HEX PREVIOUS', 2)
+check('B: ISR queued 4 frames unprompted',
+      ' 4 ' in f' {r} ', f'{r.strip()[:80]!r}')
+r = send(sb, 'DECIMAL BLOCK-RECV . BLOCK-RECV . '
+             'BLOCK-RECV . BLOCK-RECV . HEX', 3)
+check('B: ring drains in order',
+      '905 906 907 908' in r, f'{r.strip()[:80]!r}')
+for blk_num, fill_byte in ring_blks:
+    r = send(sb,
+             f'DECIMAL {blk_num} BLOCK 1023 + C@ . HEX', 2)
+    check(f'B: ring block {blk_num} byte = {fill_byte}',
+          str(fill_byte) in r, f'{r.strip()[:60]!r}')
+r = send(sb, 'BLOCK-RECV DECIMAL . HEX', 2)
+check('B: empty ring returns -1', '-1' in r,
+      f'{r.strip()[:60]!r}')
+send(sb, 'NE2K-RX-OFF SAVE-BUFFERS EMPTY-BUFFERS', 3)
+check('B: alive after IRQ receive', alive(sb))
+
+# ---- Windowed transfer: throughput benchmark ----
+# NET-PUSH 48 blocks A->B with up to NET-WIN frames in flight,
+# then again with B dropping every 7th frame so selective acks
+# and retransmit have to recover the holes.
+print("\nTest: Windowed NET-PUSH / NET-PULL")
+bench_first, bench_n = 910, 48
+bench_last = bench_first + bench_n - 1
+send(sa, ': NDFILL 0 DO DUP I + BUFFER 1024 I 1+ FILL '
+         'UPDATE LOOP DROP ;', 1)
+send(sa, f'DECIMAL {bench_first} {bench_n} NDFILL SAVE-BUFFERS HEX', 6)
+check('A: wrote benchmark blocks', alive(sa))
+
+
+def push_pull(first, last, pull_prefix=''):
+    """Start NET-PULL on B, NET-PUSH on A; return (ticks, a_ior,
+    b_count, b_ior, resent)."""
+    sb.sendall((f'DECIMAL {pull_prefix}NET-PULL . . '
+                f'." PULLED" HEX\r').encode())
+    time.sleep(1)
+    ra = send(sa, f'DECIMAL TICK-COUNT @ {first} {last} NET-PUSH '
+                  f'SWAP TICK-COUNT @ SWAP - . . WS-RESENT @ . '
+                  f'." PUSHED" HEX', 1)
+    if 'PUSHED' not in ra:
+        ra += wait_for(sa, 'PUSHED', 60)
+    rb = wait_for(sb, 'PULLED', 60)
+    ma = re.search(r'(-?\d+)\s+(-?\d+)\s+(-?\d+)\s+PUSHED', ra)
+    mb = re.search(r'(-?\d+)\s+(-?\d+)\s+PULLED', rb)
+    if not ma or not mb:
+        print(f"  A: {ra.strip()[-120:]!r}")
+        print(f"  B: {rb.strip()[-120:]!r}")
+        return None
+    ticks, a_ior, resent = (int(x) for x in ma.groups())
+    b_ior, b_count = (int(x) for x in mb.groups())
+    return ticks, a_ior, b_count, b_ior, resent
+
+
+res = push_pull(bench_first, bench_last)
+check('NET-PUSH/NET-PULL completes', res is not None)
+if res:
+    ticks, a_ior, b_count, b_ior, resent = res
+    secs = max(ticks, 1) / 18.2
+    print(f"  {bench_n} blocks in {ticks} ticks (~{secs:.2f}s): "
+          f"{bench_n / secs:.1f} KB/s, {resent} resent")
+    check('A: NET-PUSH ior = 0', a_ior == 0, f'ior {a_ior}')
+    check('B: NET-PULL ior = 0', b_ior == 0, f'ior {b_ior}')
+    check(f'B: pulled {bench_n} blocks', b_count == bench_n,
+          f'count {b_count}')
+r = send(sb, f'DECIMAL {bench_first} BLOCK C@ . '
+             f'{bench_last} BLOCK 1023 + C@ . HEX', 3)
+check('B: first/last benchmark block content',
+      f'1 {bench_n}' in r, f'{r.strip()[-60:]!r}')
+
+# Lossy run through B's IRQ receive ring
+send(sb, 'NE2K-RX-ON', 2)
+lossy_last = bench_first + 23
+res = push_pull(bench_first, lossy_last, '7 NET-LOSS ! ')
+send(sb, '0 NET-LOSS ! NE2K-RX-OFF', 2)
+check('lossy NET-PUSH completes', res is not None)
+if res:
+    ticks, a_ior, b_count, b_ior, resent = res
+    print(f"  24 blocks, every 7th frame dropped: {ticks} ticks, "
+          f"{resent} resent")
+    check('lossy: both sides ior = 0', a_ior == 0 and b_ior == 0,
+          f'A {a_ior} B {b_ior}')
+    check('lossy: holes were resent', resent > 0, f'resent {resent}')
+r = send(sb, f'DECIMAL {lossy_last} BLOCK C@ . HEX', 3)
+check('lossy: block content intact', ' 24 ' in f' {r} ',
+      f'{r.strip()[-60:]!r}')
+send(sb, 'SAVE-BUFFERS EMPTY-BUFFERS', 3)
+
 # ---- Multi-block vocabulary transfer ----
 # Send PIT-TIMER (5 blocks) from A->B over network,
 # compile on B, verify words work.
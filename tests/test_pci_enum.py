@@ -198,8 +198,24 @@ check('PCI-READ returns non-FFFF',
       'ok' in r.lower() and 'FFFFFFFF' not in r,
       f'response: {r.strip()!r}')
 
-# ---- Test 7: Stack is clean ----
-print("\nTest 7: Stack is clean")
+# ---- Test 7: Decoded BARs and MSI capability ----
+print("\nTest 7: BAR decoding (Bochs VGA 1234:1111)")
+r = send('HEX 1234 1111 PCI-FIND DROP 0 PCI-BAR-SIZE .', 1)
+print(f"  BAR0 size => {r.strip()!r}")
+check('VGA BAR0 decodes as 16MB',
+      '1000000' in r, f'response: {r.strip()!r}')
+r = send('DECIMAL 4660 4369 PCI-FIND DROP 0 PCI-BAR-IO? .', 1)
+check('VGA BAR0 is memory', extract_number(r) == 0,
+      f'response: {r.strip()!r}')
+r = send('HEX 8086 1237 PCI-FIND DROP 41 0 PCI-MSI-ON DECIMAL .', 1)
+check('PCI-MSI-ON refuses a function without MSI',
+      extract_number(r) == 0, f'response: {r.strip()!r}')
+r = send('HEX 1234 1111 PCI-DEV-FIND 0<> DECIMAL .', 1)
+check('PCI-DEV-FIND hash lookup', extract_number(r) == -1,
+      f'response: {r.strip()!r}')
+
+# ---- Test 8: Stack is clean ----
+print("\nTest 8: Stack is clean")
 r = send('.S', 1)
 print(f"  .S => {r.strip()!r}")
 check('Stack is clean after all tests',
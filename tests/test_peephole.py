@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""Test the compile-time peephole pass (superinstructions).
+
+Checks that common sequences compile to one fused primitive, that the
+fused words compute the same results, that fusing never crosses a
+control-flow mark, and that PEEPHOLE turns the pass off.
+"""
+import socket
+import time
+import sys
+
+PORT = int(sys.argv[1]) if len(sys.argv) > 1 else 4486
+
+s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+s.settimeout(10)
+for attempt in range(20):
+    try:
+        s.connect(('127.0.0.1', PORT))
+        break
+    except (ConnectionRefusedError, OSError):
+        time.sleep(0.5)
+else:
+    print("FAIL: connect")
+    sys.exit(1)
+
+time.sleep(2)
+try:
+    while True:
+        s.recv(4096)
+except Exception:
+    pass
+
+
+def send(cmd, wait=1.0):
+    s.sendall((cmd + '\r').encode())
+    time.sleep(wait)
+    s.settimeout(2)
+    resp = b''
+    while True:
+        try:
+            d = s.recv(4096)
+            if not d:
+                break
+            resp += d
+        except Exception:
+            break
+    return resp.decode('ascii', errors='replace')
+
+
+def extract_number(text):
+    words = text.replace('\r', ' ').replace('\n', ' ').split()
+    for i in range(len(words) - 1, -1, -1):
+        if words[i] in ('ok', 'OK'):
+            if i > 0:
+                try:
+                    return int(words[i - 1])
+                except ValueError:
+                    pass
+    return None
+
+
+PASS = FAIL = 0
+
+
+def check(name, ok, detail=''):
+    global PASS, FAIL
+    if ok:
+        PASS += 1
+        print(f'  PASS: {name}')
+    else:
+        FAIL += 1
+        print(f'  FAIL: {name} -- {detail}' if detail else
+              f'  FAIL: {name}')
+
+
+def first_cell_is(word, xt_word):
+    """Check the first thread cell of WORD is XT_WORD."""
+    r = send(f"' {word} CELL+ @ ' {xt_word} = .", 1)
+    return extract_number(r) == -1
+
+
+# Test 1: LIT n + fuses into (LIT+) n
+print("\nTest 1: LIT n +")
+send(': PP-A 5 + ;', 1)
+r = send('3 PP-A .', 1)
+val = extract_number(r)
+check('PP-A computes 8', val == 8, f'got {val}')
+check('PP-A starts with (LIT+)', first_cell_is('PP-A', '(LIT+)'))
+r = send("' PP-A 3 CELLS + @ ' EXIT = .", 1)
+check('PP-A is 3 cells long', extract_number(r) == -1, r.strip())
+
+# Test 2: the VGA fill loop body is one dispatch
+print("\nTest 2: 2DUP ! SWAP 4 + SWAP")
+send('CREATE PP-BUF 16 ALLOT', 1)
+send(': PP-B 2DUP ! SWAP 4 + SWAP ;', 1)
+check('PP-B is (2DUP!UNDER+)', first_cell_is('PP-B', '(2DUP!UNDER+)'))
+r = send("' PP-B 2 CELLS + @ .", 1)
+val = extract_number(r)
+check('operand kept inline', val == 4, f'got {val}')
+r = send('7 PP-BUF PP-B DROP .', 1)
+val = extract_number(r)
+check('x advanced by 4', val == 11, f'got {val}')
+r = send('PP-BUF @ .', 1)
+val = extract_number(r)
+check('x stored at addr', val == 7, f'got {val}')
+
+# Test 3: pair fusions
+print("\nTest 3: @ +, DUP 0=, OVER +")
+send(': PP-C PP-BUF @ + ;', 1)
+r = send('10 PP-C .', 1)
+val = extract_number(r)
+check('@ + result', val == 17, f'got {val}')
+send(': PP-D DUP 0= ;', 1)
+check('PP-D is (DUP0=)', first_cell_is('PP-D', '(DUP0=)'))
+r = send('0 PP-D . .', 1)
+check('DUP 0= on 0', '-1 0' in r, r.strip())
+r = send('5 PP-D . .', 1)
+check('DUP 0= on 5', '0 5' in r, r.strip())
+send(': PP-E OVER + ;', 1)
+r = send('3 4 PP-E . .', 1)
+check('OVER + result', '7 3' in r, r.strip())
+
+# Test 4: no fusing across BEGIN
+print("\nTest 4: control-flow barrier")
+send(': PP-F 1 BEGIN + DUP 100 > 0= WHILE 1 REPEAT ;', 1)
+check('LIT before BEGIN kept', first_cell_is('PP-F', 'LIT'))
+r = send('0 PP-F .', 2)
+val = extract_number(r)
+check('loop runs from BEGIN', val == 101, f'got {val}')
+
+# Test 5: PEEPHOLE off
+print("\nTest 5: PEEPHOLE variable")
+send('0 PEEPHOLE !', 1)
+send(': PP-G 5 + ;', 1)
+send('-1 PEEPHOLE !', 1)
+check('PP-G left unfused', first_cell_is('PP-G', 'LIT'))
+r = send('3 PP-G .', 1)
+val = extract_number(r)
+check('PP-G computes 8', val == 8, f'got {val}')
+
+# Test 6: Stack clean
+print("\nTest 6: Stack clean")
+r = send('.S', 1)
+check('Stack clean', '<>' in r, f'stack: {r.strip()!r}')
+
+print(f'\nPassed: {PASS}/{PASS + FAIL}')
+s.close()
+sys.exit(0 if FAIL == 0 else 1)
@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+"""Test the PROFILER vocabulary.
+
+Loads DISASM and PROFILER from blocks, samples a busy loop
+with PROF-ON/PROF-OFF and checks that PROF-HOT names it. On a
+PROFILE kernel (make test-profile) also checks that PROF-TOP
+ranks the words the loop executes.
+
+Usage:
+    python3 tests/test_profiler.py [PORT]
+"""
+import socket
+import time
+import sys
+import subprocess
+import os
+
+PORT = int(sys.argv[1]) if len(sys.argv) > 1 else 4479
+
+PROJECT_DIR = os.path.dirname(os.path.dirname(
+    os.path.abspath(__file__)))
+
+
+def get_vocab_blocks(vocab_name):
+    """Get vocab start and end block from catalog."""
+    try:
+        result = subprocess.run(
+            [sys.executable, '-c', f"""
+import sys, os
+sys.path.insert(0, os.path.join('{PROJECT_DIR}', 'tools'))
+from importlib.machinery import SourceFileLoader
+wc = SourceFileLoader('wc', os.path.join(
+    '{PROJECT_DIR}', 'tools', 'write-catalog.py'
+)).load_module()
+vocabs = wc.scan_vocabs(os.path.join(
+    '{PROJECT_DIR}', 'forth', 'dict'))
+_nc = (len(vocabs) + wc.CATALOG_DATA_LINES - 1) // wc.CATALOG_DATA_LINES
+nb = 1 + _nc
+for v in vocabs:
+    nb = wc.place_vocab(nb, v['blocks_needed'])
+    if v['name'] == '{vocab_name}':
+        print(f"{{nb}} {{nb + v['blocks_needed'] - 1}}")
+        break
+    nb += v['blocks_needed']
+"""],
+            capture_output=True, text=True, timeout=10
+        )
+        if result.stdout.strip():
+            parts = result.stdout.strip().split()
+            return int(parts[0]), int(parts[1])
+    except Exception:
+        pass
+    return None, None
+
+
+RANGES = {}
+for name in ('DISASM', 'PROFILER'):
+    start, end = get_vocab_blocks(name)
+    if start is None:
+        print(f"FAIL: Could not determine {name} block range")
+        sys.exit(1)
+    RANGES[name] = (start, end)
+    print(f"{name} blocks: {start}-{end}")
+
+s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+s.settimeout(10)
+
+for attempt in range(20):
+    try:
+        s.connect(('127.0.0.1', PORT))
+        break
+    except (ConnectionRefusedError, OSError):
+        time.sleep(0.5)
+else:
+    print("FAIL: Could not connect to QEMU on port", PORT)
+    sys.exit(1)
+
+time.sleep(2)
+try:
+    while True:
+        s.recv(4096)
+except:
+    pass
+
+
+def send(cmd, wait=1.0):
+    """Send a Forth command and collect the response."""
+    s.sendall((cmd + '\r').encode())
+    time.sleep(wait)
+    s.settimeout(2)
+    resp = b''
+    while True:
+        try:
+            d = s.recv(4096)
+            if not d:
+                break
+            resp += d
+        except:
+            break
+    return resp.decode('ascii', errors='replace')
+
+
+def extract_number(text):
+    """Extract a decimal number from Forth output."""
+    words = text.replace('\r', ' ').replace('\n', ' ').split()
+    for i in range(len(words) - 1, -1, -1):
+        if words[i] in ('ok', 'OK'):
+            if i > 0:
+                try:
+                    return int(words[i - 1])
+                except ValueError:
+                    pass
+    for word in words:
+        word = word.strip()
+        if word in ('ok', 'OK', ''):
+            continue
+        try:
+            return int(word)
+        except ValueError:
+            continue
+    return None
+
+
+PASS = 0
+FAIL = 0
+
+
+def check(name, ok, detail=''):
+    global PASS, FAIL
+    if ok:
+        PASS += 1
+        print(f'  PASS: {name}')
+    else:
+        FAIL += 1
+        msg = f'  FAIL: {name}'
+        if detail:
+            msg += f' -- {detail}'
+        print(msg)
+
+
+# ---- Load vocabularies ----
+for name in ('DISASM', 'PROFILER'):
+    start, end = RANGES[name]
+    print(f"\nLoading {name} ({start} {end} THRU)...")
+    r = send(f'{start} {end} THRU', 12)
+    print(f"  THRU response: {r.strip()[-80:]!r}")
+
+# ---- Test 1: PROFILER vocab accessible ----
+print("\nTest 1: PROFILER vocabulary accessible")
+r = send('USING DISASM USING PROFILER DECIMAL', 2)
+check('USING PROFILER succeeds',
+      'ok' in r.lower() and '?' not in r,
+      f'response: {r.strip()!r}')
+
+# Busy-wait for 40 PIT ticks so every sample lands in SPIN
+send(': SPIN TICK-COUNT @ 40 + BEGIN DUP TICK-COUNT @ < UNTIL DROP ;', 1)
+
+# ---- Test 2: sampling fills the ring ----
+print("\nTest 2: PROF-ON collects samples")
+r = send('PROF-ON SPIN PROF-OFF', 5)
+print(f"  {r.strip()!r}")
+r = send('PROF-HEAD @ .', 1)
+n = extract_number(r)
+check('samples recorded', n is not None and n >= 20, f'got {n}')
+r = send('PROF-HEAD @ SPIN PROF-HEAD @ = .', 4)
+check('sampling stops after PROF-OFF', extract_number(r) == -1,
+      f'response: {r.strip()!r}')
+
+# ---- Test 3: PROF-HOT names the busy word ----
+print("\nTest 3: PROF-HOT ranks SPIN first")
+r = send('5 PROF-HOT', 3)
+print(f"  {r.strip()!r}")
+lines = [ln for ln in r.replace('\r', '').split('\n') if ln.strip()]
+first = next((ln for ln in lines if ln.split()[0].isdigit()), '')
+check('SPIN is the hottest word', 'SPIN' in first, f'first: {first!r}')
+
+# ---- Test 4: PROF-CODE resolves native code ----
+print("\nTest 4: PROF-CODE")
+r = send('5 PROF-CODE', 3)
+print(f"  {r.strip()!r}")
+check('PROF-CODE reports samples',
+      any(ln.split()[0].isdigit() for ln in
+          r.replace('\r', '').split('\n') if ln.strip()),
+      f'response: {r.strip()!r}')
+
+# ---- Test 5: PROF-SEND streams every sample ----
+print("\nTest 5: PROF-SEND")
+r = send('PROF-SEND', 5)
+count = len([ln for ln in r.split('\n') if ln.startswith('S ')
+             and 'END' not in ln])
+check('one line per sample', n is not None and count == min(n, 1024),
+      f'{count} lines for {n} samples')
+check('stream terminated', 'S END' in r)
+
+# ---- Test 6: per-word counters (PROFILE kernel only) ----
+print("\nTest 6: PROF-TOP")
+r = send('PROFILING .', 1)
+if extract_number(r) == -1:
+    send('PROF-RESET SPIN', 4)
+    r = send('3 PROF-TOP', 10)
+    print(f"  {r.strip()!r}")
+    check('TICK-COUNT among the most executed',
+          'TICK-COUNT' in r, f'response: {r.strip()!r}')
+    r = send("PROF-COUNTS ' TICK-COUNT + @ 0> .", 10)
+    check('counters restored after PROF-TOP',
+          extract_number(r) == -1, f'response: {r.strip()!r}')
+else:
+    r = send('3 PROF-TOP', 2)
+    check('PROF-TOP refuses without PROFILE',
+          'without PROFILE' in r, f'response: {r.strip()!r}')
+
+# ---- Summary ----
+print()
+print(f'Passed: {PASS}/{PASS + FAIL}')
+s.close()
+sys.exit(0 if FAIL == 0 else 1)
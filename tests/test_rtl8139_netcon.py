@@ -0,0 +1,227 @@
+#!/usr/bin/env python3
+"""Test the kernel net console on the RTL8139's four TX slots.
+
+Boots one QEMU with an rtl8139 whose traffic is captured by a
+filter-dump, loads PCI-ENUM, PKT-RING and RTL8139 from blocks, wires
+the console with RTL-NET-CON and flushes six frames back to back:
+
+1. NET-TX-SLOT moves one slot per frame (6 frames = 2 mod 4)
+2. All six frames reach the wire, in order, with consecutive IP IDs
+3. RTL-TX shares the slot counter with the console
+
+Usage:
+    python3 tests/test_rtl8139_netcon.py [PORT]
+"""
+import os
+import re
+import socket
+import struct
+import subprocess
+import sys
+import time
+
+PORT = int(sys.argv[1]) if len(sys.argv) > 1 else 4792
+
+PROJECT_DIR = os.path.dirname(os.path.dirname(
+    os.path.abspath(__file__)))
+COMBINED = os.path.join(PROJECT_DIR, 'build', 'combined.img')
+COMBINED_IDE = os.path.join(PROJECT_DIR, 'build', 'combined-ide.img')
+PCAP = os.path.join(PROJECT_DIR, 'build', f'rtl8139-netcon-{PORT}.pcap')
+QEMU = 'qemu-system-i386'
+CON_PORT = 6666
+
+
+def get_vocab_blocks(vocab_name):
+    try:
+        result = subprocess.run(
+            [sys.executable, '-c', f"""
+import sys, os
+sys.path.insert(0, os.path.join('{PROJECT_DIR}', 'tools'))
+from importlib.machinery import SourceFileLoader
+wc = SourceFileLoader('wc', os.path.join(
+    '{PROJECT_DIR}', 'tools', 'write-catalog.py'
+)).load_module()
+vocabs = wc.scan_vocabs(os.path.join(
+    '{PROJECT_DIR}', 'forth', 'dict'))
+_nc = (len(vocabs) + wc.CATALOG_DATA_LINES - 1) // wc.CATALOG_DATA_LINES
+nb = 1 + _nc
+for v in vocabs:
+    nb = wc.place_vocab(nb, v['blocks_needed'])
+    if v['name'] == '{vocab_name}':
+        print(f"{{nb}} {{nb + v['blocks_needed'] - 1}}")
+        break
+    nb += v['blocks_needed']
+"""],
+            capture_output=True, text=True, timeout=10
+        )
+        if result.stdout.strip():
+            parts = result.stdout.strip().split()
+            return int(parts[0]), int(parts[1])
+    except Exception:
+        pass
+    return None, None
+
+
+def start_qemu():
+    if os.path.exists(PCAP):
+        os.unlink(PCAP)
+    subprocess.run([
+        QEMU,
+        '-drive', f'file={COMBINED},format=raw,if=floppy',
+        '-drive', f'file={COMBINED_IDE},format=raw,if=ide,index=1',
+        '-netdev', 'user,id=net0',
+        '-device', 'rtl8139,netdev=net0',
+        '-object', f'filter-dump,id=cap0,netdev=net0,file={PCAP}',
+        '-serial', f'tcp::{PORT},server=on,wait=off',
+        '-display', 'none', '-daemonize'
+    ], capture_output=True)
+    time.sleep(2)
+
+
+def connect():
+    s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    s.settimeout(10)
+    for attempt in range(20):
+        try:
+            s.connect(('127.0.0.1', PORT))
+            break
+        except (ConnectionRefusedError, OSError):
+            time.sleep(0.5)
+    else:
+        return None
+    time.sleep(2)
+    try:
+        while True:
+            s.recv(4096)
+    except Exception:
+        pass
+    return s
+
+
+def send(cmd, wait=1.0):
+    sock.sendall((cmd + '\r').encode())
+    time.sleep(wait)
+    sock.settimeout(2)
+    resp = b''
+    while True:
+        try:
+            d = sock.recv(4096)
+            if not d:
+                break
+            resp += d
+        except Exception:
+            break
+    return resp.decode('ascii', errors='replace')
+
+
+def extract_number(text):
+    nums = re.findall(r'(-?\d+)\s+ok', text)
+    return int(nums[-1]) if nums else None
+
+
+def console_frames(path):
+    """(ip_id, payload) of each UDP frame to CON_PORT in a pcap."""
+    frames = []
+    with open(path, 'rb') as f:
+        data = f.read()
+    pos = 24                                # pcap global header
+    while pos + 16 <= len(data):
+        incl = struct.unpack_from('<I', data, pos + 8)[0]
+        pkt = data[pos + 16:pos + 16 + incl]
+        pos += 16 + incl
+        if len(pkt) < 42 or pkt[12:14] != b'\x08\x00' or pkt[23] != 17:
+            continue
+        if struct.unpack_from('>H', pkt, 36)[0] != CON_PORT:
+            continue
+        ip_id = struct.unpack_from('>H', pkt, 18)[0]
+        udp_len = struct.unpack_from('>H', pkt, 38)[0]
+        frames.append((ip_id, pkt[42:34 + udp_len]))
+    return frames
+
+
+PASS = FAIL = 0
+
+
+def check(name, ok, detail=''):
+    global PASS, FAIL
+    if ok:
+        PASS += 1
+        print(f'  PASS: {name}')
+    else:
+        FAIL += 1
+        print(f'  FAIL: {name}' + (f' -- {detail}' if detail else ''))
+
+
+def cleanup():
+    subprocess.run(['pkill', '-9', '-f', f'[q]emu.*{PORT}'],
+                   capture_output=True)
+
+
+# --- Main ---
+cleanup()
+time.sleep(1)
+
+blocks = {v: get_vocab_blocks(v) for v in ('PCI-ENUM', 'PKT-RING', 'RTL8139')}
+if any(b[0] is None for b in blocks.values()):
+    print(f'FAIL: Could not determine block ranges: {blocks}')
+    sys.exit(1)
+
+print('Starting QEMU (rtl8139, filter-dump)...')
+start_qemu()
+sock = connect()
+if sock is None:
+    print('FAIL: Could not connect to QEMU')
+    cleanup()
+    sys.exit(1)
+
+for name, (first, last) in blocks.items():
+    r = send(f'{first} {last} THRU', 8)
+    check(f'{name} loads', '?' not in r, r.strip()[-120:])
+
+r = send('ALSO HARDWARE ALSO RTL8139 HEX 3000 PHYS-ALLOC RTL-AUTO', 4)
+check('RTL-AUTO finds the chip', 'RTL8139 ready' in r, r.strip()[-160:])
+
+r = send('RTL-NET-CON NET-TX-KIND @ . NET-TX-N @ . DECIMAL', 1)
+check('RTL-NET-CON selects the RTL8139 hand-off',
+      re.search(r'1 4\s+ok', r) is not None, r.strip()[-80:])
+
+# ---- Test 1: six frames back to back rotate through the slots ----
+print('\nTest 1: back-to-back console frames')
+send('NET-CON-ON', 1)
+send(': BURST 6 0 DO ." netcon-frame " I . NET-FLUSH LOOP ;', 1)
+r = send('NET-TX-SLOT @ BURST NET-TX-SLOT @ SWAP - 3 AND .', 2)
+check('six flushes move NET-TX-SLOT by 6 mod 4',
+      extract_number(r) == 2, r.strip()[-80:])
+
+# ---- Test 2: RTL-TX shares the counter ----
+print('\nTest 2: RTL-TX takes the next console slot')
+r = send('NET-TX-SLOT @ NET-TX-BUF @ 60 RTL-TX NET-TX-SLOT @ SWAP - 3 AND .',
+         1)
+check('RTL-TX advances NET-TX-SLOT', extract_number(r) == 1,
+      r.strip()[-80:])
+send('NET-CON-OFF', 1)
+
+cleanup()
+time.sleep(1)
+
+# ---- Test 3: the wire saw every frame, in order ----
+print('\nTest 3: captured frames')
+frames = console_frames(PCAP) if os.path.exists(PCAP) else []
+burst = []
+for ip_id, payload in frames:
+    for m in re.finditer(rb'netcon-frame (\d+)', payload):
+        burst.append((ip_id, int(m.group(1))))
+print(f'  console frames captured: {len(frames)}, burst frames: {burst}')
+check('all six burst frames on the wire',
+      [n for _, n in burst] == list(range(6)), f'{burst}')
+ids = [i for i, _ in burst]
+check('burst frames carry consecutive IP IDs',
+      len(ids) == 6 and all((b - a) & 0xFFFF == 1
+                            for a, b in zip(ids, ids[1:])), f'{ids}')
+
+if os.path.exists(PCAP):
+    os.unlink(PCAP)
+
+print()
+print(f'Passed: {PASS}/{PASS + FAIL}')
+sys.exit(1 if FAIL else 0)
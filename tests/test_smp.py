@@ -0,0 +1,259 @@
+#!/usr/bin/env python3
+"""Test the SMP vocabulary and the kernel atomics.
+
+Loads SHUTDOWN and SMP from blocks (HARDWARE is embedded), checks XADD,
+CAS and SPIN-LOCK, runs PAR-DO on the BSP alone, then starts the APs
+with SMP-ON and checks that jobs run on them and still add up. LFB-WC
+must refuse partial 4MB pages and, with the APs up, flush every CPU.
+
+Usage:
+    python3 tests/test_smp.py [PORT]
+
+The test expects QEMU to be running with -smp 2 and the block disk
+attached on the specified TCP serial port (default 4473).
+"""
+import socket
+import time
+import sys
+import subprocess
+import os
+
+PORT = int(sys.argv[1]) if len(sys.argv) > 1 else 4473
+
+PROJECT_DIR = os.path.dirname(os.path.dirname(
+    os.path.abspath(__file__)))
+
+
+def get_vocab_blocks(vocab_name):
+    """Get a vocabulary's start and end block from the catalog."""
+    try:
+        result = subprocess.run(
+            [sys.executable, '-c', f"""
+import sys, os
+sys.path.insert(0, os.path.join('{PROJECT_DIR}', 'tools'))
+from importlib.machinery import SourceFileLoader
+wc = SourceFileLoader('wc', os.path.join(
+    '{PROJECT_DIR}', 'tools', 'write-catalog.py'
+)).load_module()
+vocabs = wc.scan_vocabs(os.path.join(
+    '{PROJECT_DIR}', 'forth', 'dict'))
+_nc = (len(vocabs) + wc.CATALOG_DATA_LINES - 1) // wc.CATALOG_DATA_LINES
+nb = 1 + _nc
+for v in vocabs:
+    nb = wc.place_vocab(nb, v['blocks_needed'])
+    if v['name'] == '{vocab_name}':
+        print(f"{{nb}} {{nb + v['blocks_needed'] - 1}}")
+        break
+    nb += v['blocks_needed']
+"""],
+            capture_output=True, text=True, timeout=10
+        )
+        if result.stdout.strip():
+            parts = result.stdout.strip().split()
+            return int(parts[0]), int(parts[1])
+    except Exception:
+        pass
+    return None, None
+
+
+SD_START, SD_END = get_vocab_blocks('SHUTDOWN')
+SMP_START, SMP_END = get_vocab_blocks('SMP')
+print(f"SHUTDOWN blocks: {SD_START}-{SD_END}")
+print(f"SMP blocks: {SMP_START}-{SMP_END}")
+if SD_START is None or SMP_START is None:
+    print("FAIL: SHUTDOWN or SMP not found in catalog")
+    sys.exit(1)
+
+s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+s.settimeout(10)
+
+# Retry connection in case QEMU isn't ready
+for attempt in range(20):
+    try:
+        s.connect(('127.0.0.1', PORT))
+        break
+    except (ConnectionRefusedError, OSError):
+        time.sleep(0.5)
+else:
+    print("FAIL: Could not connect to QEMU on port", PORT)
+    sys.exit(1)
+
+time.sleep(2)
+try:
+    while True:
+        s.recv(4096)
+except:
+    pass
+
+
+def send(cmd, wait=1.0):
+    """Send a Forth command and collect the response."""
+    s.sendall((cmd + '\r').encode())
+    time.sleep(wait)
+    s.settimeout(2)
+    resp = b''
+    while True:
+        try:
+            d = s.recv(4096)
+            if not d:
+                break
+            resp += d
+        except:
+            break
+    return resp.decode('ascii', errors='replace')
+
+
+def extract_number(text):
+    """Extract a decimal number from Forth output.
+
+    The response typically looks like:
+        'TICK-COUNT @ .\\r\\n42 ok'
+    We want the number just before 'ok'.
+    """
+    # Split and look for numbers
+    words = text.replace('\r', ' ').replace('\n', ' ').split()
+    # Walk backwards from 'ok' to find the number
+    for i in range(len(words) - 1, -1, -1):
+        if words[i] == 'ok' or words[i] == 'OK':
+            # Check previous word
+            if i > 0:
+                try:
+                    return int(words[i - 1])
+                except ValueError:
+                    pass
+    # Fallback: try each word
+    for word in words:
+        word = word.strip()
+        if word in ('ok', 'OK', ''):
+            continue
+        try:
+            return int(word)
+        except ValueError:
+            continue
+    return None
+
+
+PASS = 0
+FAIL = 0
+
+
+def check(name, ok, detail=''):
+    global PASS, FAIL
+    if ok:
+        PASS += 1
+        print(f'  PASS: {name}')
+    else:
+        FAIL += 1
+        msg = f'  FAIL: {name}'
+        if detail:
+            msg += f' -- {detail}'
+        print(msg)
+
+
+# ---- Load vocabularies ----
+print("\nLoading SHUTDOWN and SMP...")
+r = send(f'{SD_START} {SD_END} THRU', 3)
+r = send(f'{SMP_START} {SMP_END} THRU', 5)
+print(f"  THRU response: {r.strip()!r}")
+
+# ---- Test 1: single CPU at boot ----
+print("\nTest 1: SMP accessible, one CPU at boot")
+r = send('USING SMP ALSO HARDWARE DECIMAL #CPUS @ .', 2)
+check('#CPUS = 1 before SMP-ON', extract_number(r) == 1,
+      f'response: {r.strip()!r}')
+r = send('CPU# .', 1)
+check('CPU# = 0 on the BSP', extract_number(r) == 0,
+      f'response: {r.strip()!r}')
+
+# ---- Test 2: atomics ----
+print("\nTest 2: XADD, CAS, SPIN-LOCK")
+send('VARIABLE V 5 V !', 1)
+r = send('3 V XADD .', 1)
+check('XADD returns the old value', extract_number(r) == 5,
+      f'response: {r.strip()!r}')
+r = send('V @ .', 1)
+check('XADD adds', extract_number(r) == 8, f'response: {r.strip()!r}')
+r = send('8 9 V CAS .', 1)
+check('CAS stores when the cell matches', extract_number(r) == -1,
+      f'response: {r.strip()!r}')
+r = send('1 2 V CAS V @ + .', 1)
+check('CAS leaves a changed cell alone', extract_number(r) == 9,
+      f'response: {r.strip()!r}')
+r = send('VARIABLE L 0 L ! L SPIN-LOCK L @ .', 1)
+check('SPIN-LOCK takes the lock', extract_number(r) == 1,
+      f'response: {r.strip()!r}')
+r = send('L SPIN-UNLOCK L @ .', 1)
+check('SPIN-UNLOCK frees it', extract_number(r) == 0,
+      f'response: {r.strip()!r}')
+
+# ---- Test 3: PAR-DO on the BSP alone ----
+print("\nTest 3: PAR-DO without APs")
+send('VARIABLE SUM : ADDI ( i -- ) SUM XADD DROP ;', 1)
+r = send("0 SUM ! ' ADDI 100 PAR-DO SUM @ .", 2)
+check('0..99 add up to 4950', extract_number(r) == 4950,
+      f'response: {r.strip()!r}')
+
+# ---- Test 3b: paging and whole 4MB pages ----
+print("\nTest 3b: PAGING-ON and LFB-WC ranges")
+r = send('PAGING-ON .', 1)
+check('PAGING-ON before the APs start', extract_number(r) == -1,
+      f'response: {r.strip()!r}')
+r = send('HEX FD100000 400000 LFB-WC DECIMAL .', 1)
+check('LFB-WC refuses an unaligned start', extract_number(r) == 0,
+      f'response: {r.strip()!r}')
+r = send('HEX FD000000 300000 LFB-WC DECIMAL .', 1)
+check('LFB-WC refuses a partial 4MB page', extract_number(r) == 0,
+      f'response: {r.strip()!r}')
+
+# ---- Test 4: start the APs ----
+print("\nTest 4: SMP-ON")
+r = send('SMP-ON .', 3)
+n = extract_number(r)
+print(f"  CPUs running: {n}")
+check('SMP-ON starts the second CPU', n == 2, f'response: {r.strip()!r}')
+r = send('1 CPU-BLOCK PC-STATE + @ .', 1)
+check('AP 1 is running AP-LOOP', extract_number(r) == 2,
+      f'response: {r.strip()!r}')
+
+# ---- Test 5: jobs run on the AP ----
+print("\nTest 5: PAR-DO with an AP")
+send('CREATE WHO 256 CELLS ALLOT '
+     ': MARK ( i -- ) CPU# SWAP CELLS WHO + ! 20000 0 DO LOOP ;', 1)
+r = send("' MARK 256 PAR-DO 0 256 0 DO WHO I CELLS + @ + LOOP .", 5)
+c = extract_number(r)
+print(f"  jobs run on CPU 1: {c}")
+check('some jobs ran on the AP', c is not None and c > 0,
+      f'response: {r.strip()!r}')
+r = send("0 SUM ! ' ADDI 100 PAR-DO SUM @ .", 2)
+check('sum is still 4950 across CPUs', extract_number(r) == 4950,
+      f'response: {r.strip()!r}')
+
+# ---- Test 5b: LFB-WC shoots down every CPU's TLB ----
+print("\nTest 5b: TLB shootdown")
+send(': TLBS ( n -- count ) CPU-BLOCK PC-USER + CELL+ @ ;', 1)
+r = send('HEX FD000000 1000000 LFB-WC DECIMAL .', 3)
+check('LFB-WC takes the 16MB LFB', extract_number(r) == -1,
+      f'response: {r.strip()!r}')
+r = send('0 TLBS .', 1)
+check('the BSP flushed once', extract_number(r) == 1,
+      f'response: {r.strip()!r}')
+r = send('1 TLBS .', 1)
+check('the AP flushed once', extract_number(r) == 1,
+      f'response: {r.strip()!r}')
+
+# ---- Test 6: SMP-OFF parks the AP ----
+print("\nTest 6: .CPUS and SMP-OFF")
+r = send('.CPUS', 2)
+check('.CPUS lists the running AP', 'running' in r and 'apic' in r,
+      f'response: {r.strip()[:120]!r}')
+r = send('SMP-OFF 10 MS-DELAY 1 CPU-BLOCK PC-STATE + @ .', 1)
+check('SMP-OFF parks the AP', extract_number(r) == 1,
+      f'response: {r.strip()!r}')
+r = send('.S', 1)
+check('stack clean', '<>' in r, f'stack: {r.strip()!r}')
+
+# ---- Summary ----
+print()
+print(f'Passed: {PASS}/{PASS + FAIL}')
+s.close()
+sys.exit(0 if FAIL == 0 else 1)
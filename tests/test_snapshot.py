@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""Test booting from a dictionary snapshot (tools/make-snapshot.py).
+
+Run against build/combined-snap.img: SNAPSHOT-BOOT is set, embedded
+vocabularies are usable, the replayed PCI-SCAN found devices, and the
+restored dictionary accepts new definitions.
+
+With a second argument "fallback" the image's snapshot has a bad kernel
+hash: SNAPSHOT-BOOT must stay 0 and the text blob must have been loaded.
+
+With "dirty" QEMU has filled UI-CORE's tables (2MB) and the first 4MB
+above 16MB with A5 bytes before boot, as real RAM holds garbage. The
+replayed WT-RESET and (free tier, where FILE-EDITOR is embedded)
+FE-RESET must have cleared what the snapshot does not carry.
+"""
+import socket
+import time
+import sys
+
+PORT = int(sys.argv[1]) if len(sys.argv) > 1 else 4505
+FALLBACK = len(sys.argv) > 2 and sys.argv[2] == 'fallback'
+DIRTY = len(sys.argv) > 2 and sys.argv[2] == 'dirty'
+
+s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+s.settimeout(10)
+for attempt in range(20):
+    try:
+        s.connect(('127.0.0.1', PORT))
+        break
+    except (ConnectionRefusedError, OSError):
+        time.sleep(0.5)
+else:
+    print("FAIL: connect")
+    sys.exit(1)
+
+time.sleep(3)
+try:
+    while True:
+        s.recv(4096)
+except Exception:
+    pass
+
+
+def send(cmd, wait=1.0):
+    s.sendall((cmd + '\r').encode())
+    time.sleep(wait)
+    s.settimeout(2)
+    resp = b''
+    while True:
+        try:
+            d = s.recv(4096)
+            if not d:
+                break
+            resp += d
+        except Exception:
+            break
+    return resp.decode('ascii', errors='replace')
+
+
+def extract_number(text):
+    words = text.replace('\r', ' ').replace('\n', ' ').split()
+    for i in range(len(words) - 1, -1, -1):
+        if words[i] in ('ok', 'OK'):
+            if i > 0:
+                try:
+                    return int(words[i - 1])
+                except ValueError:
+                    pass
+    return None
+
+
+PASS = FAIL = 0
+
+
+def check(name, ok, detail=''):
+    global PASS, FAIL
+    if ok:
+        PASS += 1
+        print(f'  PASS: {name}')
+    else:
+        FAIL += 1
+        print(f'  FAIL: {name} -- {detail}' if detail else
+              f'  FAIL: {name}')
+
+
+# Test 1: Boot path
+print("\nTest 1: Boot path")
+r = send('SNAPSHOT-BOOT @ .', 1)
+val = extract_number(r)
+want = 0 if FALLBACK else -1
+check('SNAPSHOT-BOOT', val == want, f'expected {want}, got {val}')
+
+# Test 2: Embedded vocabularies present either way
+print("\nTest 2: Embedded vocabularies")
+r = send('ALSO PCI-ENUM PCI-COUNT @ 0> . PREVIOUS', 1)
+val = extract_number(r)
+check('PCI-SCAN ran at boot', val == -1, f'expected -1, got {val}')
+r = send("ALSO UI-CORE ' WT-RESET 0<> . PREVIOUS", 1)
+val = extract_number(r)
+check('WT-RESET found', val == -1, f'expected -1, got {val}')
+# NOTEPAD is embedded in the free tier only; the full tier block-loads it
+FREE_TIER = '?' not in send('ALSO NOTEPAD PREVIOUS', 1)
+if not FREE_TIER:
+    send('PREVIOUS', 1)     # The error skipped PREVIOUS; drop ALSO's copy
+if FREE_TIER:
+    r = send("ALSO NOTEPAD ' NOTEPAD-RUN 0<> . PREVIOUS", 1)
+    val = extract_number(r)
+    check('NOTEPAD-RUN found', val == -1, f'expected -1, got {val}')
+
+# Test 3: Restored dictionary extends normally
+print("\nTest 3: New definitions")
+send(': SN-A 7 ;', 1)
+send(': SN-B SN-A 6 * ;', 1)
+r = send('SN-B .', 1)
+val = extract_number(r)
+check('Compile on top of image', val == 42, f'expected 42, got {val}')
+r = send('HEX KERNEL-HASH 0<> DECIMAL .', 1)
+val = extract_number(r)
+check('KERNEL-HASH', val == -1, f'expected -1, got {val}')
+
+# Test 4: Load-time state outside the dictionary (pattern-filled RAM)
+if DIRTY:
+    print("\nTest 4: Replayed initializers")
+    r = send('ALSO UI-CORE WT-COUNT @ EVT-HEAD @ OR POOL-POS @ OR . PREVIOUS',
+             1)
+    val = extract_number(r)
+    check('WT-RESET cleared WT-VARS', val == 0, f'expected 0, got {val}')
+if DIRTY and FREE_TIER:
+    r = send('ALSO FILE-EDITOR FE-LIDX @ DUP 16777215 > '
+             'SWAP 20971520 < AND . PREVIOUS', 1)
+    val = extract_number(r)
+    check('Line index in the filled range', val == -1,
+          f'expected -1, got {val}')
+    r = send('ALSO FILE-EDITOR 0 LX @ TOTAL-LINES 10 * + . PREVIOUS', 1)
+    val = extract_number(r)
+    check('FE-RESET rebuilt the line index', val == 10,
+          f'expected 10, got {val}')
+
+# Test 5: Stack clean
+print("\nTest 5: Stack clean")
+r = send('.S', 1)
+check('Stack clean', '<>' in r, f'stack: {r.strip()!r}')
+
+print(f'\nPassed: {PASS}/{PASS + FAIL}')
+s.close()
+sys.exit(0 if FAIL == 0 else 1)
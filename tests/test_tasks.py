@@ -0,0 +1,239 @@
+#!/usr/bin/env python3
+"""Test the TASKS cooperative multitasker.
+
+Loads TASKS from blocks (HARDWARE is embedded), starts a counting task, checks
+that it runs while the interpreter waits in KEY, that SLEEP parks it
+for its ticks, that STOP/WAKE work, and that DPC-QUEUE hands work to
+the worker task.
+
+Usage:
+    python3 tests/test_tasks.py [PORT]
+
+The test expects QEMU to be running with the block disk attached
+on the specified TCP serial port (default 4472).
+"""
+import socket
+import time
+import sys
+import subprocess
+import os
+
+PORT = int(sys.argv[1]) if len(sys.argv) > 1 else 4472
+
+PROJECT_DIR = os.path.dirname(os.path.dirname(
+    os.path.abspath(__file__)))
+
+
+def get_vocab_blocks(vocab_name):
+    """Get a vocabulary's start and end block from the catalog."""
+    try:
+        result = subprocess.run(
+            [sys.executable, '-c', f"""
+import sys, os
+sys.path.insert(0, os.path.join('{PROJECT_DIR}', 'tools'))
+from importlib.machinery import SourceFileLoader
+wc = SourceFileLoader('wc', os.path.join(
+    '{PROJECT_DIR}', 'tools', 'write-catalog.py'
+)).load_module()
+vocabs = wc.scan_vocabs(os.path.join(
+    '{PROJECT_DIR}', 'forth', 'dict'))
+_nc = (len(vocabs) + wc.CATALOG_DATA_LINES - 1) // wc.CATALOG_DATA_LINES
+nb = 1 + _nc
+for v in vocabs:
+    nb = wc.place_vocab(nb, v['blocks_needed'])
+    if v['name'] == '{vocab_name}':
+        print(f"{{nb}} {{nb + v['blocks_needed'] - 1}}")
+        break
+    nb += v['blocks_needed']
+"""],
+            capture_output=True, text=True, timeout=10
+        )
+        if result.stdout.strip():
+            parts = result.stdout.strip().split()
+            return int(parts[0]), int(parts[1])
+    except Exception:
+        pass
+    return None, None
+
+
+TK_START, TK_END = get_vocab_blocks('TASKS')
+print(f"TASKS blocks: {TK_START}-{TK_END}")
+if TK_START is None:
+    print("FAIL: TASKS not found in catalog")
+    sys.exit(1)
+
+s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+s.settimeout(10)
+
+# Retry connection in case QEMU isn't ready
+for attempt in range(20):
+    try:
+        s.connect(('127.0.0.1', PORT))
+        break
+    except (ConnectionRefusedError, OSError):
+        time.sleep(0.5)
+else:
+    print("FAIL: Could not connect to QEMU on port", PORT)
+    sys.exit(1)
+
+time.sleep(2)
+try:
+    while True:
+        s.recv(4096)
+except:
+    pass
+
+
+def send(cmd, wait=1.0):
+    """Send a Forth command and collect the response."""
+    s.sendall((cmd + '\r').encode())
+    time.sleep(wait)
+    s.settimeout(2)
+    resp = b''
+    while True:
+        try:
+            d = s.recv(4096)
+            if not d:
+                break
+            resp += d
+        except:
+            break
+    return resp.decode('ascii', errors='replace')
+
+
+def extract_number(text):
+    """Extract a decimal number from Forth output.
+
+    The response typically looks like:
+        'TICK-COUNT @ .\\r\\n42 ok'
+    We want the number just before 'ok'.
+    """
+    # Split and look for numbers
+    words = text.replace('\r', ' ').replace('\n', ' ').split()
+    # Walk backwards from 'ok' to find the number
+    for i in range(len(words) - 1, -1, -1):
+        if words[i] == 'ok' or words[i] == 'OK':
+            # Check previous word
+            if i > 0:
+                try:
+                    return int(words[i - 1])
+                except ValueError:
+                    pass
+    # Fallback: try each word
+    for word in words:
+        word = word.strip()
+        if word in ('ok', 'OK', ''):
+            continue
+        try:
+            return int(word)
+        except ValueError:
+            continue
+    return None
+
+
+PASS = 0
+FAIL = 0
+
+
+def check(name, ok, detail=''):
+    global PASS, FAIL
+    if ok:
+        PASS += 1
+        print(f'  PASS: {name}')
+    else:
+        FAIL += 1
+        msg = f'  FAIL: {name}'
+        if detail:
+            msg += f' -- {detail}'
+        print(msg)
+
+
+# ---- Load vocabulary ----
+print(f"\nLoading TASKS ({TK_START} {TK_END} THRU)...")
+r = send(f'{TK_START} {TK_END} THRU', 5)
+print(f"  THRU response: {r.strip()!r}")
+
+# ---- Test 1: vocabulary, tasks off ----
+print("\nTest 1: TASKS accessible, tasks off at boot")
+r = send('USING TASKS ALSO HARDWARE DECIMAL TASK @ .', 2)
+check('TASK @ = 0 before TASKS-ON', extract_number(r) == 0,
+      f'response: {r.strip()!r}')
+r = send('PAUSE 1 2 + .', 1)
+check('PAUSE is a no-op with tasks off', extract_number(r) == 3,
+      f'response: {r.strip()!r}')
+
+# ---- Test 2: a background task runs ----
+print("\nTest 2: background counter")
+send('VARIABLE CNT 0 CNT ! '
+     ': COUNTER BEGIN 1 CNT +! PAUSE AGAIN ; '
+     '256 256 TASK-CREATE T1', 1)
+r = send("TASKS-ON ' COUNTER T1 TASK-RUN TASK @ MAIN-TASK = .", 1)
+check('TASKS-ON links the interpreter as MAIN-TASK',
+      extract_number(r) == -1, f'response: {r.strip()!r}')
+r = send('CNT @ .', 1)
+c1 = extract_number(r)
+time.sleep(1)
+r = send('CNT @ .', 1)
+c2 = extract_number(r)
+print(f"  CNT: {c1} -> {c2}")
+check('counter advances while KEY waits',
+      c1 is not None and c2 is not None and c2 > c1,
+      f'{c1} -> {c2}')
+
+# ---- Test 3: STOP / WAKE ----
+print("\nTest 3: STOP and WAKE")
+r = send('T1 STOP CNT @ .', 1)
+c1 = extract_number(r)
+time.sleep(0.5)
+r = send('CNT @ .', 1)
+c2 = extract_number(r)
+check('stopped task does not run', c1 == c2, f'{c1} -> {c2}')
+send('T1 WAKE', 1)
+r = send('CNT @ .', 1)
+c3 = extract_number(r)
+check('woken task runs again',
+      c3 is not None and c2 is not None and c3 > c2, f'{c2} -> {c3}')
+send('T1 STOP', 1)
+
+# ---- Test 4: SLEEP ----
+print("\nTest 4: SLEEP parks a task for its ticks")
+send(': NAPPER BEGIN 1 CNT +! 18 SLEEP AGAIN ; 0 CNT !', 1)
+send("' NAPPER T1 TASK-RUN", 1)
+time.sleep(2.2)
+r = send('CNT @ .', 1)
+c = extract_number(r)
+print(f"  wakeups in ~2.2s at 18 ticks: {c}")
+check('sleeper wakes about once per second',
+      c is not None and 2 <= c <= 4, f'got {c}')
+send('T1 STOP', 1)
+
+# ---- Test 5: deferred work ----
+print("\nTest 5: DPC-QUEUE runs in the worker")
+send('VARIABLE WHO : JOB TASK @ WHO ! ;', 1)
+r = send("' JOB DPC-QUEUE PAUSE WHO @ DPC-WORKER = .", 1)
+check('DPC-QUEUE job ran in DPC-WORKER', extract_number(r) == -1,
+      f'response: {r.strip()!r}')
+r = send('DPC-DONE @ .', 1)
+check('DPC-DONE counted the job', extract_number(r) == 1,
+      f'response: {r.strip()!r}')
+
+# ---- Test 5b: DEPTH counts the running task's own stack ----
+print("\nTest 5b: DEPTH inside a task")
+send('VARIABLE TD : DEPTHER 7 8 DEPTH TD ! 2DROP ;', 1)
+r = send("-1 TD ! ' DEPTHER DPC-QUEUE PAUSE TD @ .", 1)
+check('DEPTH in a task counts from its TCB_S0', extract_number(r) == 2,
+      f'response: {r.strip()!r}')
+
+# ---- Test 6: status and a clean stack ----
+print("\nTest 6: .TASKS and stack")
+r = send('.TASKS', 2)
+check('.TASKS lists the ring', 'ready' in r and 'Switches' in r,
+      f'response: {r.strip()[:120]!r}')
+r = send('.S', 1)
+check('stack clean', '<>' in r, f'stack: {r.strip()!r}')
+
+# ---- Summary ----
+print()
+print(f'Passed: {PASS}/{PASS + FAIL}')
+s.close()
+sys.exit(0 if FAIL == 0 else 1)
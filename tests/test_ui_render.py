@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""Test dirty-widget rendering through the shadow screen.
+
+FORM-RENDER draws into the UI-CORE shadow and SH-END copies only the
+changed cells. A counting GFX-PUTC hook sees every cell SH-END writes,
+and SH-TOP/SH-BOT give the rows the render touched:
+
+1. A dirty-only render touches only the changed widget's row
+2. A dirty widget whose cells did not change writes nothing
+3. FORM-INVALIDATE repaints every row and repairs a corrupted cell
+4. Console output over the form is cleared by the next dirty-only
+   render
+
+Each render sequence runs on one input line: the interpreter's echo
+and "ok" are console output too.
+
+Usage:
+    python3 tests/test_ui_render.py [PORT]
+"""
+import re
+import socket
+import sys
+import time
+
+PORT = int(sys.argv[1]) if len(sys.argv) > 1 else 4768
+
+s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+s.settimeout(10)
+for attempt in range(20):
+    try:
+        s.connect(('127.0.0.1', PORT))
+        break
+    except (ConnectionRefusedError, OSError):
+        time.sleep(0.5)
+else:
+    print("FAIL: Could not connect")
+    sys.exit(1)
+
+time.sleep(2)
+try:
+    while True:
+        s.recv(4096)
+except Exception:
+    pass
+
+
+def send(cmd, wait=1.0):
+    s.sendall((cmd + '\r').encode())
+    time.sleep(wait)
+    s.settimeout(2)
+    resp = b''
+    while True:
+        try:
+            d = s.recv(4096)
+            if not d:
+                break
+            resp += d
+        except Exception:
+            break
+    return resp.decode('ascii', errors='replace')
+
+
+def result_ints(resp):
+    """Numbers printed on the result line, before 'ok'."""
+    m = re.findall(r'((?:-?\d+\s+)+)ok', resp)
+    return [int(n) for n in m[-1].split()] if m else []
+
+
+PASS = FAIL = 0
+
+
+def check(name, ok, detail=''):
+    global PASS, FAIL
+    if ok:
+        PASS += 1
+        print(f'  PASS: {name}')
+    else:
+        FAIL += 1
+        print(f'  FAIL: {name}' +
+              (f' -- {detail}' if detail else ''))
+
+
+r = send('S" UI-EVENTS" LOAD-VOCAB', 10)
+send('ALSO UI-CORE ALSO UI-EVENTS DECIMAL', 1)
+r = send('1 2 + .', 1)
+if '3' not in r:
+    print("FAIL: Could not load UI-EVENTS")
+    s.close()
+    sys.exit(1)
+
+# Label on row 2, inputs (widgets 1 and 2) on rows 5 and 8
+send('VARIABLE NCELLS', 0.5)
+send(': COUNT-CELL ( ch attr col row -- ) 2DROP 2DROP 1 NCELLS +! ;', 0.5)
+send(': COUNTING ( -- ) [\'] COUNT-CELL GFX-PUTC ! 0 NCELLS ! ;', 0.5)
+send(': REPORT ( -- ) 0 GFX-PUTC ! SH-TOP @ . SH-BOT @ . NCELLS @ . ;',
+     0.5)
+send(': MK-FORM ( -- ) WT-RESET 2 2 S" Render test" ADD-LABEL '
+     '2 5 20 S" Name" ADD-INPUT 2 8 20 S" City" ADD-INPUT '
+     'FORM-RENDER ;', 0.5)
+send(': SCR-CELL ( row -- addr ) VGA-COLS * 2 * VGA-BASE + ;', 0.5)
+send(': TILDES ( -- n ) 0 VGA-COLS VGA-ROWS * 0 DO '
+     'VGA-BASE I 2 * + C@ 126 = IF 1+ THEN LOOP ;', 0.5)
+
+# ---- Test 1: dirty-only render ----
+print("\nTest 1: dirty-only render")
+r = send('MK-FORM COUNTING S" Bob" 1 IV-SET FORM-RENDER REPORT', 2)
+n = result_ints(r)
+check('only the edited input\'s row is touched', n[:2] == [5, 5],
+      f'got: {n}')
+# "Bob" over the "Name" placeholder: four cells at most
+check('only the changed characters are written',
+      len(n) == 3 and 0 < n[2] <= 4, f'got: {n}')
+
+# ---- Test 2: shadow comparison ----
+print("\nTest 2: unchanged dirty widget")
+r = send('MK-FORM S" Bob" 1 IV-SET FORM-RENDER '
+         'COUNTING S" Bob" 1 IV-SET FORM-RENDER REPORT', 2)
+n = result_ints(r)
+check('row is touched but no cell is written', n == [5, 5, 0],
+      f'got: {n}')
+
+r = send('MK-FORM COUNTING 2 IV-CLEAR FORM-RENDER REPORT', 2)
+n = result_ints(r)
+check('clearing an empty input writes nothing', n == [8, 8, 0],
+      f'got: {n}')
+
+# ---- Test 3: FORM-INVALIDATE ----
+print("\nTest 3: FORM-INVALIDATE")
+r = send('MK-FORM COUNTING FORM-INVALIDATE FORM-RENDER REPORT', 2)
+n = result_ints(r)
+check('full render touches every row', n[:2] == [0, 24], f'got: {n}')
+check('full render of an unchanged form writes nothing',
+      n[2:] == [0], f'got: {n}')
+
+r = send('MK-FORM 35 20 SCR-CELL C! COUNTING FORM-INVALIDATE FORM-RENDER '
+         '20 SCR-CELL C@ . REPORT', 2)
+n = result_ints(r)
+check('full render repairs a corrupted cell', n[:1] == [32], f'got: {n}')
+check('and writes only that cell', n[3:] == [1], f'got: {n}')
+
+# ---- Test 4: console output ----
+print("\nTest 4: console output over the form")
+send('MK-FORM S" Bob" 1 IV-SET FORM-RENDER', 2)
+r = send('." ~~~~~~~~" TILDES .', 1)
+n = result_ints(r)
+check('console text reaches the screen', n and n[-1] >= 8, f'got: {n}')
+r = send('COUNTING S" Ann" 1 IV-SET FORM-RENDER '
+         '2 SCR-CELL 4 + C@ . 5 SCR-CELL 6 + C@ . '
+         'TILDES . SH-INTACT? . REPORT', 2)
+n = result_ints(r)
+check('label and input are repainted', n[:2] == [ord('R'), ord('A')],
+      f'got: {n}')
+check('console text is cleared', n[2:3] == [0], f'got: {n}')
+check('screen matches the shadow again', n[3:4] == [-1], f'got: {n}')
+check('the render repainted every row', n[4:6] == [0, 24], f'got: {n}')
+
+send('PREVIOUS PREVIOUS', 0.5)
+s.close()
+
+print()
+print(f'Passed: {PASS}/{PASS + FAIL}')
+sys.exit(1 if FAIL else 0)
@@ -9,7 +9,8 @@ Usage:
     python3 tests/test_vga_graphics.py [PORT]
 
 Headless test — verifies words exist and VBE registers
-respond. No actual pixel verification (no display).
+respond. The LFB primitives are checked by reading pixels
+back from the framebuffer.
 """
 import socket
 import time
@@ -199,8 +200,60 @@ check('VGA-LFB is non-zero',
       val is not None and val != 0,
       f'expected non-zero, got {val}')
 
-# ---- Test 6: VGA-TEXT returns to text mode ----
-print("\nTest 6: VGA-TEXT returns to text mode")
+# ---- Test 6: LFB fill/rect/blit/scroll/glyph ----
+print("\nTest 6: LFB primitives")
+r = send('SSE2? .', 1)
+print(f"  SSE2? => {r.strip()!r}")
+
+
+def pixel(x, y):
+    r = send(f'DECIMAL {x} {y} VGA-PADDR @ .', 1)
+    return extract_number(r)
+
+
+send('HEX 123456 VGA-CLEAR DECIMAL', 2)
+check('VGA-CLEAR first pixel', pixel(0, 0) == 0x123456, hex(pixel(0, 0) or 0))
+check('VGA-CLEAR last pixel', pixel(639, 479) == 0x123456)
+send('HEX FF 10 20 30 8 VGA-RECT DECIMAL', 1)
+check('VGA-RECT inside', pixel(0x10 + 0x2F, 0x27) == 0xFF)
+check('VGA-RECT outside', pixel(0x10 + 0x30, 0x27) == 0x123456)
+send('HEX 55AA 2 100 5 VGA-HLINE DECIMAL', 1)
+check('VGA-HLINE end', pixel(6, 0x100) == 0x55AA and
+      pixel(7, 0x100) == 0x123456)
+send('HEX 777 0 28 VGA-PIXEL! A 0 VGA-SCROLL DECIMAL', 2)
+check('VGA-SCROLL moves rows up', pixel(0, 0x1E) == 0x777)
+check('VGA-SCROLL fills bottom', pixel(0, 479) == 0)
+send('HEX CREATE TGF 8 ALLOT TGF 8 0 FILL 81 TGF C! '
+     'TGF VGA-FONT ! FFFFFF VGA-FG ! 1 VGA-BG ! '
+     '0 100 100 VGA-GLYPH FFA6E VGA-FONT ! DECIMAL', 1)
+check('VGA-GLYPH fg/bg pixels',
+      pixel(0x100, 0x100) == 0xFFFFFF and
+      pixel(0x107, 0x100) == 0xFFFFFF and
+      pixel(0x101, 0x100) == 1 and pixel(0x100, 0x101) == 1)
+r = send('DECIMAL TICK-COUNT @ 100 0 DO I VGA-CLEAR LOOP '
+         'TICK-COUNT @ SWAP - .', 8)
+ticks = extract_number(r)
+print(f"  100 x VGA-CLEAR 640x480: {ticks} ticks")
+check('VGA-CLEAR x100 completes', ticks is not None)
+
+# ---- Test 7: Write-combined LFB under paging ----
+print("\nTest 7: VGA-WC (4MB identity paging + PAT)")
+r = send('DECIMAL VGA-WC .', 2)
+val = extract_number(r)
+print(f"  VGA-WC . => {r.strip()!r}")
+check('VGA-WC enables write-combining', val == -1,
+      f'expected -1, got {val}')
+r = send('PAGING @ .', 1)
+check('PAGING set', extract_number(r) == -1, f'got {r.strip()!r}')
+send('HEX 00FF00 20 20 8 8 VGA-RECT', 1)
+check('LFB writes land with paging on',
+      pixel(0x20, 0x20) == 0xFF00 and pixel(0x27, 0x27) == 0xFF00)
+r = send('DECIMAL 1 2 + .', 1)
+check('identity map keeps the system running',
+      extract_number(r) == 3, f'got {r.strip()!r}')
+
+# ---- Test 8: VGA-TEXT returns to text mode ----
+print("\nTest 8: VGA-TEXT returns to text mode")
 r = send('VGA-TEXT', 1)
 r2 = send('DECIMAL 1 2 + .', 1)
 val = extract_number(r2)
@@ -208,8 +261,8 @@ check('VGA-TEXT system responsive',
       val == 3,
       f'expected 3, got {val}')
 
-# ---- Test 7: Stack is clean ----
-print("\nTest 7: Stack is clean")
+# ---- Test 9: Stack is clean ----
+print("\nTest 9: Stack is clean")
 r = send('.S', 1)
 print(f"  .S => {r.strip()!r}")
 check('Stack is clean after all tests',
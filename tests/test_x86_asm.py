@@ -197,8 +197,18 @@ r = send('DECIMAL %ESI .', 1)
 val = extract_number(r)
 check('%ESI = 6', val == 6, f'got {val}')
 
-# ---- Test 7: Stack is clean ----
-print("\nTest 7: Stack is clean")
+# ---- Test 7: LOCK XADD encoding ----
+print("\nTest 7: LOCK, XADD[], assembles F0 0F C1 /r")
+r = send('HEX HERE @ T-HERE !', 1)
+r = send('HEX LOCK, %EAX %EDX XADD[], T-HERE @ 4 - @ DECIMAL .', 1)
+val = extract_number(r)
+print(f"  lock xadd [edx],eax => {r.strip()!r} (parsed: {val})")
+check('lock xadd [edx],eax = F0 0F C1 02',
+      val == 0x02C10FF0,
+      f'expected {0x02C10FF0}, got {val}')
+
+# ---- Test 8: Stack is clean ----
+print("\nTest 8: Stack is clean")
 r = send('.S', 1)
 print(f"  .S => {r.strip()!r}")
 check('Stack is clean after all tests',
@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+"""
+make-snapshot.py — Capture the compiled dictionary of a booted kernel and
+append it to a combined image as a boot snapshot.
+
+Boots the combined image once under QEMU, lets the kernel evaluate its
+embedded vocabulary blob, then dumps the dictionary (0x30000-HERE) and the
+compiler state (LATEST, BASE, search order, vocabulary heads, block
+vectors) through the QEMU monitor. The result is written after the 2MB
+blocks area (block SNAP_BLOCK = 2048):
+
+    Block 2048      Header: magic 'BMFS', version, kernel hash, state,
+                    dictionary block count, replay text
+    Block 2049+     Dictionary image, 0x30000 up to HERE
+
+At boot, snap_restore_ copies the image back instead of re-interpreting the
+source, as long as the kernel hash matches. Any kernel or blob change makes
+the kernel fall back to evaluating the text blob.
+
+Only the dictionary and the system variables are restored. Load-time work
+that lands elsewhere -- hardware probes (PCI-SCAN), which must see the
+machine the kernel boots on, and initializers of fixed or PHYS-ALLOC memory
+(WT-RESET, FE-RESET) -- has to run again. Each vocabulary names those words
+in a `\ REPLAY:` header line; their standalone calls in the embedded
+sources are collected into the header's replay text, which runs after the
+restore.
+
+Usage:
+    python3 tools/make-snapshot.py combined.img output.img file1.fth ...
+    python3 tools/make-snapshot.py --replay AHCI-INIT combined.img out.img ...
+"""
+
+import argparse
+import os
+import re
+import shutil
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+# Must match forth.asm
+COMBINED_HEADER_SIZE = 512 + 0x1C000
+BLOCK_SIZE = 1024
+SNAP_BLOCK = 2048
+SNAP_MAGIC = 0x53464D42
+SNAP_VERSION = 1
+SNAP_OFF_REPLAY = 0x50
+DICT_START = 0x30000
+DICT_SIZE = 0x50000
+SYSVARS = 0x28000
+SYSVARS_SIZE = 0xA4
+
+QEMU = 'qemu-system-i386'
+SERIAL_PORT = 4596
+MONITOR_PORT = 4597
+
+
+def replay_calls(fpath):
+    """Words named on the file's `\\ REPLAY:` header lines."""
+    calls = set()
+    with open(fpath, 'r') as f:
+        for line in f:
+            match = re.match(r'\\\s*REPLAY:\s*(.*)', line)
+            if match:
+                calls.update(match.group(1).split())
+    return calls
+
+
+def replay_text(files, extra):
+    """Collect standalone replay calls as ALSO <vocab> <call> PREVIOUS."""
+    out = []
+    for fpath in files:
+        vocab = None
+        calls = replay_calls(fpath) | extra
+        with open(fpath, 'r') as f:
+            for line in f:
+                words = line.split('\\', 1)[0].split()
+                if len(words) == 2 and words[1] == 'DEFINITIONS':
+                    vocab = words[0]
+                elif len(words) == 1 and words[0] in calls:
+                    if vocab and vocab != 'FORTH':
+                        out.append(f'ALSO {vocab} {words[0]} PREVIOUS')
+                    else:
+                        out.append(words[0])
+    return ' '.join(out)
+
+
+def connect(port):
+    s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    for _ in range(40):
+        try:
+            s.connect(('127.0.0.1', port))
+            return s
+        except (ConnectionRefusedError, OSError):
+            time.sleep(0.5)
+    sys.exit(f'make-snapshot: cannot connect to port {port}')
+
+
+def drain(s, quiet=2.0, limit=60.0):
+    """Read until the line has been quiet for `quiet` seconds."""
+    buf = b''
+    start = last = time.time()
+    s.settimeout(0.2)
+    while time.time() - last < quiet and time.time() - start < limit:
+        try:
+            d = s.recv(4096)
+            if d:
+                buf += d
+                last = time.time()
+        except socket.timeout:
+            pass
+    return buf.decode('ascii', errors='replace')
+
+
+def monitor(m, cmd):
+    m.sendall((cmd + '\n').encode())
+    return drain(m, quiet=0.5)
+
+
+def capture(image):
+    """Boot `image`, return (sysvars bytes, dictionary bytes, kernel hash)."""
+    work = tempfile.mkdtemp(prefix='forthos-snap-')
+    ide = os.path.join(work, 'ide.img')
+    shutil.copy(image, ide)
+    proc = subprocess.Popen(
+        [QEMU, '-drive', f'file={image},format=raw,if=floppy,readonly=on',
+         '-drive', f'file={ide},format=raw,if=ide,index=1',
+         '-serial', f'tcp::{SERIAL_PORT},server=on,wait=off',
+         '-monitor', f'tcp::{MONITOR_PORT},server=on,wait=off',
+         '-display', 'none'],
+        stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    try:
+        s = connect(SERIAL_PORT)
+        m = connect(MONITOR_PORT)
+        drain(m, quiet=0.5)
+        boot = drain(s, quiet=3.0)
+        if 'ok' not in boot:
+            sys.exit('make-snapshot: kernel did not reach the ok prompt')
+
+        # Dump before typing anything so the state is exactly post-boot
+        vars_file = os.path.join(work, 'sysvars.bin')
+        monitor(m, f'pmemsave {SYSVARS:#x} {SYSVARS_SIZE:#x} "{vars_file}"')
+        with open(vars_file, 'rb') as f:
+            sysvars = f.read()
+        if len(sysvars) != SYSVARS_SIZE:
+            sys.exit('make-snapshot: pmemsave of system variables failed')
+        here = struct.unpack_from('<I', sysvars, 4)[0]
+        if not DICT_START <= here <= DICT_START + DICT_SIZE:
+            sys.exit(f'make-snapshot: implausible HERE {here:#x}')
+
+        dict_file = os.path.join(work, 'dict.bin')
+        monitor(m, f'pmemsave {DICT_START:#x} {here - DICT_START:#x} '
+                   f'"{dict_file}"')
+        with open(dict_file, 'rb') as f:
+            dictionary = f.read()
+        if len(dictionary) != here - DICT_START:
+            sys.exit('make-snapshot: pmemsave of dictionary failed')
+
+        s.sendall(b'HEX KERNEL-HASH U. DECIMAL\r')
+        resp = drain(s, quiet=1.0)
+        match = re.search(r'\b([0-9A-Fa-f]{1,8})\s+ok', resp)
+        if not match:
+            sys.exit(f'make-snapshot: no KERNEL-HASH reply: {resp!r}')
+        khash = int(match.group(1), 16)
+        monitor(m, 'quit')
+        return sysvars, dictionary, khash
+    finally:
+        proc.kill()
+        proc.wait()
+        shutil.rmtree(work, ignore_errors=True)
+
+
+def build_header(sysvars, nblocks, khash, replay):
+    def var(addr):
+        return struct.unpack_from('<I', sysvars, addr - SYSVARS)[0]
+
+    hdr = struct.pack('<III', SNAP_MAGIC, SNAP_VERSION, khash)
+    hdr += struct.pack('<III', var(0x28004), var(0x28008), var(0x2800C))
+    hdr += struct.pack('<I', var(0x28040))
+    hdr += struct.pack('<8I', *(var(0x28020 + 4 * i) for i in range(8)))
+    hdr += struct.pack('<II', var(0x28044), var(0x28048))
+    hdr += struct.pack('<II', var(0x2809C), var(0x280A0))
+    hdr += struct.pack('<I', nblocks)
+    assert len(hdr) == SNAP_OFF_REPLAY
+
+    text = replay.encode('ascii')
+    if len(text) > BLOCK_SIZE - SNAP_OFF_REPLAY - 1:
+        sys.exit('make-snapshot: replay text does not fit the header block')
+    return (hdr + text).ljust(BLOCK_SIZE, b'\0')
+
+
+def main():
+    ap = argparse.ArgumentParser(
+        description='Append a dictionary snapshot to a combined image.')
+    ap.add_argument('--replay', action='append', default=[],
+                    help='extra standalone word to re-run after restore')
+    ap.add_argument('image', help='combined image to boot (unchanged)')
+    ap.add_argument('output', help='combined image with snapshot appended')
+    ap.add_argument('sources', nargs='*',
+                    help='embedded .fth files (for the replay text)')
+    args = ap.parse_args()
+
+    replay = replay_text(args.sources, set(args.replay))
+    sysvars, dictionary, khash = capture(args.image)
+    nblocks = (len(dictionary) + BLOCK_SIZE - 1) // BLOCK_SIZE
+    header = build_header(sysvars, nblocks, khash, replay)
+
+    with open(args.image, 'rb') as f:
+        base = f.read()
+    snap_offset = COMBINED_HEADER_SIZE + SNAP_BLOCK * BLOCK_SIZE
+    if len(base) > snap_offset:
+        base = base[:snap_offset]       # Replace an older snapshot
+    with open(args.output, 'wb') as f:
+        f.write(base.ljust(snap_offset, b'\0'))
+        f.write(header)
+        f.write(dictionary.ljust(nblocks * BLOCK_SIZE, b'\0'))
+
+    print(f'Snapshot: {args.output}')
+    print(f'  Kernel hash: {khash:08X}')
+    print(f'  Dictionary:  {len(dictionary)} bytes ({nblocks} blocks)')
+    print(f'  Replay:      {replay or "(none)"}')
+
+
+if __name__ == '__main__':
+    main()
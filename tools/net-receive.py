@@ -5,12 +5,26 @@ Listens for FBLK-framed UDP packets from ForthOS's FILE-STREAM word,
 reassembles chunks into complete files, verifies SHA-256 integrity,
 and writes results to disk.
 
+With --blocks it is instead the host end of NET-DICT's windowed block
+transfer (NET-PUSH). It speaks raw Ethernet (EtherType 0x88B5) on --iface,
+acks every data frame with the next sequence it needs plus a 16-frame
+selective-ack bitmap, and writes the blocks into a block image through
+write-block.py. Opening a raw socket needs root or CAP_NET_RAW.
+
+With --trace it decodes a capture of ECHOPORT's binary stream (ECHOPORT-STREAM,
+e.g. QEMU's second serial port as -serial file:trace.bin): one JSON line per
+port access, then a per-port summary for each session.
+
 Usage:
     python3 net-receive.py [--port 6666] [--outdir ./extracted/] [--verbose]
+    python3 net-receive.py --blocks build/blocks.img --iface tap0 [--verbose]
+    python3 net-receive.py --trace trace.bin [--verbose]
 
 Protocol:
     See docs/2026-04-28-substrate-design.md for the framing specification.
     24-byte common header on all packets, 256-byte filename in chunk 0 only.
+    Block frames: see the "Windowed transfer" section of forth/dict/net-dict.fth.
+    Trace stream: see the header of forth/dict/echoport.fth.
 """
 
 import argparse
@@ -22,6 +36,7 @@ import struct
 import sys
 import time
 from dataclasses import dataclass, field
+from importlib.machinery import SourceFileLoader
 from pathlib import Path
 
 
@@ -41,6 +56,26 @@ FLAG_SPARSE = 0x0002
 HEADER_FMT = ">IIIIHH"
 HEADER_STRUCT = struct.Struct(HEADER_FMT)
 
+# NET-DICT raw Ethernet frames (must match net-dict.fth)
+NETDICT_ETHERTYPE = 0x88B5
+NETDICT_HDR = struct.Struct(">6s6sHHHHH")   # dst src type cmd blk off plen
+NETDICT_HDR_SIZE = NETDICT_HDR.size         # 22 (FRM-HDR)
+NETDICT_FRAME_MIN = 60                      # FRM-MIN
+NETDICT_BLOCK = 1024
+CMD_WDATA = 4
+CMD_WACK = 5
+CMD_WSTART = 6
+CMD_WEND = 7
+NETDICT_WINDOW = 16                         # frames the SACK bitmap covers
+
+# ECHOPORT trace stream (must match echoport.fth and TRACE_ENTRY_SZ)
+TRACE_MAGIC = b"EPTR"
+TRACE_VERSION = 1
+TRACE_HDR = struct.Struct("<4sBBHI")        # magic ver entry-size 0 khz
+TRACE_ENTRY = struct.Struct("<BBHIII")      # type 0 port value caller tsc
+TRACE_TYPES = ["INB", "OUTB", "INW", "OUTW", "INL", "OUTL",
+               "INSB", "OUTSB", "INSW", "OUTSW", "INSD", "OUTSD"]
+
 
 # ---------------------------------------------------------------------------
 # Data structures
@@ -315,6 +350,215 @@ def _expire_stale(sessions: dict, outdir: Path, timeout: float, verbose: bool):
         del sessions[sid]
 
 
+# ---------------------------------------------------------------------------
+# NET-DICT windowed block receiver (raw Ethernet)
+# ---------------------------------------------------------------------------
+
+def load_write_block():
+    """Import tools/write-block.py (hyphenated, so not a normal import)."""
+    path = Path(__file__).resolve().parent / "write-block.py"
+    return SourceFileLoader("write_block", str(path)).load_module()
+
+
+def parse_netdict(frame: bytes) -> dict | None:
+    """Split a NET-DICT frame into header fields and payload."""
+    if len(frame) < NETDICT_HDR_SIZE:
+        return None
+    dst, src, etype, cmd, blk, off, plen = NETDICT_HDR.unpack_from(frame, 0)
+    if etype != NETDICT_ETHERTYPE:
+        return None
+    return {"src": src, "cmd": cmd, "blk": blk, "off": off,
+            "payload": frame[NETDICT_HDR_SIZE:NETDICT_HDR_SIZE + plen]}
+
+
+def build_ack(dst: bytes, src: bytes, next_seq: int, sack: int) -> bytes:
+    """WACK: off = next sequence needed, blk = bitmap of the 16 after it."""
+    frame = NETDICT_HDR.pack(dst, src, NETDICT_ETHERTYPE, CMD_WACK,
+                             sack & 0xFFFF, next_seq & 0xFFFF, 0)
+    return frame.ljust(NETDICT_FRAME_MIN, b"\x00")
+
+
+@dataclass
+class BlockPull:
+    """Receiver window for one NET-PUSH transfer."""
+    first: int = 0
+    total: int = 0
+    expect: int = 0                                   # next seq needed
+    held: set = field(default_factory=set)            # seqs > expect received
+    blocks: int = 0
+    start_time: float = field(default_factory=time.time)
+
+    def sack(self) -> int:
+        bits = 0
+        for seq in self.held:
+            i = seq - self.expect - 1
+            if 0 <= i < NETDICT_WINDOW:
+                bits |= 1 << i
+        return bits
+
+    def accept(self, seq: int) -> bool:
+        """Record seq; True if it is new and inside the window."""
+        if seq < self.expect or seq >= self.expect + NETDICT_WINDOW:
+            return False
+        if seq == self.expect:
+            self.expect += 1
+            while self.expect in self.held:
+                self.held.discard(self.expect)
+                self.expect += 1
+            return True
+        if seq in self.held:
+            return False
+        self.held.add(seq)
+        return True
+
+
+def run_block_receiver(iface: str, image: Path, timeout: float, verbose: bool):
+    """Receive one NET-PUSH transfer into a block image."""
+    wb = load_write_block()
+    sock = socket.socket(socket.AF_PACKET, socket.SOCK_RAW,
+                         socket.htons(NETDICT_ETHERTYPE))
+    sock.bind((iface, 0))
+    sock.settimeout(timeout)
+    our_mac = sock.getsockname()[4][:6]
+    pull = None
+
+    print(f"Waiting for NET-PUSH on {iface}, writing to {image}",
+          file=sys.stderr)
+    try:
+        while True:
+            try:
+                frame = sock.recv(65535)
+            except socket.timeout:
+                break
+            f = parse_netdict(frame)
+            if f is None:
+                continue
+            if f["cmd"] == CMD_WSTART:
+                if pull is None or (pull.first, pull.total) != (f["blk"], f["off"]):
+                    pull = BlockPull(first=f["blk"], total=f["off"])
+                    if verbose:
+                        print(f"  [start] blocks from {pull.first}, "
+                              f"{pull.total} frames", file=sys.stderr)
+            elif pull is None:
+                continue
+            elif f["cmd"] == CMD_WDATA:
+                if pull.accept(f["off"]):
+                    data = f["payload"]
+                    nblk = len(data) // NETDICT_BLOCK
+                    if nblk:
+                        wb.write_blocks(str(image), f["blk"],
+                                        wb.data_to_blocks(
+                                            data[:nblk * NETDICT_BLOCK]))
+                    pull.blocks += nblk
+                    if verbose:
+                        print(f"  [data] seq {f['off']} block {f['blk']}"
+                              f" x{nblk}", file=sys.stderr)
+            elif f["cmd"] != CMD_WEND:
+                continue
+            sock.send(build_ack(f["src"], our_mac, pull.expect, pull.sack()))
+            if f["cmd"] == CMD_WEND and pull.expect >= pull.total:
+                break
+    finally:
+        sock.close()
+
+    complete = pull is not None and pull.expect >= pull.total
+    log_entry = {
+        "image": str(image),
+        "first_block": pull.first if pull else None,
+        "blocks": pull.blocks if pull else 0,
+        "frames": pull.total if pull else 0,
+        "status": "complete" if complete else "incomplete",
+        "duration_ms": int((time.time() - pull.start_time) * 1000) if pull else 0,
+    }
+    print(json.dumps(log_entry), flush=True)
+    return complete
+
+
+# ---------------------------------------------------------------------------
+# ECHOPORT trace stream decoder
+# ---------------------------------------------------------------------------
+
+def _trace_header(data: bytes, pos: int) -> dict | None:
+    """Session header at pos, or None."""
+    if len(data) - pos < TRACE_HDR.size:
+        return None
+    magic, ver, size, _, khz = TRACE_HDR.unpack_from(data, pos)
+    if magic != TRACE_MAGIC or ver != TRACE_VERSION or size != TRACE_ENTRY.size:
+        return None
+    return {"khz": khz, "records": []}
+
+
+def parse_trace(data: bytes) -> list[dict]:
+    """Split a capture into sessions of decoded records.
+
+    Bytes before the first header are skipped. Within a session, records
+    follow each other at 16-byte steps; a new header can only start on a
+    record boundary (no record starts with 'E', there are 12 types). The
+    32-bit TSC stamps are unwrapped into microseconds from the first
+    record when the header carries the TSC rate.
+    """
+    sessions = []
+    pos = data.find(TRACE_MAGIC)
+    while pos >= 0:
+        cur = _trace_header(data, pos)
+        if cur is None:
+            pos = data.find(TRACE_MAGIC, pos + 1)
+            continue
+        sessions.append(cur)
+        pos += TRACE_HDR.size
+        t0 = last = None
+        high = 0
+        while len(data) - pos >= TRACE_ENTRY.size:
+            if _trace_header(data, pos) is not None:
+                break
+            kind, _, port, value, caller, tsc = TRACE_ENTRY.unpack_from(data, pos)
+            pos += TRACE_ENTRY.size
+            if last is not None and tsc < last:
+                high += 1 << 32
+            last = tsc
+            tsc += high
+            if t0 is None:
+                t0 = tsc
+            us = (tsc - t0) * 1000 // cur["khz"] if cur["khz"] else None
+            cur["records"].append({
+                "type": TRACE_TYPES[kind] if kind < len(TRACE_TYPES) else kind,
+                "port": port,
+                "value": value,
+                "caller": caller,
+                "us": us,
+            })
+        else:
+            break
+    return sessions
+
+
+def trace_summary(records: list[dict]) -> dict:
+    """Per-port in/out counts, like ECHOPORT-SUMMARY."""
+    ports = {}
+    for r in records:
+        p = ports.setdefault(f"0x{r['port']:04X}", {"in": 0, "out": 0})
+        kind = r["type"]
+        out = kind.startswith("OUT") if isinstance(kind, str) else kind & 1
+        p["out" if out else "in"] += 1
+    return ports
+
+
+def run_trace(path: Path, verbose: bool) -> bool:
+    """Decode an ECHOPORT capture; False when it holds no session."""
+    sessions = parse_trace(path.read_bytes())
+    for n, sess in enumerate(sessions):
+        if verbose:
+            for r in sess["records"]:
+                print(json.dumps({"session": n, **r}), flush=True)
+        print(json.dumps({"session": n, "khz": sess["khz"],
+                          "records": len(sess["records"]),
+                          "ports": trace_summary(sess["records"])}),
+              flush=True)
+    if not sessions:
+        print(f"No ECHOPORT session in {path}", file=sys.stderr)
+    return bool(sessions)
+
+
 # ---------------------------------------------------------------------------
 # CLI
 # ---------------------------------------------------------------------------
@@ -331,8 +575,21 @@ def main():
                         help="Stale session timeout in seconds (default: 30)")
     parser.add_argument("--verbose", action="store_true",
                         help="Print chunk-level progress to stderr")
+    parser.add_argument("--blocks", type=Path, metavar="IMAGE",
+                        help="Receive a NET-PUSH block transfer into IMAGE")
+    parser.add_argument("--iface", default="tap0",
+                        help="Interface for --blocks (default: tap0)")
+    parser.add_argument("--trace", type=Path, metavar="CAPTURE",
+                        help="Decode an ECHOPORT-STREAM capture")
     args = parser.parse_args()
 
+    if args.trace:
+        sys.exit(0 if run_trace(args.trace, args.verbose) else 1)
+
+    if args.blocks:
+        ok = run_block_receiver(args.iface, args.blocks, args.timeout,
+                                args.verbose)
+        sys.exit(0 if ok else 1)
     run_receiver(args.port, args.outdir, args.timeout, args.verbose)
 
 
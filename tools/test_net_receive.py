@@ -266,3 +266,44 @@ class TestEofFlag:
             assert log_entry["status"] == "complete"
             assert log_entry["gaps"] == []
             assert log_entry["sha256"] is not None
+
+
+class TestTraceStream:
+    @staticmethod
+    def trace(khz, records):
+        out = net_receive.TRACE_HDR.pack(b"EPTR", 1, 16, 0, khz)
+        for kind, port, value, tsc in records:
+            out += net_receive.TRACE_ENTRY.pack(kind, 0, port, value,
+                                                0x31000, tsc)
+        return out
+
+    def test_records_and_summary(self):
+        """Records decode in order; summary counts in and out per port."""
+        data = b"junk" + self.trace(1000, [(0, 0x20, 0x11, 5000),
+                                           (1, 0x20, 0x0B, 6000),
+                                           (8, 0x1F0, 256, 8000)])
+        sessions = net_receive.parse_trace(data)
+        assert len(sessions) == 1
+        recs = sessions[0]["records"]
+        assert [r["type"] for r in recs] == ["INB", "OUTB", "INSW"]
+        assert recs[2]["value"] == 256
+        assert [r["us"] for r in recs] == [0, 1000, 3000]
+        ports = net_receive.trace_summary(recs)
+        assert ports["0x0020"] == {"in": 1, "out": 1}
+        assert ports["0x01F0"] == {"in": 1, "out": 0}
+
+    def test_tsc_wrap_and_sessions(self):
+        """A second header starts a session; the 32-bit TSC unwraps."""
+        data = (self.trace(1000, [(0, 0x60, 0, 0xFFFFF000),
+                                  (0, 0x60, 0, 0x00000800)])
+                + self.trace(0, [(5, 0xCF8, 0x80000000, 7)]))
+        sessions = net_receive.parse_trace(data)
+        assert len(sessions) == 2
+        assert sessions[0]["records"][1]["us"] == 0x1800 * 1000 // 1000
+        assert sessions[1]["records"][0]["type"] == "OUTL"
+        assert sessions[1]["records"][0]["us"] is None
+
+    def test_truncated_record_ignored(self):
+        """A partial record at the end of a capture is dropped."""
+        data = self.trace(1000, [(0, 0x20, 0, 1)])[:-3]
+        assert net_receive.parse_trace(data)[0]["records"] == []
@@ -31,6 +31,7 @@ PUB_YES = [
     "forth/dict/ne2000.fth",
     "forth/dict/net-dict.fth",
     "forth/dict/rtl8139.fth",
+    "forth/dict/pkt-ring.fth",
     "forth/dict/serial-16550.fth",
     "forth/dict/ps2-keyboard.fth",
     "forth/dict/ps2-mouse.fth",
@@ -8,6 +8,7 @@ block number in the disk image.
 
 Usage:
     python3 tools/write-block.py <disk-image> <block#> <source-file>
+    python3 tools/write-block.py --raw <disk-image> <block#> <binary-file>
 
 Examples:
     python3 tools/write-block.py build/blocks.img 0 forth/dict/myfile.fth
@@ -18,6 +19,9 @@ The source file is converted to screen format:
 - Lines shorter than 64 chars are padded with spaces
 - Missing lines (fewer than 16) are filled with spaces
 - The result is exactly 1024 bytes written at offset block# * 1024
+
+With --raw the file is copied as-is, split into 1024-byte blocks and
+zero-padded (block images pulled over the network, see net-receive.py).
 """
 
 import sys
@@ -71,6 +75,30 @@ def source_to_blocks(source_text):
     return blocks
 
 
+def data_to_blocks(data):
+    """Split raw bytes into 1024-byte blocks, zero-padding the last one."""
+    return [bytes(data[i:i + BLOCK_SIZE]).ljust(BLOCK_SIZE, b'\0')
+            for i in range(0, max(len(data), 1), BLOCK_SIZE)]
+
+
+def write_blocks(disk_image, block_num, block_list):
+    """Write 1024-byte blocks into a disk image starting at block_num.
+
+    Raises ValueError if the range does not fit the image.
+    """
+    if block_num < 0:
+        raise ValueError(f"block number must be >= 0 (got {block_num})")
+    image_size = os.path.getsize(disk_image)
+    last_offset = (block_num + len(block_list)) * BLOCK_SIZE
+    if last_offset > image_size:
+        raise ValueError(f"blocks {block_num}-{block_num + len(block_list) - 1} "
+                         f"exceed image size {image_size}")
+    with open(disk_image, 'r+b') as f:
+        for i, block_data in enumerate(block_list):
+            f.seek((block_num + i) * BLOCK_SIZE)
+            f.write(block_data)
+
+
 def blocks_needed(source_text):
     """Return how many blocks a source file needs."""
     lines = source_text.splitlines()
@@ -78,57 +106,53 @@ def blocks_needed(source_text):
 
 
 def main():
-    if len(sys.argv) < 3:
+    args = sys.argv[1:]
+    raw = '--raw' in args
+    if raw:
+        args.remove('--raw')
+    if len(args) < 2:
         print(__doc__)
         sys.exit(1)
 
-    disk_image = sys.argv[1]
-    block_num = int(sys.argv[2])
+    disk_image = args[0]
+    block_num = int(args[1])
+    source_file = args[2] if len(args) >= 3 and args[2] != '-' else None
 
-    if len(sys.argv) >= 4 and sys.argv[3] != '-':
-        source_file = sys.argv[3]
-        with open(source_file, 'r') as f:
-            source_text = f.read()
+    if raw:
+        if source_file:
+            with open(source_file, 'rb') as f:
+                data = f.read()
+        else:
+            data = sys.stdin.buffer.read()
+        block_list = data_to_blocks(data)
     else:
-        source_text = sys.stdin.read()
-
-    # Validate
-    if block_num < 0:
-        print(f"Error: block number must be >= 0 (got {block_num})", file=sys.stderr)
-        sys.exit(1)
-
-    image_size = os.path.getsize(disk_image)
-    offset = block_num * BLOCK_SIZE
-
-    if offset + BLOCK_SIZE > image_size:
-        print(f"Error: block {block_num} (offset {offset}) exceeds image size {image_size}",
-              file=sys.stderr)
-        sys.exit(1)
-
-    # Convert to blocks (may span multiple blocks for long files)
-    block_list = source_to_blocks(source_text)
-    num_blocks = len(block_list)
-
-    # Check all blocks fit
-    last_offset = (block_num + num_blocks - 1) * BLOCK_SIZE + BLOCK_SIZE
-    if last_offset > image_size:
-        print(f"Error: blocks {block_num}-{block_num + num_blocks - 1} "
-              f"exceed image size {image_size}", file=sys.stderr)
+        if source_file:
+            with open(source_file, 'r') as f:
+                source_text = f.read()
+        else:
+            source_text = sys.stdin.read()
+        # Convert to blocks (may span multiple blocks for long files)
+        block_list = source_to_blocks(source_text)
+
+    try:
+        write_blocks(disk_image, block_num, block_list)
+    except ValueError as e:
+        print(f"Error: {e}", file=sys.stderr)
         sys.exit(1)
 
-    with open(disk_image, 'r+b') as f:
-        for i, block_data in enumerate(block_list):
-            f.seek((block_num + i) * BLOCK_SIZE)
-            f.write(block_data)
-
     # Summary
-    lines = source_text.splitlines()
+    num_blocks = len(block_list)
+    offset = block_num * BLOCK_SIZE
     if num_blocks == 1:
         print(f"Wrote block {block_num} to {disk_image}")
     else:
         print(f"Wrote blocks {block_num}-{block_num + num_blocks - 1} "
               f"({num_blocks} blocks) to {disk_image}")
-    print(f"  Source: {len(lines)} lines, {len(source_text)} bytes")
+    if raw:
+        print(f"  Source: {len(data)} bytes (raw)")
+    else:
+        print(f"  Source: {len(source_text.splitlines())} lines, "
+              f"{len(source_text)} bytes")
     print(f"  Block offset: {offset} (0x{offset:X})")
 
 